@@ -22,6 +22,7 @@
 #include "khash.h"
 #include "SR_Error.h"
 #include "SR_Utilities.h"
+#include "SR_NameTable.h"
 #include "SR_BamInStream.h"
 
 
@@ -67,9 +68,6 @@ enum AlignmentStatus
     GOOD_MULTIPLE  = 3,     // a good multiple aligned candidate
 };
 
-// initialize a string-to-bam hash table used to retrieve a pair of read
-KHASH_MAP_INIT_STR(queryName, SR_BamNode*);
-
 KHASH_SET_INIT_INT64(buffAddress);
 
 
@@ -77,33 +75,103 @@ KHASH_SET_INIT_INT64(buffAddress);
 // Static functions
 //===================
 
+// move the oldest alignments waiting for their mates into the spill to make room in the memory pool
+static unsigned int SR_BamInStreamSpill(SR_BamInStream* pBamInStream)
+{
+    if (pBamInStream->pBamSpill == NULL)
+    {
+        pBamInStream->pBamSpill = SR_BamSpillAlloc();
+        SR_ErrMsg("WARNING: Too many unpaired reads are stored in the memory. The oldest ones will be moved to temporary files.\n");
+    }
+
+    // free one buffer's worth of nodes at a time. the new alignments are
+    // pushed at the head of the lists so the oldest ones are at the tail
+    unsigned int numSpilled = 0;
+    for (unsigned int i = PREV_BIN; i <= CURR_BIN; ++i)
+    {
+        SR_BamList* pAlgnList = pBamInStream->pAlgnLists + i;
+        SR_NameTable* pNameHash = pBamInStream->pNameHashes[i];
+
+        while (pAlgnList->last != NULL && numSpilled != pBamInStream->pMemPool->buffCapacity)
+        {
+            SR_BamNode* pOldNode = pAlgnList->last;
+            const char* queryName = bam1_qname(&(pOldNode->alignment));
+            uint64_t fingerprint = SR_NameTableFingerprint(queryName);
+
+            SR_NameTableTake(pNameHash, fingerprint, queryName);
+            SR_BamSpillPut(pBamInStream->pBamSpill, fingerprint, &(pOldNode->alignment));
+
+            SR_BamListRemove(pAlgnList, pOldNode);
+            SR_BamNodeFree(pOldNode, pBamInStream->pMemPool);
+            ++numSpilled;
+        }
+    }
+
+    return numSpilled;
+}
+
 static inline int SR_BamInStreamLoadNext(SR_BamInStream* pBamInStream)
 {
     // for the bam alignment array, if we need to expand its space
     // we have to initialize those newly created bam alignment 
     // and update the query name hash since the address of those
     // bam alignments are changed after expanding
+
+    // the first alignment of a chromosome is left by "SR_BamInStreamJump"
+    if (pBamInStream->pNewNode != NULL)
+        return 1;
+
     pBamInStream->pNewNode = SR_BamNodeAlloc(pBamInStream->pMemPool);
+    if (pBamInStream->pNewNode == NULL && SR_BamInStreamSpill(pBamInStream) != 0)
+        pBamInStream->pNewNode = SR_BamNodeAlloc(pBamInStream->pMemPool);
+
     if (pBamInStream->pNewNode == NULL)
         SR_ErrQuit("ERROR: Too many unpaired reads are stored in the memory. Please use smaller bin size or disable searching pair genomically.\n");
 
-    int ret = bam_read1(pBamInStream->fpBamInput, &(pBamInStream->pNewNode->alignment));
+    if (pBamInStream->coreFilterFunc == NULL && pBamInStream->projection == SR_PROJECT_ALL)
+        return SR_BamNodeRead(pBamInStream->fpBamInput, pBamInStream->pNewNode, pBamInStream->pMemPool);
+
+    // check the core of an alignment before decoding the rest of it.
+    // the skipped alignments never leave the bgzf buffer
+    bam1_t* pAlignment = &(pBamInStream->pNewNode->alignment);
+    int ret = 0;
+    while ((ret = bam_read1_core(pBamInStream->fpBamInput, pAlignment)) > 0)
+    {
+        if (pBamInStream->coreFilterFunc == NULL
+            || pBamInStream->coreFilterFunc(&(pAlignment->core), pBamInStream->filterData, 
+                                            pBamInStream->currRefID, pBamInStream->currBinPos) != STREAM_PASS)
+        {
+            int isBorrowed = SR_BamNodeInSlab(pBamInStream->pNewNode, pBamInStream->pMemPool->buffCapacity);
+            int dataRet = bam_read1_data(pBamInStream->fpBamInput, pAlignment, isBorrowed, pBamInStream->projection);
+
+            return (dataRet < 0 ? dataRet : ret + dataRet);
+        }
+
+        if (bam_skip1_data(pBamInStream->fpBamInput, pAlignment) < 0)
+            return -4;
+    }
 
     return ret;
 }
 
 static void SR_BamInStreamReset(SR_BamInStream* pBamInStream)
 {
+    if (pBamInStream->pNewNode != NULL)
+        SR_BamNodeFree(pBamInStream->pNewNode, pBamInStream->pMemPool);
+
     pBamInStream->pNewNode = NULL;
 
     pBamInStream->currBinPos = NO_QUERY_YET;
     pBamInStream->currRefID = NO_QUERY_YET;
 
-    kh_clear(queryName, pBamInStream->pNameHashes[PREV_BIN]);
-    kh_clear(queryName, pBamInStream->pNameHashes[CURR_BIN]);
+    SR_NameTableClear(pBamInStream->pNameHashes[PREV_BIN]);
+    SR_NameTableClear(pBamInStream->pNameHashes[CURR_BIN]);
 
     SR_BamListReset(&(pBamInStream->pAlgnLists[PREV_BIN]), pBamInStream->pMemPool);
     SR_BamListReset(&(pBamInStream->pAlgnLists[CURR_BIN]), pBamInStream->pMemPool);
+
+    if (pBamInStream->pBamSpill != NULL)
+        SR_BamSpillClear(pBamInStream->pBamSpill, pBamInStream->pMemPool);
 }
 
 static double SR_GetMismatchRate(const bam1_t* pAlignment)
@@ -180,6 +248,8 @@ SR_BamInStream* SR_BamInStreamAlloc( uint32_t binLen, unsigned int numThreads, u
     pBamInStream->pBamIndex = NULL;
 
     pBamInStream->filterFunc = pStreamMode->filterFunc;
+    pBamInStream->coreFilterFunc = pStreamMode->coreFilterFunc;
+    pBamInStream->projection = pStreamMode->projection;
     pBamInStream->filterData = pStreamMode->filterData;
     pBamInStream->controlFlag = pStreamMode->controlFlag;
 
@@ -190,6 +260,8 @@ SR_BamInStream* SR_BamInStreamAlloc( uint32_t binLen, unsigned int numThreads, u
     pBamInStream->currBinPos = NO_QUERY_YET;
     pBamInStream->binLen = binLen;
     pBamInStream->pNewNode = NULL;
+    pBamInStream->pBamSpill = NULL;
+    pBamInStream->spillStatus = SR_OK;
 
     if (numThreads > 0)
     {
@@ -208,13 +280,8 @@ SR_BamInStream* SR_BamInStreamAlloc( uint32_t binLen, unsigned int numThreads, u
         pBamInStream->reportSize = 0;
     }
 
-    pBamInStream->pNameHashes[PREV_BIN] = kh_init(queryName);
-    if (pBamInStream->reportSize > 0)
-        kh_resize(queryName, pBamInStream->pNameHashes[PREV_BIN], reportSize);
-
-    pBamInStream->pNameHashes[CURR_BIN] = kh_init(queryName);
-    if (pBamInStream->reportSize > 0)
-        kh_resize(queryName, pBamInStream->pNameHashes[CURR_BIN], reportSize);
+    pBamInStream->pNameHashes[PREV_BIN] = SR_NameTableAlloc(pBamInStream->reportSize);
+    pBamInStream->pNameHashes[CURR_BIN] = SR_NameTableAlloc(pBamInStream->reportSize);
 
     pBamInStream->pMemPool = SR_BamMemPoolAlloc(buffCapacity);
 
@@ -225,8 +292,10 @@ void SR_BamInStreamFree(SR_BamInStream* pBamInStream)
 {
     if (pBamInStream != NULL)
     {
-        kh_destroy(queryName, pBamInStream->pNameHashes[PREV_BIN]);
-        kh_destroy(queryName, pBamInStream->pNameHashes[CURR_BIN]);
+        SR_NameTableFree(pBamInStream->pNameHashes[PREV_BIN]);
+        SR_NameTableFree(pBamInStream->pNameHashes[CURR_BIN]);
+
+        SR_BamSpillFree(pBamInStream->pBamSpill, pBamInStream->pMemPool);
 
         free(pBamInStream->pRetLists);
         free(pBamInStream->pAlgnTypes);
@@ -270,6 +339,10 @@ SR_Status SR_BamInStreamOpen(SR_BamInStream* pBamInStream, const char* bamFilena
         return SR_ERR;
     }
 
+    // inflate the bgzf blocks on the worker threads. the stream falls back to a single thread on failure
+    if (pBamInStream->numThreads > 1)
+        bgzf_set_threads(pBamInStream->fpBamInput, pBamInStream->numThreads);
+
     if ((pBamInStream->controlFlag & SR_USE_BAM_INDEX) != 0)
     {
         pBamInStream->pBamIndex = bam_index_load(bamFilename);
@@ -286,6 +359,9 @@ SR_Status SR_BamInStreamOpen(SR_BamInStream* pBamInStream, const char* bamFilena
 // clear the bam instream object(return list, alignment list and name hash)
 void SR_BamInStreamClear(SR_BamInStream* pBamInStream)
 {
+    if (pBamInStream->pNewNode != NULL)
+        SR_BamNodeFree(pBamInStream->pNewNode, pBamInStream->pMemPool);
+
     pBamInStream->pNewNode = NULL;
     pBamInStream->currRefID = NO_QUERY_YET;
     pBamInStream->currBinPos = NO_QUERY_YET;
@@ -296,8 +372,11 @@ void SR_BamInStreamClear(SR_BamInStream* pBamInStream)
     for (unsigned int i = 0; i != 2; ++i)
         SR_BamListReset(pBamInStream->pAlgnLists + i, pBamInStream->pMemPool);
 
-    kh_clear(queryName, pBamInStream->pNameHashes[PREV_BIN]);
-    kh_clear(queryName, pBamInStream->pNameHashes[CURR_BIN]);
+    SR_NameTableClear(pBamInStream->pNameHashes[PREV_BIN]);
+    SR_NameTableClear(pBamInStream->pNameHashes[CURR_BIN]);
+
+    if (pBamInStream->pBamSpill != NULL)
+        SR_BamSpillClear(pBamInStream->pBamSpill, pBamInStream->pMemPool);
 }
 
 // close the current bam files and clear the bam instream
@@ -317,6 +396,11 @@ void SR_BamInStreamClose(SR_BamInStream* pBamInStream)
 
 // jump to a certain chromosome in a bam file
 SR_Status SR_BamInStreamJump(SR_BamInStream* pBamInStream, int32_t refID)
+{
+    return SR_BamInStreamJumpTo(pBamInStream, refID, 0);
+}
+
+SR_Status SR_BamInStreamJumpTo(SR_BamInStream* pBamInStream, int32_t refID, int32_t pos)
 {
     // if we do not have the index file return error
     if (pBamInStream->pBamIndex == NULL)
@@ -327,56 +411,35 @@ SR_Status SR_BamInStreamJump(SR_BamInStream* pBamInStream, int32_t refID)
 
     // jump and read the first alignment in the given chromosome
     int ret;
-    bam_iter_t pBamIter = bam_iter_query(pBamInStream->pBamIndex, refID, 0, INT_MAX);
+    bam_iter_t pBamIter = bam_iter_query(pBamInStream->pBamIndex, refID, pos, INT_MAX);
 
     pBamInStream->pNewNode = SR_BamNodeAlloc(pBamInStream->pMemPool);
-    ret = bam_iter_read(pBamInStream->fpBamInput, pBamIter, &(pBamInStream->pNewNode->alignment));
-    bam_iter_destroy(pBamIter);
+    if (pBamInStream->pNewNode == NULL)
+        SR_ErrQuit("ERROR: Too many unpaired reads are stored in the memory. Please use smaller bin size or disable searching pair genomically.\n");
 
-    khash_t(queryName)* pNameHashCurr = NULL;
+    ret = bam_iter_read_ext(pBamInStream->fpBamInput, pBamIter, &(pBamInStream->pNewNode->alignment),
+                            SR_BamNodeInSlab(pBamInStream->pNewNode, pBamInStream->pMemPool->buffCapacity), 0);
+    bam_iter_destroy(pBamIter);
 
-    // see if we jump to the desired chromosome
+    // see if we jump to the desired chromosome. the first alignment is left in the
+    // stream so that "SR_BamInStreamLoadPair" filters and pairs it like any other one.
+    // the chromosome is set right away so that its end is seen even if none of its
+    // alignments is kept
     if (ret > 0 && pBamInStream->pNewNode->alignment.core.tid == refID)
     {
-        // exclude those reads who are non-paired-end, qc-fail, duplicate-marked, proper-paired, 
-        // both aligned, secondary-alignment and no-name-specified.
-        if ((pBamInStream->pNewNode->alignment.core.flag & SR_BAM_FMASK) != 0
-            || strcmp(bam1_qname(&(pBamInStream->pNewNode->alignment)), "*") == 0)
-        {
-            SR_BamNodeFree(pBamInStream->pNewNode, pBamInStream->pMemPool);
-            pBamInStream->pNewNode = NULL;
-            pBamInStream->currBinPos = NO_QUERY_YET;
-        }
-        else
-        {
-            SR_BamListPushHead(&(pBamInStream->pAlgnLists[CURR_BIN]), pBamInStream->pNewNode);
-
-            int khRet = 0;
-            khiter_t khIter = kh_put(queryName, pBamInStream->pNameHashes[CURR_BIN], bam1_qname(&(pBamInStream->pNewNode->alignment)), &khRet);
-
-            if (khRet != 0)
-            {
-                pNameHashCurr = pBamInStream->pNameHashes[CURR_BIN];
-                kh_value(pNameHashCurr, khIter) = pBamInStream->pNewNode;
-            }
-            else
-                return SR_ERR;
-
-            pBamInStream->currBinPos = pBamInStream->pNewNode->alignment.core.pos; 
-            pBamInStream->pNewNode = NULL;
-        }
-
         pBamInStream->currRefID = refID;
+        pBamInStream->currBinPos = NO_QUERY_YET;
+
         return SR_OK;
     }
-    else if (ret == -1)
-    {
+
+    SR_BamNodeFree(pBamInStream->pNewNode, pBamInStream->pMemPool);
+    pBamInStream->pNewNode = NULL;
+
+    if (ret == -1)
         return SR_OUT_OF_RANGE;
-    }
     else
-    {
         return SR_ERR;
-    }
 }
 
 // read the header of a bam file
@@ -419,12 +482,44 @@ SR_Status SR_BamInStreamLoadPair(SR_BamNode** ppUpAlgn, SR_BamNode** ppDownAlgn,
     (*ppUpAlgn) = NULL;
     (*ppDownAlgn) = NULL;
 
-    khash_t(queryName)* pNameHashPrev = pBamInStream->pNameHashes[PREV_BIN];
-    khash_t(queryName)* pNameHashCurr = pBamInStream->pNameHashes[CURR_BIN];
+    // the pairs in the spill are returned before the end of the chromosome is reported
+    if (pBamInStream->pBamSpill != NULL && SR_BamSpillIsMerging(pBamInStream->pBamSpill))
+    {
+        if (SR_BamSpillLoadPair(ppUpAlgn, ppDownAlgn, pBamInStream->pBamSpill, pBamInStream->pMemPool) == SR_OK)
+            return SR_OK;
+
+        return pBamInStream->spillStatus;
+    }
+
+    SR_NameTable* pNameHashPrev = pBamInStream->pNameHashes[PREV_BIN];
+    SR_NameTable* pNameHashCurr = pBamInStream->pNameHashes[CURR_BIN];
 
     int ret = 1;
     while(ret > 0 && (ret = SR_BamInStreamLoadNext(pBamInStream)) > 0)
     {
+        // the first alignment of the next chromosome is left in the stream. it goes
+        // through the filter in the next call, with the bin of its own chromosome
+        if (pBamInStream->pNewNode->alignment.core.tid != pBamInStream->currRefID
+            && pBamInStream->currRefID != NO_QUERY_YET)
+        {
+            pBamInStream->currRefID  = NO_QUERY_YET;
+            pBamInStream->currBinPos = NO_QUERY_YET;
+
+            SR_NameTableClear(pNameHashPrev);
+            SR_NameTableClear(pNameHashCurr);
+
+            SR_BamListReset(&(pBamInStream->pAlgnLists[PREV_BIN]), pBamInStream->pMemPool);
+            SR_BamListReset(&(pBamInStream->pAlgnLists[CURR_BIN]), pBamInStream->pMemPool);
+
+            ret = SR_OUT_OF_RANGE;
+            break;
+        }
+
+        // the chromosome is set by its first alignment, kept or not, so that
+        // the end of a chromosome without any kept alignment is also seen
+        if (pBamInStream->currRefID == NO_QUERY_YET)
+            pBamInStream->currRefID = pBamInStream->pNewNode->alignment.core.tid;
+
         // exclude those reads who are non-paired-end, qc-fail, duplicate-marked, proper-paired, 
         // both aligned, secondary-alignment and no-name-specified.
         SR_StreamCode filterCode = pBamInStream->filterFunc(&(pBamInStream->pNewNode->alignment), pBamInStream->filterData, 
@@ -447,20 +542,13 @@ SR_Status SR_BamInStreamLoadPair(SR_BamNode** ppUpAlgn, SR_BamNode** ppDownAlgn,
         // update the current ref ID or position if the incoming alignment has a 
         // different value. The name hash and the bam array will be reset
         if (pBamInStream->pNewNode->alignment.core.pos >= pBamInStream->currBinPos + 2 * pBamInStream->binLen
-            || pBamInStream->pNewNode->alignment.core.tid != pBamInStream->currRefID
             || pBamInStream->currBinPos == NO_QUERY_YET)
         {
-            if (pBamInStream->pNewNode->alignment.core.tid != pBamInStream->currRefID
-                && pBamInStream->currRefID != NO_QUERY_YET)
-            {
-                ret = SR_OUT_OF_RANGE;
-            }
-
             pBamInStream->currRefID  = pBamInStream->pNewNode->alignment.core.tid;
             pBamInStream->currBinPos = pBamInStream->pNewNode->alignment.core.pos;
 
-            kh_clear(queryName, pNameHashPrev);
-            kh_clear(queryName, pNameHashCurr);
+            SR_NameTableClear(pNameHashPrev);
+            SR_NameTableClear(pNameHashCurr);
 
             SR_BamListReset(&(pBamInStream->pAlgnLists[PREV_BIN]), pBamInStream->pMemPool);
             SR_BamListReset(&(pBamInStream->pAlgnLists[CURR_BIN]), pBamInStream->pMemPool);
@@ -470,8 +558,12 @@ SR_Status SR_BamInStreamLoadPair(SR_BamNode** ppUpAlgn, SR_BamNode** ppDownAlgn,
         {
             pBamInStream->currBinPos += pBamInStream->binLen;
 
-            kh_clear(queryName, pNameHashPrev);
-            SR_SWAP(pNameHashPrev, pNameHashCurr, khash_t(queryName)*);
+            SR_NameTableClear(pNameHashPrev);
+            SR_SWAP(pNameHashPrev, pNameHashCurr, SR_NameTable*);
+
+            // the spill looks up the tables through the stream
+            pBamInStream->pNameHashes[PREV_BIN] = pNameHashPrev;
+            pBamInStream->pNameHashes[CURR_BIN] = pNameHashCurr;
 
             SR_BamListReset(&(pBamInStream->pAlgnLists[PREV_BIN]), pBamInStream->pMemPool);
 
@@ -483,57 +575,70 @@ SR_Status SR_BamInStreamLoadPair(SR_BamNode** ppUpAlgn, SR_BamNode** ppDownAlgn,
         (*ppUpAlgn) = NULL;
         (*ppDownAlgn) = NULL;
 
-        khiter_t khIter = 0;
-
-        khIter = kh_get(queryName, pNameHashPrev, bam1_qname(&(pBamInStream->pNewNode->alignment)));
+        // the read name is hashed once and only compared when the fingerprints match
+        uint64_t fingerprint = SR_NameTableFingerprint(bam1_qname(&(pBamInStream->pNewNode->alignment)));
 
-        if (khIter != kh_end(pNameHashPrev))
+        (*ppUpAlgn) = SR_NameTableTake(pNameHashPrev, fingerprint, bam1_qname(&(pBamInStream->pNewNode->alignment)));
+        if ((*ppUpAlgn) != NULL)
         {
             ret = SR_OK;
-            (*ppUpAlgn) = kh_value(pNameHashPrev, khIter);
             (*ppDownAlgn) = pBamInStream->pNewNode;
 
-            kh_del(queryName, pNameHashPrev, khIter);
-
             SR_BamListRemove(&(pBamInStream->pAlgnLists[PREV_BIN]), (*ppUpAlgn));
             SR_BamListRemove(&(pBamInStream->pAlgnLists[CURR_BIN]), (*ppDownAlgn));
         }
+        else if (pBamInStream->pBamSpill != NULL
+                 && SR_BamSpillTakeMate(pBamInStream->pBamSpill, fingerprint, &(pBamInStream->pNewNode->alignment)))
+        {
+            // the mate has been spilled, this alignment follows it
+            SR_BamListRemove(&(pBamInStream->pAlgnLists[CURR_BIN]), pBamInStream->pNewNode);
+            SR_BamNodeFree(pBamInStream->pNewNode, pBamInStream->pMemPool);
+        }
         else
         {
-            int khRet = 0;
-            khIter = kh_put(queryName, pNameHashCurr, bam1_qname(&(pBamInStream->pNewNode->alignment)), &khRet);
+            (*ppUpAlgn) = SR_NameTableTakeOrPut(pNameHashCurr, fingerprint, pBamInStream->pNewNode);
 
-            if (khRet == 0) // we found a pair of alignments 
+            if ((*ppUpAlgn) != NULL) // we found a pair of alignments 
             {
                 ret = SR_OK;
-                (*ppUpAlgn) = kh_value(pNameHashCurr, khIter);
                 (*ppDownAlgn) = pBamInStream->pNewNode;
 
-                kh_del(queryName, pNameHashCurr, khIter);
-
                 SR_BamListRemove(&(pBamInStream->pAlgnLists[CURR_BIN]), (*ppUpAlgn));
                 SR_BamListRemove(&(pBamInStream->pAlgnLists[CURR_BIN]), (*ppDownAlgn));
             }
-            else // not finding corresponding mate, save the current value and move on
-            {
-                kh_value(pNameHashCurr, khIter) = pBamInStream->pNewNode;
-            }
         }
+
+        // the node is held by the alignment list or returned as a mate
+        pBamInStream->pNewNode = NULL;
     }
 
     pBamInStream->pNameHashes[PREV_BIN] = pNameHashPrev;
     pBamInStream->pNameHashes[CURR_BIN] = pNameHashCurr;
 
-    if (ret < 0)
+    if (ret < 0 && ret != SR_OUT_OF_RANGE)
     {
-        if (ret != SR_OUT_OF_RANGE)
-            SR_BamNodeFree(pBamInStream->pNewNode, pBamInStream->pMemPool);
+        SR_BamNodeFree(pBamInStream->pNewNode, pBamInStream->pMemPool);
+        pBamInStream->pNewNode = NULL;
 
-        if ( ret != SR_OUT_OF_RANGE && ret != SR_EOF)
+        if (ret != SR_EOF)
             ret = SR_ERR;
     }
 
-    pBamInStream->pNewNode = NULL;
+    if ((ret == SR_OUT_OF_RANGE || ret == SR_EOF) && pBamInStream->pBamSpill != NULL 
+        && SR_BamSpillStartMerge(pBamInStream->pBamSpill))
+    {
+        // the alignments still waiting in the memory have no mate. release them before merging
+        SR_NameTableClear(pNameHashPrev);
+        SR_NameTableClear(pNameHashCurr);
+
+        SR_BamListReset(&(pBamInStream->pAlgnLists[PREV_BIN]), pBamInStream->pMemPool);
+        SR_BamListReset(&(pBamInStream->pAlgnLists[CURR_BIN]), pBamInStream->pMemPool);
+
+        pBamInStream->spillStatus = ret;
+        if (SR_BamSpillLoadPair(ppUpAlgn, ppDownAlgn, pBamInStream->pBamSpill, pBamInStream->pMemPool) == SR_OK)
+            ret = SR_OK;
+    }
+
     return ret;
 }
 
@@ -630,6 +735,13 @@ unsigned int SR_BamInStreamShrinkPool(SR_BamInStream* pBamInStream, unsigned int
             kh_put(buffAddress, buffHash, address, &ret);
         }
 
+        // the first alignment of the next chromosome may be waiting in the stream
+        if (pBamInStream->pNewNode != NULL)
+        {
+            address = (int64_t) pBamInStream->pNewNode->whereFrom;
+            kh_put(buffAddress, buffHash, address, &ret);
+        }
+
         unsigned int delNum = currSize - newSize;
         SR_BamBuff* pPrevBuff = NULL;
         SR_BamBuff* pCurrBuff = pBamInStream->pMemPool->pFirstBuff;
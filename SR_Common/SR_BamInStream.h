@@ -22,6 +22,7 @@
 #include "SR_Types.h"
 #include "SR_BamHeader.h"
 #include "SR_BamMemPool.h"
+#include "SR_BamSpill.h"
 
 //===============================
 // Type and constant definition
@@ -29,6 +30,11 @@
 
 typedef SR_StreamCode (*SR_BamFilter) (const bam1_t* pAlignment, void* pFilterData, int32_t currRefID, int32_t currBinPos);
 
+// a filter function that only looks at the fixed-size core of an alignment. it is called before the
+// rest of the alignment is decoded. it should return STREAM_PASS only if the full filter would also
+// skip the alignment, any other code lets the alignment be decoded and checked by the full filter
+typedef SR_StreamCode (*SR_BamCoreFilter) (const bam1_core_t* pCore, void* pFilterData, int32_t currRefID, int32_t currBinPos);
+
 // control parameters for bam in stream
 typedef enum SR_StreamControlFlag
 {
@@ -40,6 +46,17 @@ typedef enum SR_StreamControlFlag
 
 }SR_StreamControlFlag;
 
+// parts of an alignment that are not decoded by the bam in stream
+typedef enum SR_StreamProjection
+{
+    SR_PROJECT_ALL      = 0,                 // decode the whole alignment
+
+    SR_DROP_SEQ_QUAL    = BAM_DROP_SEQ,      // skip the sequence and the qualities (core.l_qseq will be 0)
+
+    SR_DROP_AUX         = BAM_DROP_AUX       // skip the auxiliary data
+
+}SR_StreamProjection;
+
 typedef struct SR_StreamMode
 {
     SR_BamFilter filterFunc;             // a filter function used to skip those uninterested reads
@@ -48,6 +65,10 @@ typedef struct SR_StreamMode
 
     SR_StreamControlFlag controlFlag;    // flag used to control the bam in stream
 
+    SR_BamCoreFilter coreFilterFunc;     // optional filter function applied before an alignment is decoded
+
+    unsigned int projection;             // parts of the alignments that are not needed (combination of SR_StreamProjection)
+
 }SR_StreamMode;
 
 // alignment type
@@ -83,11 +104,15 @@ typedef struct SR_BamInStream
 
     SR_BamFilter filterFunc;                   // customized filter function 
 
+    SR_BamCoreFilter coreFilterFunc;           // customized filter function applied to the core of an alignment before it is decoded
+
+    unsigned int projection;                   // parts of the alignments that are skipped instead of decoded
+
     void* filterData;                          // data used by the filter function
 
     SR_BamMemPool* pMemPool;                   // memory pool used to allocate and recycle the bam alignments
 
-    void* pNameHashes[2];                      // two hashes used to get a pair of alignments
+    void* pNameHashes[2];                      // two read name tables (SR_NameTable) used to get a pair of alignments
 
     SR_BamList* pRetLists;                     // when we find any unique-orphan pairs we push them into these lists, each thread has its own list
 
@@ -97,6 +122,10 @@ typedef struct SR_BamInStream
 
     SR_BamList pAlgnLists[2];                  // lists used to store those incoming alignments
 
+    SR_BamSpill* pBamSpill;                    // alignments moved to disk when the memory pool is full (NULL until it is needed)
+
+    SR_Status spillStatus;                     // status returned once the spilled alignments are merged
+
     unsigned int numThreads;                   // number of threads will be used
 
     unsigned int reportSize;                   // number of alignments should be loaded before report
@@ -155,10 +184,36 @@ void SR_SplitBamInStreamFree(SR_SplitBamInStream* pSplitBamInStream);
 //      2. refID : the reference ID we want to jump to
 // 
 // return:
-//      if jumping succeeds, return SR_OK; if not, return SR_ERR
+//      if jumping succeeds, return SR_OK; if the chromosome has
+//      no alignment, return SR_OUT_OF_RANGE; else return SR_ERR
+//
+// discussion:
+//      the stream is reset before the jump. the first alignment
+//      of the chromosome is kept in the stream and will be
+//      returned through the filter by the next call of
+//      "SR_BamInStreamLoadPair", which returns SR_OUT_OF_RANGE
+//      once it reads past the chromosome
 //=============================================================== 
 SR_Status SR_BamInStreamJump(SR_BamInStream* pBamInStream, int32_t refID);
 
+//===============================================================
+// function:
+//      jump to a position of a chromosome in a bam file
+//
+// args:
+//      1. pBamInStream: a pointer to an bam instream structure
+//      2. refID : the reference ID we want to jump to
+//      3. pos   : the position we want to jump to
+// 
+// return:
+//      the same as "SR_BamInStreamJump"
+//
+// discussion:
+//      the stream starts from the first alignment overlapping
+//      the position, the alignments before it are not read
+//=============================================================== 
+SR_Status SR_BamInStreamJumpTo(SR_BamInStream* pBamInStream, int32_t refID, int32_t pos);
+
 //===============================================================
 // function:
 //      open a bam file
@@ -250,6 +305,34 @@ static inline void SR_SetStreamMode(SR_StreamMode* pStreamMode, SR_BamFilter fil
     pStreamMode->filterFunc = filterFunc;
     pStreamMode->filterData = filterData;
     pStreamMode->controlFlag = controlFlag;
+    pStreamMode->coreFilterFunc = NULL;
+    pStreamMode->projection = SR_PROJECT_ALL;
+}
+
+//===============================================================
+// function:
+//      set the prefilter and the projection of the bam in stream
+//
+// args:
+//      1. pStreamMode: a pointer to a stream mode structure
+//         already set by "SR_SetStreamMode"
+//      2. coreFilterFunc: filter function applied to the core of
+//         an alignment before the rest of it is decoded (NULL to
+//         decode every alignment)
+//      3. projection: parts of the alignments that are never
+//         decoded (combination of SR_StreamProjection)
+//
+// discussion:
+//      the core filter receives the same filter data as the full
+//      filter. an alignment skipped by the core filter costs no
+//      copying and no memory. with SR_DROP_SEQ_QUAL the
+//      alignments have no sequence and qualities and their
+//      core.l_qseq is 0
+//===============================================================
+static inline void SR_SetStreamPrefilter(SR_StreamMode* pStreamMode, SR_BamCoreFilter coreFilterFunc, unsigned int projection)
+{
+    pStreamMode->coreFilterFunc = coreFilterFunc;
+    pStreamMode->projection = projection;
 }
 
 //================================================================
@@ -307,6 +390,19 @@ static inline SR_Status SR_BamInStreamRead(bam1_t* pAlignment, SR_BamInStream* p
 //      if we reach the end of file, return SR_EOF; if we finish 
 //      the current chromosome, return SR_OUT_OF_RANGE; 
 //      else, return SR_ERR
+//
+// discussion:
+//      SR_OUT_OF_RANGE is returned as soon as an alignment of
+//      another chromosome is read, before it is filtered. the
+//      alignment is kept in the stream for the next call, so
+//      the filter never sees an alignment of the next chromosome
+//      while the current one is being scanned.
+//
+//      when the memory pool is full, the oldest alignments
+//      waiting for their mates are moved to temporary files
+//      (their mates follow them once they are read). the pairs
+//      in these files are returned at the end of the chromosome,
+//      before SR_OUT_OF_RANGE or SR_EOF
 //==================================================================
 SR_Status SR_BamInStreamLoadPair(SR_BamNode** ppAlgnOne, SR_BamNode** ppAlgnTwo, SR_BamInStream* pBamInStream);
 
@@ -341,6 +437,12 @@ SR_AlgnType SR_GetAlignmentType(SR_BamNode** ppAlgnOne, SR_BamNode** ppAlgnTwo,
 //      chromosome, return SR_OUT_OF_RANGE; if we reach the end of
 //      the file, return SR_EOF; if an error happens, return
 //      SR_ERR; else return SR_OK
+//
+// discussion:
+//      reading and processing alternate in the calling thread.
+//      "SR_BamPipeline" (SR_BamPipeline.h) runs the same loop
+//      on a dedicated reader thread and hands batches of read
+//      pairs to the consumer threads
 //==================================================================
 SR_Status SR_LoadAlgnPairs(SR_BamInStream* pBamInStream, unsigned int threadID, double scTolerance, double maxMismatchRate, unsigned char minMQ);
 
@@ -357,6 +459,52 @@ SR_Status SR_LoadAlgnPairs(SR_BamInStream* pBamInStream, unsigned int threadID,
 //================================================================ 
 #define SR_BamInStreamGetPoolSize(pBamInStream) ((pBamInStream)->pMemPool->numBuffs)
 
+//================================================================
+// function:
+//      set the maximum number of alignments in the memory pool
+//      of the bam in stream
+//
+// args:
+//      1. pBamInStream: a pointer to an bam instream structure
+//      2. maxSize: the maximum number of alignments
+//
+// discussion:
+//      once the pool is full the oldest alignments waiting for
+//      their mates are moved to temporary files
+//================================================================
+#define SR_BamInStreamSetMaxPoolSize(pBamInStream, maxSize) SR_BamMemPoolSetMaxSize((pBamInStream)->pMemPool, (maxSize))
+
+//================================================================
+// function:
+//      set the bin length of the bam in stream
+//
+// args:
+//      1. pBamInStream: a pointer to an bam instream structure
+//      2. newBinLen: the new bin length
+//
+// discussion:
+//      this should only be called before the first alignment of
+//      a chromosome is loaded (after a jump or after
+//      "SR_BamInStreamLoadPair" returns SR_OUT_OF_RANGE). the
+//      filter data should use the same bin length
+//================================================================
+#define SR_BamInStreamSetBinLen(pBamInStream, newBinLen) ((pBamInStream)->binLen = (newBinLen))
+
+//================================================================
+// function:
+//      get the reference ID of the alignment waiting in the
+//      stream (left by a jump or at the end of a chromosome)
+//
+// args:
+//      1. pBamInStream: a pointer to an bam instream structure
+// 
+// return:
+//      the reference ID of the waiting alignment, -1 if there
+//      is no such alignment
+//================================================================ 
+#define SR_BamInStreamGetNextRefID(pBamInStream) \
+    ((pBamInStream)->pNewNode != NULL ? (pBamInStream)->pNewNode->alignment.core.tid : -1)
+
 //================================================================
 // function:
 //      get a iterator to a certain buffer of a thread
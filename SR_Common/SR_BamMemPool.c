@@ -22,8 +22,6 @@
 #include "SR_Error.h"
 #include "SR_BamMemPool.h"
 
-#define SR_MAX_MEM_POOL_SIZE 2000000
-
 static inline SR_Bool SR_BamListIsEmpty(SR_BamList* pList)
 {
     return (pList->numNode == 0);
@@ -159,7 +157,18 @@ SR_BamBuff* SR_BamBuffAlloc(unsigned int buffCapacity)
     if (pNewBuff->pNodeArray == NULL)
         SR_ErrQuit("ERROR: Not enough memory for the storage of alignments in the bam memory node object.\n");
 
-    
+    // the payloads of all the alignments in the buffer share one slab
+    // so that reading a record does not need its own malloc
+    pNewBuff->pDataSlab = (uint8_t*) malloc((size_t) buffCapacity * SR_BAM_DATA_SLOT_SIZE);
+    if (pNewBuff->pDataSlab == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the storage of alignment data in the bam memory node object.\n");
+
+    for (unsigned int i = 0; i != buffCapacity; ++i)
+    {
+        pNewBuff->pNodeArray[i].alignment.data = pNewBuff->pDataSlab + (size_t) i * SR_BAM_DATA_SLOT_SIZE;
+        pNewBuff->pNodeArray[i].alignment.m_data = SR_BAM_DATA_SLOT_SIZE;
+    }
+
     for (unsigned int i = 0; i != buffCapacity - 1; ++i)
     {
         pNewBuff->pNodeArray[i].whereFrom = pNewBuff;
@@ -178,9 +187,14 @@ void SR_BamBuffFree(SR_BamBuff* pBuff, unsigned int buffCapacity)
 {
     if (pBuff != NULL)
     {
+        // only the records that outgrew their slots own their memory
         for (unsigned int i = 0; i != buffCapacity; ++i)
-            free(pBuff->pNodeArray[i].alignment.data);
+        {
+            if (!SR_BamNodeInSlab(pBuff->pNodeArray + i, buffCapacity))
+                free(pBuff->pNodeArray[i].alignment.data);
+        }
 
+        free(pBuff->pDataSlab);
         free(pBuff->pNodeArray);
         free(pBuff);
     }
@@ -197,7 +211,7 @@ void SR_BamBuffClear(SR_BamBuff* pBuff, SR_BamMemPool* pMemPool)
 
 SR_Status SR_BamMemPoolExpand(SR_BamMemPool* pMemPool)
 {
-    if ((pMemPool->numBuffs + 1) * pMemPool->buffCapacity > SR_MAX_MEM_POOL_SIZE)
+    if ((pMemPool->numBuffs + 1) * pMemPool->buffCapacity > pMemPool->maxSize && pMemPool->numBuffs != 0)
         return SR_OVER_FLOW;
 
     SR_BamBuff* pNewBuff = SR_BamBuffAlloc(pMemPool->buffCapacity);
@@ -220,6 +234,7 @@ SR_BamMemPool* SR_BamMemPoolAlloc(unsigned int buffCapacity)
     pNewPool->numBuffs = 0;
     pNewPool->pFirstBuff = NULL;
     pNewPool->buffCapacity = buffCapacity;
+    pNewPool->maxSize = SR_MAX_MEM_POOL_SIZE;
 
     SR_BamMemPoolExpand(pNewPool);
 
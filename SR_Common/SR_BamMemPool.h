@@ -22,6 +22,13 @@
 #include "bam.h"
 #include "SR_Types.h"
 
+// size of the payload slot reserved for each alignment in a buffer.
+// a record longer than this is moved to its own heap block
+#define SR_BAM_DATA_SLOT_SIZE 512
+
+// default maximum number of alignments in a memory pool
+#define SR_MAX_MEM_POOL_SIZE 2000000
+
 typedef struct SR_BamNode SR_BamNode;
 
 typedef SR_BamNode* SR_BamListIter;
@@ -59,6 +66,8 @@ struct SR_BamBuff
     SR_BamBuff* nextBuff;
 
     SR_BamNode* pNodeArray;
+
+    uint8_t* pDataSlab;
 };
 
 struct SR_BamMemPool
@@ -67,6 +76,8 @@ struct SR_BamMemPool
 
     unsigned int buffCapacity;
 
+    unsigned int maxSize;
+
     SR_BamBuff* pFirstBuff;
 
     SR_BamList avlNodeList;
@@ -76,6 +87,19 @@ SR_BamNode* SR_BamNodeAlloc(SR_BamMemPool* pMemPool);
 
 #define SR_BamNodeFree(pNode, pMemPool)  SR_BamListPushHead(&((pMemPool)->avlNodeList), (pNode))
 
+// check if the payload of an alignment still lives in the slab of its buffer
+static inline SR_Bool SR_BamNodeInSlab(const SR_BamNode* pNode, unsigned int buffCapacity)
+{
+    const uint8_t* pSlab = pNode->whereFrom->pDataSlab;
+    return (pNode->alignment.data >= pSlab && pNode->alignment.data < pSlab + (size_t) buffCapacity * SR_BAM_DATA_SLOT_SIZE);
+}
+
+// read the next alignment from a bam file into a node
+static inline int SR_BamNodeRead(bamFile fpBamInput, SR_BamNode* pNode, const SR_BamMemPool* pMemPool)
+{
+    return bam_read1_ext(fpBamInput, &(pNode->alignment), SR_BamNodeInSlab(pNode, pMemPool->buffCapacity));
+}
+
 static inline SR_BamListIter SR_BamListGetIter(SR_BamList* pList)
 {
     return pList->first;
@@ -107,6 +131,9 @@ void SR_BamMemPoolFree(SR_BamMemPool* pMemPool);
 
 #define SR_BamMemPoolGetSize(pMemPool) ((pMemPool)->numBuffs)
 
+// set the maximum number of alignments in the pool. the pool never grows beyond it
+#define SR_BamMemPoolSetMaxSize(pMemPool, newMaxSize) ((pMemPool)->maxSize = (newMaxSize))
+
 SR_Status SR_BamMemPoolExpand(SR_BamMemPool* pMemPool);
 
 
@@ -16,18 +16,25 @@
  * =====================================================================================
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "SR_Error.h"
 #include "SR_BamPairAux.h"
 #include "SR_BamInStream.h"
 
+// the tags read from the read pairs: the read group, the special tag and the mismatches
+static const char SR_PAIR_TAGS[][2] = {{'R', 'G'}, {'Z', 'A'}, {'M', 'D'}};
+
 static SR_Status SR_LoadMate(bam1_t* pMate, const bam1_t* pAlignment, bamFile pBamInput, bam_index_t* pBamIndex)
 {
     // jump and read the first alignment in the given chromosome
     bam_iter_t pBamIter = bam_iter_query(pBamIndex, pAlignment->core.mtid, pAlignment->core.mpos, pAlignment->core.mpos + 1);
 
+    // the sequence and the qualities of the mates are never used
     int ret;
     SR_Status retStatus = SR_ERR;
-    while ((ret = bam_iter_read(pBamInput, pBamIter, pMate)) >= 0)
+    while ((ret = bam_iter_read_ext(pBamInput, pBamIter, pMate, 0, BAM_DROP_SEQ)) >= 0)
     {
         if (strcmp(bam1_qname(pMate), bam1_qname(pAlignment)) == 0)
         {
@@ -40,6 +47,121 @@ static SR_Status SR_LoadMate(bam1_t* pMate, const bam1_t* pAlignment, bamFile pB
     return retStatus;
 }
 
+// get the size of an auxiliary field starting at its tag
+static unsigned int SR_GetAuxFieldSize(const uint8_t* pField)
+{
+    int type = pField[2];
+    const uint8_t* pValue = pField + 3;
+
+    if (type == 'Z' || type == 'H')
+        return 3 + strlen((const char*) pValue) + 1;
+
+    if (type == 'B')
+    {
+        int32_t numElements = 0;
+        memcpy(&numElements, pValue + 1, sizeof(int32_t));
+        return 3 + 5 + bam_aux_type2size(pValue[0]) * numElements;
+    }
+
+    return 3 + bam_aux_type2size(type);
+}
+
+// copy only the core, the read name, the cigar and the tags of a read pair.
+// the sequence, the qualities and the other tags are left out
+static void SR_CopyPairAlgn(bam1_t* pDst, const bam1_t* pSrc)
+{
+    const uint8_t* pFields[sizeof(SR_PAIR_TAGS) / sizeof(SR_PAIR_TAGS[0])];
+    unsigned int fieldSizes[sizeof(SR_PAIR_TAGS) / sizeof(SR_PAIR_TAGS[0])];
+
+    unsigned int numTags = sizeof(SR_PAIR_TAGS) / sizeof(SR_PAIR_TAGS[0]);
+    int headLen = pSrc->core.l_qname + pSrc->core.n_cigar * 4;
+    int auxLen = 0;
+
+    for (unsigned int i = 0; i != numTags; ++i)
+    {
+        // the field starts at the tag, two bytes before its type
+        const uint8_t* pValue = bam_aux_get(pSrc, SR_PAIR_TAGS[i]);
+        pFields[i] = (pValue != NULL ? pValue - 2 : NULL);
+        fieldSizes[i] = (pValue != NULL ? SR_GetAuxFieldSize(pFields[i]) : 0);
+
+        auxLen += fieldSizes[i];
+    }
+
+    if (pDst->m_data < headLen + auxLen)
+    {
+        pDst->m_data = headLen + auxLen;
+        kroundup32(pDst->m_data);
+
+        pDst->data = (uint8_t*) realloc(pDst->data, pDst->m_data);
+        if (pDst->data == NULL)
+            SR_ErrQuit("ERROR: Not enough memory for the deferred read pairs.\n");
+    }
+
+    pDst->core = pSrc->core;
+    pDst->core.l_qseq = 0;
+
+    memcpy(pDst->data, pSrc->data, headLen);
+
+    uint8_t* pAux = pDst->data + headLen;
+    for (unsigned int i = 0; i != numTags; ++i)
+    {
+        if (pFields[i] != NULL)
+        {
+            memcpy(pAux, pFields[i], fieldSizes[i]);
+            pAux += fieldSizes[i];
+        }
+    }
+
+    pDst->l_aux = auxLen;
+    pDst->data_len = headLen + auxLen;
+}
+
+// keep a compact copy of an anchor whose mate will be loaded later
+static void SR_FilterDataRPDefer(SR_FilterDataRP* pDataRP, const bam1_t* pAlignment)
+{
+    SR_DeferredMateArray* pDeferred = &(pDataRP->deferred);
+    if (pDeferred->size == pDeferred->capacity)
+    {
+        unsigned int newCapacity = (pDeferred->capacity == 0 ? DEFAULT_DEFERRED_MATE_CAP : pDeferred->capacity * 2);
+        if (newCapacity > SR_MAX_DEFERRED_MATES)
+            newCapacity = SR_MAX_DEFERRED_MATES;
+
+        pDeferred->data = (SR_DeferredMate*) realloc(pDeferred->data, newCapacity * sizeof(SR_DeferredMate));
+        pDeferred->pQueries = (SR_MateQuery*) realloc(pDeferred->pQueries, newCapacity * sizeof(SR_MateQuery));
+        if (pDeferred->data == NULL || pDeferred->pQueries == NULL)
+            SR_ErrQuit("ERROR: Not enough memory for the deferred read pairs.\n");
+
+        // the new alignments have no buffers yet
+        memset(pDeferred->data + pDeferred->capacity, 0, (newCapacity - pDeferred->capacity) * sizeof(SR_DeferredMate));
+        pDeferred->capacity = newCapacity;
+    }
+
+    SR_DeferredMate* pDeferredMate = pDeferred->data + pDeferred->size;
+    SR_CopyPairAlgn(&(pDeferredMate->anchor), pAlignment);
+    pDeferredMate->isFound = FALSE;
+
+    pDeferred->pQueries[pDeferred->size].mtid = pAlignment->core.mtid;
+    pDeferred->pQueries[pDeferred->size].mpos = pAlignment->core.mpos;
+    pDeferred->pQueries[pDeferred->size].index = pDeferred->size;
+
+    ++(pDeferred->size);
+}
+
+static int SR_MateQueryCompare(const void* pQueryOne, const void* pQueryTwo)
+{
+    const SR_MateQuery* pOne = (const SR_MateQuery*) pQueryOne;
+    const SR_MateQuery* pTwo = (const SR_MateQuery*) pQueryTwo;
+
+    if (pOne->mtid != pTwo->mtid)
+        return (pOne->mtid < pTwo->mtid ? -1 : 1);
+
+    if (pOne->mpos != pTwo->mpos)
+        return (pOne->mpos < pTwo->mpos ? -1 : 1);
+
+    // keep the anchors of the same position in their original order
+    return (pOne->index < pTwo->index ? -1 : (pOne->index > pTwo->index));
+}
+
 
 SR_FilterDataRP* SR_FilterDataRPAlloc(const SR_AnchorInfo* pAnchorInfo, uint32_t binLen)
 {
@@ -58,6 +180,9 @@ SR_FilterDataRP* SR_FilterDataRPAlloc(const SR_AnchorInfo* pAnchorInfo, uint32_t
     pFilterData->pUpAlgn = bam_init1();
     pFilterData->pDownAlgn = bam_init1();
 
+    pFilterData->deferMates = FALSE;
+    memset(&(pFilterData->deferred), 0, sizeof(SR_DeferredMateArray));
+
     return pFilterData;
 }
 
@@ -74,6 +199,15 @@ void SR_FilterDataRPFree(SR_FilterDataRP* pFilterData)
         bam_destroy1(pFilterData->pUpAlgn);
         bam_destroy1(pFilterData->pDownAlgn);
 
+        for (unsigned int i = 0; i != pFilterData->deferred.capacity; ++i)
+        {
+            free(pFilterData->deferred.data[i].anchor.data);
+            free(pFilterData->deferred.data[i].mate.data);
+        }
+
+        free(pFilterData->deferred.data);
+        free(pFilterData->deferred.pQueries);
+
         free(pFilterData);
     }
 }
@@ -93,88 +227,112 @@ void SR_FilterDataRPInit(SR_FilterDataRP* pFilterData, const char* bamInputFile)
     pFilterData->pBamIndex = bam_index_load(bamInputFile);
     if (pFilterData->pBamIndex == NULL)
         SR_ErrQuit("ERROR: Cannot open the index file for this bam: %s.\n", bamInputFile);
+
+    pFilterData->deferred.size = 0;
+    pFilterData->deferred.next = 0;
 }
 
-SR_StreamCode SR_ReadPairFilter(const bam1_t* pAlignment, void* pFilterData, int32_t currRefID, int32_t currBinPos)
+// the part of the read pair filter that only depends on the core of an alignment.
+// STREAM_RETRUN means the mate should be loaded through the bam index
+static SR_StreamCode SR_ReadPairCoreCheck(const bam1_core_t* pCore, const SR_FilterDataRP* pDataRP, int32_t currRefID, int32_t currBinPos)
 {
-    // this is the fragment length distribution
-    SR_FilterDataRP* pDataRP = (SR_FilterDataRP*) pFilterData;
-    pDataRP->isFilled = FALSE;
-
-    if ((pAlignment->core.flag & BAM_FPAIRED) == 0
-        || strcmp(bam1_qname(pAlignment), "*") == 0
-        || (pAlignment->core.flag & SR_READ_PAIR_FMASK) != 0)
+    if ((pCore->flag & BAM_FPAIRED) == 0
+        || (pCore->flag & SR_READ_PAIR_FMASK) != 0)
     {
         return STREAM_PASS;
     }
 
     // if any of the mate of a read pair lands on an unused reference we filter them out
-    if (pDataRP->pAnchorInfo->pLength[pAlignment->core.tid] < 0
-        || pDataRP->pAnchorInfo->pLength[pAlignment->core.mtid] < 0)
+    if (pDataRP->pAnchorInfo->pLength[pCore->tid] < 0
+        || pDataRP->pAnchorInfo->pLength[pCore->mtid] < 0)
     {
         return STREAM_PASS;
     }
 
-    if (pAlignment->core.tid != pAlignment->core.mtid)
+    if (pCore->tid != pCore->mtid)
     {
-        if (pDataRP->loadCross && pAlignment->core.tid < pAlignment->core.mtid)
-        {
-            SR_Status status = SR_LoadMate(pDataRP->pDownAlgn, pAlignment, pDataRP->pBamInput, pDataRP->pBamIndex);
-            if (status == SR_OK)
-            {
-                bam_copy1(pDataRP->pUpAlgn, pAlignment);
-                pDataRP->isFilled = TRUE;
-                return STREAM_RETRUN;
-            }
-        }
+        if (pDataRP->loadCross && pCore->tid < pCore->mtid)
+            return STREAM_RETRUN;
 
         return STREAM_PASS;
     }
 
-    if (currRefID != pAlignment->core.tid || currBinPos < 0)
+    if (currRefID != pCore->tid || currBinPos < 0)
     {
-        currRefID = pAlignment->core.tid;
-        currBinPos = pAlignment->core.pos;
+        currRefID = pCore->tid;
+        currBinPos = pCore->pos;
     }
 
     SR_Bool shouldLoad = FALSE;
-    if (pAlignment->core.pos <= pAlignment->core.mpos)
+    if (pCore->pos <= pCore->mpos)
     {
-        if (pAlignment->core.pos < currBinPos + pDataRP->binLen)
+        if (pCore->pos < currBinPos + pDataRP->binLen)
         {
-            if (pAlignment->core.mpos >= currBinPos + 2 * pDataRP->binLen)
+            if (pCore->mpos >= currBinPos + 2 * pDataRP->binLen)
                 shouldLoad = TRUE;
         }
-        else if (pAlignment->core.pos >= currBinPos + 2 * pDataRP->binLen)
+        else if (pCore->pos >= currBinPos + 2 * pDataRP->binLen)
         {
-            if (pAlignment->core.mpos >= pAlignment->core.pos + 2 * pDataRP->binLen)
+            if (pCore->mpos >= pCore->pos + 2 * pDataRP->binLen)
                 shouldLoad = TRUE;
         }
         else
         {
-            if (pAlignment->core.mpos >= pAlignment->core.pos + 3 * pDataRP->binLen)
+            if (pCore->mpos >= pCore->pos + 3 * pDataRP->binLen)
                 shouldLoad = TRUE;
         }
     }
     else
     {
-        if (pAlignment->core.pos < currBinPos + pDataRP->binLen)
+        if (pCore->pos < currBinPos + pDataRP->binLen)
         {
-            if (pAlignment->core.mpos + pDataRP->binLen < currBinPos)
+            if (pCore->mpos + pDataRP->binLen < currBinPos)
                 return STREAM_PASS;
         }
-        else if (pAlignment->core.pos >= 2 * currBinPos + pDataRP->binLen)
+        else if (pCore->pos >= 2 * currBinPos + pDataRP->binLen)
         {
             return STREAM_PASS;
         }
         else
         {
-            if (pAlignment->core.mpos < currBinPos)
+            if (pCore->mpos < currBinPos)
                 return STREAM_PASS;
         }
     }
 
     if (shouldLoad)
+        return STREAM_RETRUN;
+
+    return STREAM_KEEP;
+}
+
+SR_StreamCode SR_ReadPairCoreFilter(const bam1_core_t* pCore, void* pFilterData, int32_t currRefID, int32_t currBinPos)
+{
+    // a mate to be loaded still needs the whole alignment
+    if (SR_ReadPairCoreCheck(pCore, (const SR_FilterDataRP*) pFilterData, currRefID, currBinPos) == STREAM_PASS)
+        return STREAM_PASS;
+
+    return STREAM_KEEP;
+}
+
+SR_StreamCode SR_ReadPairFilter(const bam1_t* pAlignment, void* pFilterData, int32_t currRefID, int32_t currBinPos)
+{
+    // this is the fragment length distribution
+    SR_FilterDataRP* pDataRP = (SR_FilterDataRP*) pFilterData;
+    pDataRP->isFilled = FALSE;
+
+    if (strcmp(bam1_qname(pAlignment), "*") == 0)
+        return STREAM_PASS;
+
+    // once the deferred anchors of a chromosome reach their limit, the
+    // mates of the following ones are loaded right away
+    SR_StreamCode coreCode = SR_ReadPairCoreCheck(&(pAlignment->core), pDataRP, currRefID, currBinPos);
+    if (coreCode == STREAM_RETRUN && pDataRP->deferMates && pDataRP->deferred.size != SR_MAX_DEFERRED_MATES)
+    {
+        SR_FilterDataRPDefer(pDataRP, pAlignment);
+        return STREAM_PASS;
+    }
+    else if (coreCode == STREAM_RETRUN)
     {
         SR_Status status = SR_LoadMate(pDataRP->pDownAlgn, pAlignment, pDataRP->pBamInput, pDataRP->pBamIndex);
         if (status == SR_OK)
@@ -187,7 +345,88 @@ SR_StreamCode SR_ReadPairFilter(const bam1_t* pAlignment, void* pFilterData, int
         return STREAM_PASS;
     }
 
-    return STREAM_KEEP;
+    return coreCode;
+}
+
+void SR_FilterDataRPResolveMates(SR_FilterDataRP* pFilterData)
+{
+    SR_DeferredMateArray* pDeferred = &(pFilterData->deferred);
+    pDeferred->next = 0;
+
+    if (pDeferred->size == 0)
+        return;
+
+    qsort(pDeferred->pQueries, pDeferred->size, sizeof(SR_MateQuery), SR_MateQueryCompare);
+
+    bam1_t* pMate = bam_init1();
+
+    unsigned int first = 0;
+    while (first != pDeferred->size)
+    {
+        // the queries close to each other on the same chromosome share a window
+        unsigned int last = first + 1;
+        while (last != pDeferred->size
+               && pDeferred->pQueries[last].mtid == pDeferred->pQueries[first].mtid
+               && pDeferred->pQueries[last].mpos - pDeferred->pQueries[last - 1].mpos <= SR_MATE_SWEEP_GAP)
+        {
+            ++last;
+        }
+
+        int32_t mtid = pDeferred->pQueries[first].mtid;
+        int32_t endPos = pDeferred->pQueries[last - 1].mpos;
+        bam_iter_t pBamIter = bam_iter_query(pFilterData->pBamIndex, mtid, pDeferred->pQueries[first].mpos, endPos + 1);
+
+        // walk the alignments and the sorted queries together
+        unsigned int curr = first;
+        while (curr != last && bam_iter_read_ext(pFilterData->pBamInput, pBamIter, pMate, 0, BAM_DROP_SEQ) >= 0)
+        {
+            if (pMate->core.pos > endPos)
+                break;
+
+            while (curr != last && pDeferred->pQueries[curr].mpos < pMate->core.pos)
+                ++curr;
+
+            for (unsigned int i = curr; i != last && pDeferred->pQueries[i].mpos == pMate->core.pos; ++i)
+            {
+                SR_DeferredMate* pDeferredMate = pDeferred->data + pDeferred->pQueries[i].index;
+                if (!pDeferredMate->isFound && strcmp(bam1_qname(pMate), bam1_qname(&(pDeferredMate->anchor))) == 0)
+                {
+                    SR_CopyPairAlgn(&(pDeferredMate->mate), pMate);
+                    pDeferredMate->isFound = TRUE;
+                    break;
+                }
+            }
+        }
+
+        bam_iter_destroy(pBamIter);
+        first = last;
+    }
+
+    bam_destroy1(pMate);
+}
+
+SR_Bool SR_FilterDataRPGetMate(SR_FilterDataRP* pFilterData, const bam1_t** ppUpAlgn, const bam1_t** ppDownAlgn)
+{
+    SR_DeferredMateArray* pDeferred = &(pFilterData->deferred);
+
+    while (pDeferred->next != pDeferred->size)
+    {
+        SR_DeferredMate* pDeferredMate = pDeferred->data + pDeferred->next;
+        ++(pDeferred->next);
+
+        if (pDeferredMate->isFound)
+        {
+            (*ppUpAlgn) = &(pDeferredMate->anchor);
+            (*ppDownAlgn) = &(pDeferredMate->mate);
+
+            return TRUE;
+        }
+    }
+
+    pDeferred->size = 0;
+    pDeferred->next = 0;
+
+    return FALSE;
 }
 
     /*
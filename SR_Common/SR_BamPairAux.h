@@ -36,6 +36,57 @@ static const unsigned int SR_NORMAL_FMASK = (BAM_FSECONDARY | BAM_FQCFAIL | BAM_
 
 static const unsigned int SR_READ_PAIR_FMASK = (BAM_FSECONDARY | BAM_FQCFAIL | BAM_FDUP | BAM_FUNMAP | BAM_FMUNMAP);
 
+// the genomic gap below which the mates of two deferred anchors are
+// collected by the same sequential read instead of two index queries.
+// it is the window size of the linear index of a bam file
+#define SR_MATE_SWEEP_GAP (1 << 14)
+
+// initial capacity of the deferred anchors
+#define DEFAULT_DEFERRED_MATE_CAP 256
+
+// the most anchors deferred on a chromosome. the mates of the anchors
+// beyond it are loaded right away, one index query per read pair
+#define SR_MAX_DEFERRED_MATES (1 << 15)
+
+// an anchor whose mate is too far away to be paired in the stream.
+// only the core, the read name, the cigar and the RG, ZA and MD tags
+// of the read pair are kept
+typedef struct SR_DeferredMate
+{
+    bam1_t anchor;                  // compact copy of the anchor
+
+    bam1_t mate;                    // compact copy of the mate of the anchor
+
+    SR_Bool isFound;                // boolean variable used to indicate if the mate is found
+
+}SR_DeferredMate;
+
+// location of the mate of a deferred anchor
+typedef struct SR_MateQuery
+{
+    int32_t mtid;                   // reference ID of the mate
+
+    int32_t mpos;                   // position of the mate
+
+    unsigned int index;             // index of the deferred anchor
+
+}SR_MateQuery;
+
+// anchors of a chromosome waiting for their mates
+typedef struct SR_DeferredMateArray
+{
+    SR_DeferredMate* data;          // the anchors and their mates (the alignment buffers are reused)
+
+    SR_MateQuery* pQueries;         // mate locations, sorted before they are collected
+
+    unsigned int size;              // number of deferred anchors
+
+    unsigned int capacity;          // capacity of the array
+
+    unsigned int next;              // the next anchor returned by "SR_FilterDataRPGetMate"
+
+}SR_DeferredMateArray;
+
 typedef struct SR_FilterDataRP
 {
     bam1_t* pUpAlgn;
@@ -54,6 +105,10 @@ typedef struct SR_FilterDataRP
 
     SR_Bool isFilled;
 
+    SR_Bool deferMates;
+
+    SR_DeferredMateArray deferred;
+
 }SR_FilterDataRP;
 
 
@@ -78,6 +133,18 @@ static inline SR_StreamCode SR_CommonFilter(const bam1_t* pAlignment, void* pFil
     return STREAM_KEEP;
 }
 
+static inline SR_StreamCode SR_CommonCoreFilter(const bam1_core_t* pCore, void* pFilterData, int32_t currRefID, int32_t currBinPos)
+{
+    if ((pCore->flag & BAM_FPAIRED) == 0
+        || (pCore->flag & SR_UNIQUE_ORPHAN_FMASK) != 0
+        || (pCore->flag | (BAM_FUNMAP | BAM_FMUNMAP)) == pCore->flag)
+    {
+        return STREAM_PASS;
+    }
+
+    return STREAM_KEEP;
+}
+
 static inline SR_StreamCode SR_NormalFilter(const bam1_t* pAlignment, void* pFilterData, int32_t currRefID, int32_t currBinPos)
 {
     if ((pAlignment->core.flag & BAM_FPAIRED) == 0
@@ -95,14 +162,69 @@ static inline SR_StreamCode SR_NormalFilter(const bam1_t* pAlignment, void* pFil
     return STREAM_KEEP;
 }
 
+static inline SR_StreamCode SR_NormalCoreFilter(const bam1_core_t* pCore, void* pFilterData, int32_t currRefID, int32_t currBinPos)
+{
+    if ((pCore->flag & BAM_FPAIRED) == 0
+        || (pCore->flag & SR_NORMAL_FMASK) != 0
+        || pCore->isize == 0
+        || pCore->tid != pCore->mtid)
+    {
+        return STREAM_PASS;
+    }
+
+    return STREAM_KEEP;
+}
+
 void SR_FilterDataRPInit(SR_FilterDataRP* pFilterData, const char* bamInputFile);
 
 #define SR_FilterDataRPTurnOffCross(pFilterData) (pFilterData)->loadCross = FALSE
 
 #define SR_FilterDataRPTurnOnCross(pFilterData) (pFilterData)->loadCross = TRUE
 
+// the far and cross read pairs will be resolved by "SR_FilterDataRPResolveMates" instead of returned by the filter
+#define SR_FilterDataRPTurnOnDefer(pFilterData) (pFilterData)->deferMates = TRUE
+
+//==================================================================
+// function:
+//      load the mates of the deferred anchors
+//
+// args:
+//      1. pFilterData: a pointer to the read pair filter data
+//
+// discussion:
+//      the mate locations are sorted and the mates close to each
+//      other are collected with a single sequential read through
+//      the bam index, instead of one index query per read pair.
+//      call it when the stream finishes a chromosome, then take
+//      the read pairs with "SR_FilterDataRPGetMate"
+//==================================================================
+void SR_FilterDataRPResolveMates(SR_FilterDataRP* pFilterData);
+
+//==================================================================
+// function:
+//      get the next read pair resolved by
+//      "SR_FilterDataRPResolveMates"
+//
+// args:
+//      1. pFilterData: a pointer to the read pair filter data
+//      2. ppUpAlgn   : returns the anchor
+//      3. ppDownAlgn : returns the mate of the anchor
+//
+// return:
+//      TRUE if a read pair is returned. FALSE if there are no
+//      more read pairs, the deferred anchors are cleared then
+//
+// discussion:
+//      the read pairs are returned in the order they are
+//      deferred, those without a mate are skipped. the pair is
+//      valid until the next call of "SR_FilterDataRPResolveMates"
+//==================================================================
+SR_Bool SR_FilterDataRPGetMate(SR_FilterDataRP* pFilterData, const bam1_t** ppUpAlgn, const bam1_t** ppDownAlgn);
+
 SR_StreamCode SR_ReadPairFilter(const bam1_t* pAlignment, void* pFilterData, int32_t cuuRefID, int32_t currBinPos);
 
+SR_StreamCode SR_ReadPairCoreFilter(const bam1_core_t* pCore, void* pFilterData, int32_t currRefID, int32_t currBinPos);
+
 
     
 #endif  /*SR_BAMPAIRAUX_H*/
@@ -0,0 +1,238 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_BamPipeline.c
+ *
+ *    Description:  reader/worker pipeline mode of the bam in stream
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:20:18 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+
+#include "SR_Error.h"
+#include "SR_BamPipeline.h"
+
+
+//===================
+// Static functions
+//===================
+
+// take a free batch back from the consumers and return its alignments to the memory pool
+static SR_PairBatch* SR_BamPipelineAcquire(SR_BamPipeline* pPipeline)
+{
+    while (sem_wait(&(pPipeline->numFreeBatches)) != 0 && errno == EINTR)
+        continue;
+
+    SR_PairBatch* pBatch = (SR_PairBatch*) SR_LockFreeQueueWaitPop(pPipeline->pRecycleQueue);
+
+    for (unsigned int i = 0; i != 2 * pBatch->numPairs; ++i)
+        SR_BamInStreamRecycle(pPipeline->pBamInStream, pBatch->pAlgns[i]);
+
+    pBatch->numPairs = 0;
+    pBatch->refID = -1;
+    pBatch->status = SR_OK;
+
+    return pBatch;
+}
+
+static void SR_BamPipelinePush(SR_BamPipeline* pPipeline, SR_PairBatch* pBatch)
+{
+    SR_LockFreeQueueWaitPush(pPipeline->pWorkQueue, pBatch);
+    sem_post(&(pPipeline->numWorkBatches));
+}
+
+static void* SR_BamPipelineRead(void* pArg)
+{
+    SR_BamPipeline* pPipeline = (SR_BamPipeline*) pArg;
+    SR_BamInStream* pBamInStream = pPipeline->pBamInStream;
+
+    SR_BamNode* pAlgnOne = NULL;
+    SR_BamNode* pAlgnTwo = NULL;
+
+    SR_PairBatch* pBatch = NULL;
+    SR_Status readerStatus = SR_OK;
+
+    // the chromosome being read. the stream forgets it at the end of the chromosome
+    // and while the spilled pairs are merged
+    int32_t refID = -1;
+
+    for (;;)
+    {
+        readerStatus = SR_BamInStreamLoadPair(&pAlgnOne, &pAlgnTwo, pBamInStream);
+        if (SR_BamInStreamGetRefID(pBamInStream) >= 0)
+            refID = SR_BamInStreamGetRefID(pBamInStream);
+
+        if (readerStatus == SR_OK)
+        {
+            SR_AlgnType algnType = SR_GetAlignmentType(&pAlgnOne, &pAlgnTwo, pPipeline->scTolerance, pPipeline->maxMismatchRate, pPipeline->minMQ);
+            if (algnType == SR_UNIQUE_ORPHAN || algnType == SR_UNIQUE_SOFT || algnType == SR_UNIQUE_MULTIPLE)
+            {
+                if (pBatch == NULL)
+                {
+                    pBatch = SR_BamPipelineAcquire(pPipeline);
+                    pBatch->refID = refID;
+                }
+
+                pBatch->pAlgns[2 * pBatch->numPairs] = pAlgnOne;
+                pBatch->pAlgns[2 * pBatch->numPairs + 1] = pAlgnTwo;
+                pBatch->pAlgnTypes[pBatch->numPairs] = algnType;
+                ++(pBatch->numPairs);
+
+                if (pBatch->numPairs == pPipeline->batchSize)
+                {
+                    SR_BamPipelinePush(pPipeline, pBatch);
+                    pBatch = NULL;
+                }
+            }
+            else
+            {
+                SR_BamInStreamRecycle(pBamInStream, pAlgnOne);
+                SR_BamInStreamRecycle(pBamInStream, pAlgnTwo);
+            }
+        }
+        else if (readerStatus == SR_OUT_OF_RANGE)
+        {
+            // the first alignment of the next chromosome is already in the stream. an empty
+            // batch marks the end of a chromosome whose last batch is full or that has no pairs
+            if (pBatch == NULL)
+            {
+                pBatch = SR_BamPipelineAcquire(pPipeline);
+                pBatch->refID = refID;
+            }
+
+            pBatch->status = SR_OUT_OF_RANGE;
+            SR_BamPipelinePush(pPipeline, pBatch);
+            pBatch = NULL;
+
+            refID = SR_BamInStreamGetNextRefID(pBamInStream);
+        }
+        else
+            break;
+    }
+
+    if (pBatch != NULL)
+        SR_BamPipelinePush(pPipeline, pBatch);
+
+    // one end marker for each consumer
+    for (unsigned int i = 0; i != pPipeline->numConsumers; ++i)
+    {
+        pBatch = SR_BamPipelineAcquire(pPipeline);
+        pBatch->status = (readerStatus == SR_EOF ? SR_EOF : SR_ERR);
+        SR_BamPipelinePush(pPipeline, pBatch);
+    }
+
+    return NULL;
+}
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_BamPipeline* SR_BamPipelineAlloc(SR_BamInStream* pBamInStream, unsigned int numConsumers, unsigned int batchSize,
+                                    double scTolerance, double maxMismatchRate, unsigned char minMQ)
+{
+    SR_BamPipeline* pPipeline = (SR_BamPipeline*) calloc(1, sizeof(SR_BamPipeline));
+    if (pPipeline == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for a bam pipeline object.\n");
+
+    if (numConsumers == 0)
+        numConsumers = 1;
+
+    if (batchSize == 0)
+        batchSize = DEFAULT_PAIR_BATCH_SIZE;
+
+    pPipeline->pBamInStream = pBamInStream;
+    pPipeline->numConsumers = numConsumers;
+    pPipeline->batchSize = batchSize;
+    pPipeline->scTolerance = scTolerance;
+    pPipeline->maxMismatchRate = maxMismatchRate;
+    pPipeline->minMQ = minMQ;
+    pPipeline->isStarted = FALSE;
+
+    pPipeline->numBatches = numConsumers * SR_BATCHES_PER_CONSUMER;
+    pPipeline->pBatches = (SR_PairBatch*) calloc(pPipeline->numBatches, sizeof(SR_PairBatch));
+    if (pPipeline->pBatches == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the batches in the bam pipeline object.\n");
+
+    // both queues can hold all the batches so that a push never waits
+    pPipeline->pWorkQueue = SR_LockFreeQueueAlloc(pPipeline->numBatches);
+    pPipeline->pRecycleQueue = SR_LockFreeQueueAlloc(pPipeline->numBatches);
+
+    if (sem_init(&(pPipeline->numWorkBatches), 0, 0) != 0 || sem_init(&(pPipeline->numFreeBatches), 0, pPipeline->numBatches) != 0)
+        SR_ErrSys("ERROR: Cannot initialize the semaphores of the bam pipeline object.\n");
+
+    for (unsigned int i = 0; i != pPipeline->numBatches; ++i)
+    {
+        SR_PairBatch* pBatch = pPipeline->pBatches + i;
+
+        pBatch->pAlgns = (SR_BamNode**) malloc(2 * batchSize * sizeof(SR_BamNode*));
+        pBatch->pAlgnTypes = (SR_AlgnType*) malloc(batchSize * sizeof(SR_AlgnType));
+        if (pBatch->pAlgns == NULL || pBatch->pAlgnTypes == NULL)
+            SR_ErrQuit("ERROR: Not enough memory for the read pairs in a batch.\n");
+
+        pBatch->numPairs = 0;
+        SR_LockFreeQueuePush(pPipeline->pRecycleQueue, pBatch);
+    }
+
+    return pPipeline;
+}
+
+void SR_BamPipelineFree(SR_BamPipeline* pPipeline)
+{
+    if (pPipeline != NULL)
+    {
+        if (pPipeline->isStarted)
+            pthread_join(pPipeline->reader, NULL);
+
+        // give the alignments of the returned batches back to the memory pool
+        SR_PairBatch* pBatch = NULL;
+        while ((pBatch = (SR_PairBatch*) SR_LockFreeQueuePop(pPipeline->pRecycleQueue)) != NULL)
+        {
+            for (unsigned int i = 0; i != 2 * pBatch->numPairs; ++i)
+                SR_BamInStreamRecycle(pPipeline->pBamInStream, pBatch->pAlgns[i]);
+        }
+
+        for (unsigned int i = 0; i != pPipeline->numBatches; ++i)
+        {
+            free(pPipeline->pBatches[i].pAlgns);
+            free(pPipeline->pBatches[i].pAlgnTypes);
+        }
+
+        sem_destroy(&(pPipeline->numWorkBatches));
+        sem_destroy(&(pPipeline->numFreeBatches));
+
+        SR_LockFreeQueueFree(pPipeline->pWorkQueue);
+        SR_LockFreeQueueFree(pPipeline->pRecycleQueue);
+
+        free(pPipeline->pBatches);
+        free(pPipeline);
+    }
+}
+
+
+//======================
+// Interface functions
+//======================
+
+SR_Status SR_BamPipelineStart(SR_BamPipeline* pPipeline)
+{
+    if (pPipeline->isStarted)
+        return SR_ERR;
+
+    if (pthread_create(&(pPipeline->reader), NULL, SR_BamPipelineRead, pPipeline) != 0)
+        return SR_ERR;
+
+    pPipeline->isStarted = TRUE;
+
+    return SR_OK;
+}
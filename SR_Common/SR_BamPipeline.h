@@ -0,0 +1,174 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_BamPipeline.h
+ *
+ *    Description:  reader/worker pipeline mode of the bam in stream
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:20:18 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SR_BAMPIPELINE_H
+#define  SR_BAMPIPELINE_H
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "SR_Types.h"
+#include "SR_BamInStream.h"
+#include "SR_LockFreeQueue.h"
+
+//===============================
+// Type and constant definition
+//===============================
+
+// default number of read pairs in a batch
+#define DEFAULT_PAIR_BATCH_SIZE 512
+
+// number of batches in flight for each consumer thread
+#define SR_BATCHES_PER_CONSUMER 4
+
+// a batch of classified read pairs handed to a consumer thread
+typedef struct SR_PairBatch
+{
+    SR_BamNode** pAlgns;         // alignments of the read pairs, the anchor of the i-th pair is at 2i and its mate is at 2i+1
+
+    SR_AlgnType* pAlgnTypes;     // alignment types of the read pairs
+
+    unsigned int numPairs;       // number of read pairs in the batch
+
+    int32_t refID;               // reference ID of the read pairs (a batch never crosses a chromosome),
+                                 // -1 if the chromosome has no alignment kept by the filter
+
+    SR_Status status;            // SR_OK: a batch of read pairs; SR_OUT_OF_RANGE: the last batch of a chromosome,
+                                 // possibly empty, one for each chromosome; SR_EOF/SR_ERR: end marker (no read pairs),
+                                 // each consumer gets exactly one
+
+}SR_PairBatch;
+
+// the pipeline. a reader thread owns the bam in stream and its memory pool.
+// it classifies the read pairs and pushes full batches into the work queue.
+// consumers pop the batches and return them through the recycle queue, where
+// the reader takes them back and returns their alignments to the memory pool.
+// the threads sleep on the semaphores while there is nothing to pop
+typedef struct SR_BamPipeline
+{
+    SR_BamInStream* pBamInStream;        // the bam in stream used by the reader thread
+
+    SR_LockFreeQueue* pWorkQueue;        // batches ready for the consumers (single producer, multiple consumers)
+
+    SR_LockFreeQueue* pRecycleQueue;     // batches returned by the consumers (multiple producers, single consumer)
+
+    sem_t numWorkBatches;                // number of batches in the work queue
+
+    sem_t numFreeBatches;                // number of batches in the recycle queue
+
+    SR_PairBatch* pBatches;              // storage of all the batches
+
+    unsigned int numBatches;             // number of batches
+
+    unsigned int batchSize;              // maximum number of read pairs in a batch
+
+    unsigned int numConsumers;           // number of consumer threads
+
+    double scTolerance;                  // soft clipping tolerance
+
+    double maxMismatchRate;              // maximum mismatch rate of a multiple aligned mate
+
+    unsigned char minMQ;                 // minimum mapping quality of an anchor
+
+    pthread_t reader;                    // the reader thread
+
+    SR_Bool isStarted;                   // boolean variable used to indicate if the reader thread is running
+
+}SR_BamPipeline;
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_BamPipeline* SR_BamPipelineAlloc(SR_BamInStream* pBamInStream, unsigned int numConsumers, unsigned int batchSize,
+                                    double scTolerance, double maxMismatchRate, unsigned char minMQ);
+
+void SR_BamPipelineFree(SR_BamPipeline* pPipeline);
+
+
+//======================
+// Interface functions
+//======================
+
+//==============================================================
+// function:
+//      start the reader thread
+//
+// args:
+//      1. pPipeline: a pointer to a pipeline
+//
+// return:
+//      SR_OK on success, SR_ERR if the thread cannot be created
+//
+// discussion:
+//      the bam in stream must be opened and its header loaded.
+//      the stream must not be used by any other thread until
+//      "SR_BamPipelineFree" is called
+//==============================================================
+SR_Status SR_BamPipelineStart(SR_BamPipeline* pPipeline);
+
+//==============================================================
+// function:
+//      get the next batch of read pairs (called by consumers)
+//
+// args:
+//      1. pPipeline: a pointer to a pipeline
+//
+// return:
+//      a batch of read pairs. a batch whose status is SR_EOF or
+//      SR_ERR is the end marker, the consumer should recycle it
+//      and stop
+//
+// discussion:
+//      the caller sleeps until a batch is ready. the batches
+//      are handed out in the order of the chromosomes, but with
+//      several consumers the SR_OUT_OF_RANGE batch of a
+//      chromosome does not order anything: the other batches
+//      of the chromosome may still be processed by the other
+//      consumers, and batches of the next chromosome may
+//      already be taken
+//==============================================================
+static inline SR_PairBatch* SR_BamPipelineGet(SR_BamPipeline* pPipeline)
+{
+    while (sem_wait(&(pPipeline->numWorkBatches)) != 0 && errno == EINTR)
+        continue;
+
+    return (SR_PairBatch*) SR_LockFreeQueueWaitPop(pPipeline->pWorkQueue);
+}
+
+//==============================================================
+// function:
+//      return a processed batch to the reader (called by
+//      consumers)
+//
+// args:
+//      1. pPipeline: a pointer to a pipeline
+//      2. pBatch   : a batch got from "SR_BamPipelineGet"
+//
+// discussion:
+//      the alignments in the batch must not be used afterwards
+//==============================================================
+static inline void SR_BamPipelineRecycle(SR_BamPipeline* pPipeline, SR_PairBatch* pBatch)
+{
+    SR_LockFreeQueueWaitPush(pPipeline->pRecycleQueue, pBatch);
+    sem_post(&(pPipeline->numFreeBatches));
+}
+
+#endif  /*SR_BAMPIPELINE_H*/
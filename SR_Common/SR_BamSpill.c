@@ -0,0 +1,419 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_BamSpill.c
+ *
+ *    Description:  temporary storage on disk for the unpaired alignments that
+ *                  do not fit into the memory pool
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:41:07 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "khash.h"
+#include "SR_Error.h"
+#include "SR_BamSpill.h"
+
+// header of an alignment record in a spill file. it is followed by
+// "dataLen" bytes of the variable-length data of the alignment
+typedef struct SR_SpillRecordHeader
+{
+    bam1_core_t core;
+
+    int32_t lAux;
+
+    int32_t dataLen;
+
+}SR_SpillRecordHeader;
+
+// read names of the spilled alignments sharing a fingerprint
+typedef struct SR_SpilledName
+{
+    struct SR_SpilledName* next;
+
+    char name[];
+
+}SR_SpilledName;
+
+KHASH_MAP_INIT_INT64(spillName, SR_SpilledName*);
+
+
+//===================
+// Static functions
+//===================
+
+// the low bits of a fingerprint are used by the name table, take the high ones
+static inline unsigned int SR_BamSpillGetPart(uint64_t fingerprint, unsigned int shift)
+{
+    return (unsigned int) (fingerprint >> shift) & (SR_SPILL_NUM_PARTS - 1);
+}
+
+// number of nodes the memory pool can still give out
+static uint64_t SR_BamSpillGetNumAvlNodes(const SR_BamMemPool* pMemPool)
+{
+    unsigned int maxBuffs = pMemPool->maxSize / pMemPool->buffCapacity;
+    if (maxBuffs == 0)
+        maxBuffs = 1;
+
+    uint64_t numAvlNodes = pMemPool->avlNodeList.numNode;
+    if (maxBuffs > pMemPool->numBuffs)
+        numAvlNodes += (uint64_t) (maxBuffs - pMemPool->numBuffs) * pMemPool->buffCapacity;
+
+    return numAvlNodes;
+}
+
+static void SR_BamSpillWrite(SR_SpillPart* pPart, const bam1_t* pAlignment)
+{
+    if (pPart->fpPart == NULL)
+    {
+        pPart->fpPart = tmpfile();
+        if (pPart->fpPart == NULL)
+            SR_ErrSys("ERROR: Cannot create a temporary file for the spilled alignments.\n");
+    }
+
+    SR_SpillRecordHeader header;
+    header.core = pAlignment->core;
+    header.lAux = pAlignment->l_aux;
+    header.dataLen = pAlignment->data_len;
+
+    if (fwrite(&header, sizeof(SR_SpillRecordHeader), 1, pPart->fpPart) != 1
+        || fwrite(pAlignment->data, 1, pAlignment->data_len, pPart->fpPart) != (size_t) pAlignment->data_len)
+    {
+        SR_ErrSys("ERROR: Cannot write the spilled alignments into a temporary file.\n");
+    }
+
+    ++(pPart->numRecords);
+}
+
+static void SR_BamSpillPutRecord(SR_BamSpill* pBamSpill, uint64_t fingerprint, const bam1_t* pAlignment)
+{
+    SR_BamSpillWrite(pBamSpill->parts + SR_BamSpillGetPart(fingerprint, 64 - SR_SPILL_PART_BITS), pAlignment);
+    ++(pBamSpill->numSpilled);
+}
+
+// read a spilled alignment, return 0 at the end of the partition
+static int SR_BamSpillRead(FILE* fpPart, bam1_t* pAlignment, SR_Bool isBorrowed)
+{
+    SR_SpillRecordHeader header;
+    if (fread(&header, sizeof(SR_SpillRecordHeader), 1, fpPart) != 1)
+        return 0;
+
+    if (pAlignment->m_data < header.dataLen)
+    {
+        pAlignment->m_data = header.dataLen;
+        kroundup32(pAlignment->m_data);
+
+        // a borrowed buffer is not ours to realloc
+        if (isBorrowed)
+            pAlignment->data = (uint8_t*) malloc(pAlignment->m_data);
+        else
+            pAlignment->data = (uint8_t*) realloc(pAlignment->data, pAlignment->m_data);
+
+        if (pAlignment->data == NULL)
+            SR_ErrQuit("ERROR: Not enough memory for a spilled alignment.\n");
+    }
+
+    pAlignment->core = header.core;
+    pAlignment->l_aux = header.lAux;
+    pAlignment->data_len = header.dataLen;
+
+    if (fread(pAlignment->data, 1, header.dataLen, fpPart) != (size_t) header.dataLen)
+        SR_ErrQuit("ERROR: The temporary file of the spilled alignments is truncated.\n");
+
+    return 1;
+}
+
+// close (and therefore delete) the temporary file of a partition
+static void SR_BamSpillDropPart(SR_SpillPart* pPart)
+{
+    if (pPart->fpPart != NULL)
+    {
+        fclose(pPart->fpPart);
+        pPart->fpPart = NULL;
+    }
+
+    pPart->numRecords = 0;
+    pPart->numRead = 0;
+}
+
+static void SR_BamSpillClearNames(SR_BamSpill* pBamSpill)
+{
+    khash_t(spillName)* pSpilledNames = pBamSpill->pSpilledNames;
+    for (khiter_t khIter = kh_begin(pSpilledNames); khIter != kh_end(pSpilledNames); ++khIter)
+    {
+        if (!kh_exist(pSpilledNames, khIter))
+            continue;
+
+        SR_SpilledName* pName = kh_value(pSpilledNames, khIter);
+        while (pName != NULL)
+        {
+            SR_SpilledName* pNext = pName->next;
+            free(pName);
+            pName = pNext;
+        }
+    }
+
+    kh_clear(spillName, pSpilledNames);
+}
+
+// replace the partition being merged with smaller partitions given by the next
+// bits of the fingerprint. the alignments of the partition still waiting for
+// their mates are written back with the rest of the partition
+static void SR_BamSpillSplit(SR_BamSpill* pBamSpill, SR_BamMemPool* pMemPool)
+{
+    SR_SpillPart oldPart = pBamSpill->mergeParts[pBamSpill->numMergeParts - 1];
+    --(pBamSpill->numMergeParts);
+
+    SR_SpillPart subParts[SR_SPILL_NUM_PARTS];
+    memset(subParts, 0, sizeof(subParts));
+
+    unsigned int shift = oldPart.shift - SR_SPILL_PART_BITS;
+    for (unsigned int i = 0; i != SR_SPILL_NUM_PARTS; ++i)
+        subParts[i].shift = shift;
+
+    for (SR_BamListIter iter = SR_BamListGetIter(&(pBamSpill->pendingList)); iter != NULL; iter = iter->next)
+    {
+        uint64_t fingerprint = SR_NameTableFingerprint(bam1_qname(&(iter->alignment)));
+        SR_BamSpillWrite(subParts + SR_BamSpillGetPart(fingerprint, shift), &(iter->alignment));
+    }
+
+    SR_NameTableClear(pBamSpill->pNameTable);
+    SR_BamListReset(&(pBamSpill->pendingList), pMemPool);
+
+    while (SR_BamSpillRead(oldPart.fpPart, pBamSpill->pSplitAlgn, FALSE) != 0)
+    {
+        uint64_t fingerprint = SR_NameTableFingerprint(bam1_qname(pBamSpill->pSplitAlgn));
+        SR_BamSpillWrite(subParts + SR_BamSpillGetPart(fingerprint, shift), pBamSpill->pSplitAlgn);
+    }
+
+    SR_BamSpillDropPart(&oldPart);
+
+    // the first sub-partition is merged first
+    for (unsigned int i = SR_SPILL_NUM_PARTS; i != 0; --i)
+    {
+        if (subParts[i - 1].numRecords != 0)
+        {
+            pBamSpill->mergeParts[pBamSpill->numMergeParts] = subParts[i - 1];
+            ++(pBamSpill->numMergeParts);
+        }
+    }
+}
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_BamSpill* SR_BamSpillAlloc(void)
+{
+    SR_BamSpill* pBamSpill = (SR_BamSpill*) calloc(1, sizeof(SR_BamSpill));
+    if (pBamSpill == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for a bam spill object.\n");
+
+    for (unsigned int i = 0; i != SR_SPILL_NUM_PARTS; ++i)
+        pBamSpill->parts[i].shift = 64 - SR_SPILL_PART_BITS;
+
+    pBamSpill->pSpilledNames = kh_init(spillName);
+    pBamSpill->pSplitAlgn = bam_init1();
+    pBamSpill->pNameTable = SR_NameTableAlloc(0);
+
+    return pBamSpill;
+}
+
+void SR_BamSpillFree(SR_BamSpill* pBamSpill, SR_BamMemPool* pMemPool)
+{
+    if (pBamSpill != NULL)
+    {
+        SR_BamSpillClear(pBamSpill, pMemPool);
+
+        kh_destroy(spillName, pBamSpill->pSpilledNames);
+        bam_destroy1(pBamSpill->pSplitAlgn);
+        SR_NameTableFree(pBamSpill->pNameTable);
+
+        free(pBamSpill);
+    }
+}
+
+
+//======================
+// Interface functions
+//======================
+
+void SR_BamSpillPut(SR_BamSpill* pBamSpill, uint64_t fingerprint, const bam1_t* pAlignment)
+{
+    const char* queryName = bam1_qname(pAlignment);
+    size_t nameLen = strlen(queryName) + 1;
+
+    SR_SpilledName* pName = (SR_SpilledName*) malloc(sizeof(SR_SpilledName) + nameLen);
+    if (pName == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the read name of a spilled alignment.\n");
+
+    memcpy(pName->name, queryName, nameLen);
+
+    int ret = 0;
+    khiter_t khIter = kh_put(spillName, pBamSpill->pSpilledNames, fingerprint, &ret);
+
+    // another spilled read name has the same fingerprint
+    pName->next = (ret == 0 ? kh_value((khash_t(spillName)*) pBamSpill->pSpilledNames, khIter) : NULL);
+    kh_value((khash_t(spillName)*) pBamSpill->pSpilledNames, khIter) = pName;
+
+    SR_BamSpillPutRecord(pBamSpill, fingerprint, pAlignment);
+}
+
+SR_Bool SR_BamSpillTakeMate(SR_BamSpill* pBamSpill, uint64_t fingerprint, const bam1_t* pAlignment)
+{
+    khash_t(spillName)* pSpilledNames = pBamSpill->pSpilledNames;
+    if (kh_size(pSpilledNames) == 0)
+        return FALSE;
+
+    khiter_t khIter = kh_get(spillName, pSpilledNames, fingerprint);
+    if (khIter == kh_end(pSpilledNames))
+        return FALSE;
+
+    const char* queryName = bam1_qname(pAlignment);
+    SR_SpilledName** ppName = &kh_value(pSpilledNames, khIter);
+    while (*ppName != NULL && strcmp((*ppName)->name, queryName) != 0)
+        ppName = &((*ppName)->next);
+
+    if (*ppName == NULL)
+        return FALSE;
+
+    SR_SpilledName* pName = *ppName;
+    (*ppName) = pName->next;
+    free(pName);
+
+    if (kh_value(pSpilledNames, khIter) == NULL)
+        kh_del(spillName, pSpilledNames, khIter);
+
+    SR_BamSpillPutRecord(pBamSpill, fingerprint, pAlignment);
+
+    return TRUE;
+}
+
+SR_Bool SR_BamSpillStartMerge(SR_BamSpill* pBamSpill)
+{
+    if (pBamSpill->numSpilled == 0)
+        return FALSE;
+
+    // the mates of the alignments left in the set will never come
+    SR_BamSpillClearNames(pBamSpill);
+
+    // the first partition is merged first
+    for (unsigned int i = SR_SPILL_NUM_PARTS; i != 0; --i)
+    {
+        SR_SpillPart* pPart = pBamSpill->parts + i - 1;
+        if (pPart->numRecords != 0)
+        {
+            pBamSpill->mergeParts[pBamSpill->numMergeParts] = *pPart;
+            ++(pBamSpill->numMergeParts);
+
+            pPart->fpPart = NULL;
+            pPart->numRecords = 0;
+        }
+    }
+
+    pBamSpill->numSpilled = 0;
+
+    return TRUE;
+}
+
+SR_Status SR_BamSpillLoadPair(SR_BamNode** ppUpAlgn, SR_BamNode** ppDownAlgn, SR_BamSpill* pBamSpill, SR_BamMemPool* pMemPool)
+{
+    (*ppUpAlgn) = NULL;
+    (*ppDownAlgn) = NULL;
+
+    while (pBamSpill->numMergeParts != 0)
+    {
+        SR_SpillPart* pPart = pBamSpill->mergeParts + pBamSpill->numMergeParts - 1;
+
+        if (pPart->numRead == 0)
+        {
+            rewind(pPart->fpPart);
+
+            // all the alignments of a partition may wait for their mates at the same time
+            if (pPart->numRecords > SR_BamSpillGetNumAvlNodes(pMemPool) && pPart->shift != 0)
+            {
+                SR_BamSpillSplit(pBamSpill, pMemPool);
+                continue;
+            }
+        }
+
+        SR_Bool isSplit = FALSE;
+        for (;;)
+        {
+            SR_BamNode* pNewNode = SR_BamNodeAlloc(pMemPool);
+            if (pNewNode == NULL)
+            {
+                // the nodes still held by the caller are not ours to take back
+                if (pPart->shift == 0 || pBamSpill->pendingList.numNode == 0)
+                    SR_ErrQuit("ERROR: Too many unpaired reads are stored in a partition of the spilled alignments.\n");
+
+                SR_BamSpillSplit(pBamSpill, pMemPool);
+                isSplit = TRUE;
+                break;
+            }
+
+            if (SR_BamSpillRead(pPart->fpPart, &(pNewNode->alignment), SR_BamNodeInSlab(pNewNode, pMemPool->buffCapacity)) == 0)
+            {
+                SR_BamNodeFree(pNewNode, pMemPool);
+                break;
+            }
+
+            ++(pPart->numRead);
+
+            uint64_t fingerprint = SR_NameTableFingerprint(bam1_qname(&(pNewNode->alignment)));
+            SR_BamNode* pMate = SR_NameTableTakeOrPut(pBamSpill->pNameTable, fingerprint, pNewNode);
+
+            if (pMate != NULL)
+            {
+                SR_BamListRemove(&(pBamSpill->pendingList), pMate);
+
+                (*ppUpAlgn) = pMate;
+                (*ppDownAlgn) = pNewNode;
+
+                return SR_OK;
+            }
+
+            SR_BamListPushHead(&(pBamSpill->pendingList), pNewNode);
+        }
+
+        if (isSplit)
+            continue;
+
+        // the alignments left in this partition have no mate
+        SR_NameTableClear(pBamSpill->pNameTable);
+        SR_BamListReset(&(pBamSpill->pendingList), pMemPool);
+        SR_BamSpillDropPart(pPart);
+
+        --(pBamSpill->numMergeParts);
+    }
+
+    return SR_EOF;
+}
+
+void SR_BamSpillClear(SR_BamSpill* pBamSpill, SR_BamMemPool* pMemPool)
+{
+    for (unsigned int i = 0; i != SR_SPILL_NUM_PARTS; ++i)
+        SR_BamSpillDropPart(pBamSpill->parts + i);
+
+    for (unsigned int i = 0; i != pBamSpill->numMergeParts; ++i)
+        SR_BamSpillDropPart(pBamSpill->mergeParts + i);
+
+    pBamSpill->numMergeParts = 0;
+    pBamSpill->numSpilled = 0;
+
+    SR_BamSpillClearNames(pBamSpill);
+
+    SR_NameTableClear(pBamSpill->pNameTable);
+    SR_BamListReset(&(pBamSpill->pendingList), pMemPool);
+}
@@ -0,0 +1,190 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_BamSpill.h
+ *
+ *    Description:  temporary storage on disk for the unpaired alignments that
+ *                  do not fit into the memory pool
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:41:07 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SR_BAMSPILL_H
+#define  SR_BAMSPILL_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "bam.h"
+#include "SR_Types.h"
+#include "SR_BamMemPool.h"
+#include "SR_NameTable.h"
+
+//===============================
+// Type and constant definition
+//===============================
+
+// number of bits of the fingerprint used to choose a partition
+#define SR_SPILL_PART_BITS 4
+
+// number of partitions of the spill files. an alignment goes to the partition
+// given by the fingerprint of its read name so that both mates of a pair end
+// up in the same partition and the partitions can be merged one at a time
+#define SR_SPILL_NUM_PARTS (1 << SR_SPILL_PART_BITS)
+
+// maximum number of partitions waiting to be merged. a partition that does not
+// fit into the memory pool is split with the next bits of the fingerprint
+#define SR_SPILL_MAX_MERGE_PARTS (SR_SPILL_NUM_PARTS * (64 / SR_SPILL_PART_BITS))
+
+typedef struct SR_SpillPart
+{
+    FILE* fpPart;                              // temporary file of the partition (opened on demand)
+
+    uint64_t numRecords;                       // number of alignments written into the partition
+
+    uint64_t numRead;                          // number of alignments read from the partition in the merge
+
+    unsigned int shift;                        // the partition of an alignment is given by the bits of its fingerprint from this one
+
+}SR_SpillPart;
+
+typedef struct SR_BamSpill
+{
+    SR_SpillPart parts[SR_SPILL_NUM_PARTS];    // partitions the alignments are written into
+
+    SR_SpillPart mergeParts[SR_SPILL_MAX_MERGE_PARTS];   // partitions waiting to be merged, the last one is being merged
+
+    unsigned int numMergeParts;                // number of partitions waiting to be merged
+
+    uint64_t numSpilled;                       // number of alignments in all the partitions
+
+    void* pSpilledNames;                       // read names of the spilled alignments whose mates have not been read yet
+
+    bam1_t* pSplitAlgn;                        // buffer used to split a partition
+
+    SR_NameTable* pNameTable;                  // read name table used to pair the alignments of a partition
+
+    SR_BamList pendingList;                    // alignments of the current partition waiting for their mates
+
+}SR_BamSpill;
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_BamSpill* SR_BamSpillAlloc(void);
+
+void SR_BamSpillFree(SR_BamSpill* pBamSpill, SR_BamMemPool* pMemPool);
+
+
+//======================
+// Interface functions
+//======================
+
+//==============================================================
+// function:
+//      write an alignment whose mate has not been read yet
+//      into the spill
+//
+// args:
+//      1. pBamSpill  : a pointer to a spill object
+//      2. fingerprint: fingerprint of the read name
+//      3. pAlignment : the alignment
+//
+// discussion:
+//      the read name is remembered so that the mate is sent
+//      to the spill as well once it is read (see
+//      "SR_BamSpillTakeMate")
+//==============================================================
+void SR_BamSpillPut(SR_BamSpill* pBamSpill, uint64_t fingerprint, const bam1_t* pAlignment);
+
+//==============================================================
+// function:
+//      write an alignment into the spill if its mate has been
+//      spilled
+//
+// args:
+//      1. pBamSpill  : a pointer to a spill object
+//      2. fingerprint: fingerprint of the read name
+//      3. pAlignment : the alignment
+//
+// return:
+//      TRUE if the alignment is written into the spill,
+//      FALSE if its mate is not in the spill
+//
+// discussion:
+//      the fingerprint only selects the candidates, the read
+//      names are compared to confirm the mate
+//==============================================================
+SR_Bool SR_BamSpillTakeMate(SR_BamSpill* pBamSpill, uint64_t fingerprint, const bam1_t* pAlignment);
+
+//==============================================================
+// function:
+//      start to merge the spilled alignments
+//
+// args:
+//      1. pBamSpill: a pointer to a spill object
+//
+// return:
+//      TRUE if there is any alignment in the spill, else FALSE
+//
+// discussion:
+//      no alignment should be written into the spill until
+//      "SR_BamSpillLoadPair" returns SR_EOF
+//==============================================================
+SR_Bool SR_BamSpillStartMerge(SR_BamSpill* pBamSpill);
+
+#define SR_BamSpillIsMerging(pBamSpill) ((pBamSpill)->numMergeParts != 0)
+
+//==============================================================
+// function:
+//      load the next pair of alignments from the spill
+//
+// args:
+//      1. ppUpAlgn  : a pointer to the pointer of the alignment
+//                     spilled first
+//      2. ppDownAlgn: a pointer to the pointer of its mate
+//      3. pBamSpill : a pointer to a spill object
+//      4. pMemPool  : memory pool the bam nodes are taken from
+//
+// return:
+//      SR_OK if a pair is found; SR_EOF if all the partitions
+//      are merged, the spill is then empty and ready to be
+//      used again
+//
+// discussion:
+//      the partitions are read one at a time, only the
+//      alignments of one partition that are still waiting for
+//      their mates are kept in memory. a partition with more
+//      alignments than the pool can still hold, or one that
+//      runs the pool out in the merge, is split into smaller
+//      partitions with the next bits of the fingerprint. the
+//      returned nodes are recycled by the caller as those from
+//      the bam in stream.
+//
+//      the pairs come out in the order of the partitions, not
+//      in the coordinate order. they follow all the pairs of
+//      the same chromosome that were paired in memory
+//==============================================================
+SR_Status SR_BamSpillLoadPair(SR_BamNode** ppUpAlgn, SR_BamNode** ppDownAlgn, SR_BamSpill* pBamSpill, SR_BamMemPool* pMemPool);
+
+//==============================================================
+// function:
+//      discard all the alignments in the spill
+//
+// args:
+//      1. pBamSpill: a pointer to a spill object
+//      2. pMemPool : memory pool the bam nodes are taken from
+//==============================================================
+void SR_BamSpillClear(SR_BamSpill* pBamSpill, SR_BamMemPool* pMemPool);
+
+#endif  /*SR_BAMSPILL_H*/
@@ -0,0 +1,144 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_LockFreeQueue.c
+ *
+ *    Description:  bounded lock-free multi-producer/multi-consumer queue
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:20:18 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <sched.h>
+
+#include "SR_Error.h"
+#include "SR_LockFreeQueue.h"
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_LockFreeQueue* SR_LockFreeQueueAlloc(size_t capacity)
+{
+    SR_LockFreeQueue* pQueue = (SR_LockFreeQueue*) calloc(1, sizeof(SR_LockFreeQueue));
+    if (pQueue == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for a lock-free queue object.\n");
+
+    // round the capacity up to a power of two
+    size_t realCap = 2;
+    while (realCap < capacity)
+        realCap <<= 1;
+
+    pQueue->cells = (SR_QueueCell*) malloc(realCap * sizeof(SR_QueueCell));
+    if (pQueue->cells == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the slots in the lock-free queue object.\n");
+
+    for (size_t i = 0; i != realCap; ++i)
+    {
+        pQueue->cells[i].seq = i;
+        pQueue->cells[i].data = NULL;
+    }
+
+    pQueue->mask = realCap - 1;
+    pQueue->enqPos = 0;
+    pQueue->deqPos = 0;
+
+    return pQueue;
+}
+
+void SR_LockFreeQueueFree(SR_LockFreeQueue* pQueue)
+{
+    if (pQueue != NULL)
+    {
+        free(pQueue->cells);
+        free(pQueue);
+    }
+}
+
+
+//======================
+// Interface functions
+//======================
+
+SR_Bool SR_LockFreeQueuePush(SR_LockFreeQueue* pQueue, void* data)
+{
+    SR_QueueCell* pCell = NULL;
+    size_t pos = __atomic_load_n(&(pQueue->enqPos), __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        pCell = pQueue->cells + (pos & pQueue->mask);
+        size_t seq = __atomic_load_n(&(pCell->seq), __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+
+        if (diff == 0)
+        {
+            // the slot is free, try to claim it
+            if (__atomic_compare_exchange_n(&(pQueue->enqPos), &pos, pos + 1, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (diff < 0)
+            return FALSE;
+        else
+            pos = __atomic_load_n(&(pQueue->enqPos), __ATOMIC_RELAXED);
+    }
+
+    pCell->data = data;
+    __atomic_store_n(&(pCell->seq), pos + 1, __ATOMIC_RELEASE);
+
+    return TRUE;
+}
+
+void* SR_LockFreeQueuePop(SR_LockFreeQueue* pQueue)
+{
+    SR_QueueCell* pCell = NULL;
+    size_t pos = __atomic_load_n(&(pQueue->deqPos), __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        pCell = pQueue->cells + (pos & pQueue->mask);
+        size_t seq = __atomic_load_n(&(pCell->seq), __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t) seq - (intptr_t) (pos + 1);
+
+        if (diff == 0)
+        {
+            // the slot is filled, try to claim it
+            if (__atomic_compare_exchange_n(&(pQueue->deqPos), &pos, pos + 1, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (diff < 0)
+            return NULL;
+        else
+            pos = __atomic_load_n(&(pQueue->deqPos), __ATOMIC_RELAXED);
+    }
+
+    void* data = pCell->data;
+    __atomic_store_n(&(pCell->seq), pos + pQueue->mask + 1, __ATOMIC_RELEASE);
+
+    return data;
+}
+
+void SR_LockFreeQueueWaitPush(SR_LockFreeQueue* pQueue, void* data)
+{
+    while (!SR_LockFreeQueuePush(pQueue, data))
+        sched_yield();
+}
+
+void* SR_LockFreeQueueWaitPop(SR_LockFreeQueue* pQueue)
+{
+    void* data = NULL;
+    while ((data = SR_LockFreeQueuePop(pQueue)) == NULL)
+        sched_yield();
+
+    return data;
+}
@@ -0,0 +1,123 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_LockFreeQueue.h
+ *
+ *    Description:  bounded lock-free multi-producer/multi-consumer queue
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:20:18 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SR_LOCKFREEQUEUE_H
+#define  SR_LOCKFREEQUEUE_H
+
+#include <stddef.h>
+
+#include "SR_Types.h"
+
+//===============================
+// Type and constant definition
+//===============================
+
+// size of a cache line, used to keep the producer and consumer positions apart
+#define SR_CACHE_LINE_SIZE 64
+
+// a slot in the queue
+typedef struct SR_QueueCell
+{
+    size_t seq;                 // sequence number telling if the slot is ready for a producer or a consumer
+
+    void* data;                 // the element stored in the slot
+
+}SR_QueueCell;
+
+// bounded queue with a power-of-two capacity. the slots carry sequence
+// numbers so that producers and consumers only contend on their own position
+typedef struct SR_LockFreeQueue
+{
+    SR_QueueCell* cells;                                          // slots of the queue
+
+    size_t mask;                                                  // capacity - 1
+
+    char pad0[SR_CACHE_LINE_SIZE];
+
+    size_t enqPos;                                                // position of the next push
+
+    char pad1[SR_CACHE_LINE_SIZE];
+
+    size_t deqPos;                                                // position of the next pop
+
+    char pad2[SR_CACHE_LINE_SIZE];
+
+}SR_LockFreeQueue;
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_LockFreeQueue* SR_LockFreeQueueAlloc(size_t capacity);
+
+void SR_LockFreeQueueFree(SR_LockFreeQueue* pQueue);
+
+
+//======================
+// Interface functions
+//======================
+
+//==============================================================
+// function:
+//      push an element into the queue
+//
+// args:
+//      1. pQueue: a pointer to a lock-free queue
+//      2. data  : the element to be pushed
+//
+// return:
+//      TRUE on success, FALSE if the queue is full
+//
+// discussion:
+//      can be called by any number of threads at the same time
+//==============================================================
+SR_Bool SR_LockFreeQueuePush(SR_LockFreeQueue* pQueue, void* data);
+
+//==============================================================
+// function:
+//      pop an element from the queue
+//
+// args:
+//      1. pQueue: a pointer to a lock-free queue
+//
+// return:
+//      the oldest element in the queue, NULL if the queue is
+//      empty
+//
+// discussion:
+//      can be called by any number of threads at the same time.
+//      NULL can not be stored in the queue
+//==============================================================
+void* SR_LockFreeQueuePop(SR_LockFreeQueue* pQueue);
+
+//==============================================================
+// function:
+//      push an element, yielding the processor while the queue
+//      is full
+//==============================================================
+void SR_LockFreeQueueWaitPush(SR_LockFreeQueue* pQueue, void* data);
+
+//==============================================================
+// function:
+//      pop an element, yielding the processor while the queue
+//      is empty
+//==============================================================
+void* SR_LockFreeQueueWaitPop(SR_LockFreeQueue* pQueue);
+
+#endif  /*SR_LOCKFREEQUEUE_H*/
@@ -0,0 +1,161 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_MemPlan.c
+ *
+ *    Description:  choose the bin lengths and the memory pool sizes of the bam
+ *                  in streams under a memory budget
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:44:44 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+
+#include "SR_Error.h"
+#include "SR_NameTable.h"
+#include "SR_MemPlan.h"
+
+// memory taken by an alignment waiting in a stream: the node, its payload
+// slot and its entries in the name table (kept under half full). a payload
+// longer than the slot is moved to the heap and is not counted
+#define SR_MEM_PLAN_NODE_SIZE (sizeof(SR_BamNode) + SR_BAM_DATA_SLOT_SIZE + 2 * sizeof(SR_NameSlot))
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_MemPlan* SR_MemPlanAlloc(uint64_t memLimit, unsigned int numStreams)
+{
+    SR_MemPlan* pMemPlan = (SR_MemPlan*) calloc(1, sizeof(SR_MemPlan));
+    if (pMemPlan == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for a memory plan object.\n");
+
+    if (numStreams == 0)
+        numStreams = 1;
+
+    pMemPlan->memLimit = memLimit;
+    pMemPlan->numStreams = numStreams;
+
+    uint64_t maxPoolSize = memLimit / numStreams / SR_MEM_PLAN_NODE_SIZE;
+    if (maxPoolSize > SR_MAX_MEM_POOL_SIZE)
+        maxPoolSize = SR_MAX_MEM_POOL_SIZE;
+    else if (maxPoolSize < SR_MEM_PLAN_MIN_BUFF_CAP)
+    {
+        maxPoolSize = SR_MEM_PLAN_MIN_BUFF_CAP;
+        SR_ErrMsg("WARNING: The memory limit is too small. Each bam input stream will keep at least %u alignments.\n", SR_MEM_PLAN_MIN_BUFF_CAP);
+    }
+
+    pMemPlan->maxPoolSize = maxPoolSize;
+
+    pMemPlan->buffCapacity = pMemPlan->maxPoolSize / SR_MEM_PLAN_NUM_BUFFS;
+    if (pMemPlan->buffCapacity < SR_MEM_PLAN_MIN_BUFF_CAP)
+        pMemPlan->buffCapacity = SR_MEM_PLAN_MIN_BUFF_CAP;
+    else if (pMemPlan->buffCapacity > SR_MEM_PLAN_MAX_BUFF_CAP)
+        pMemPlan->buffCapacity = SR_MEM_PLAN_MAX_BUFF_CAP;
+
+    pMemPlan->firstRefID = 0;
+
+    return pMemPlan;
+}
+
+void SR_MemPlanFree(SR_MemPlan* pMemPlan)
+{
+    if (pMemPlan != NULL)
+    {
+        free(pMemPlan->pBinLens);
+        free(pMemPlan->pNumBuffs);
+
+        free(pMemPlan);
+    }
+}
+
+
+//======================
+// Interface functions
+//======================
+
+void SR_MemPlanSet(SR_MemPlan* pMemPlan, const bam_index_t* pBamIndex, const bam_header_t* pHeader, uint32_t binLen, uint32_t fragLenHigh)
+{
+    uint32_t numChr = pHeader->n_targets;
+    if (numChr > pMemPlan->capacity)
+    {
+        free(pMemPlan->pBinLens);
+        free(pMemPlan->pNumBuffs);
+
+        pMemPlan->pBinLens = (uint32_t*) malloc(numChr * sizeof(uint32_t));
+        pMemPlan->pNumBuffs = (uint32_t*) malloc(numChr * sizeof(uint32_t));
+        if (pMemPlan->pBinLens == NULL || pMemPlan->pNumBuffs == NULL)
+            SR_ErrQuit("ERROR: Not enough memory for the storage of the memory plan.\n");
+
+        pMemPlan->capacity = numChr;
+    }
+
+    pMemPlan->numChr = numChr;
+    pMemPlan->firstRefID = -1;
+
+    uint32_t wantedBinLen = (binLen > fragLenHigh ? binLen : fragLenHigh);
+    uint32_t maxNumBuffs = (pMemPlan->maxPoolSize + pMemPlan->buffCapacity - 1) / pMemPlan->buffCapacity;
+
+    for (uint32_t i = 0; i != numChr; ++i)
+    {
+        uint64_t numMapped = 0;
+        uint64_t numUnmapped = 0;
+
+        pMemPlan->pBinLens[i] = wantedBinLen;
+        pMemPlan->pNumBuffs[i] = maxNumBuffs;
+
+        if (pBamIndex == NULL || bam_index_get_stat(pBamIndex, i, &numMapped, &numUnmapped) != 0)
+        {
+            if (pMemPlan->firstRefID < 0)
+                pMemPlan->firstRefID = i;
+
+            continue;
+        }
+
+        if (numMapped == 0 || pHeader->target_len[i] == 0)
+            continue;
+
+        if (pMemPlan->firstRefID < 0)
+            pMemPlan->firstRefID = i;
+
+        // the alignments of the previous and the current bins may wait in the pool
+        double density = (double) numMapped / pHeader->target_len[i];
+        double fitBinLen = pMemPlan->maxPoolSize / (2.0 * density);
+
+        if (fitBinLen < wantedBinLen)
+            pMemPlan->pBinLens[i] = (fitBinLen > SR_MEM_PLAN_MIN_BIN_LEN ? (uint32_t) fitBinLen : SR_MEM_PLAN_MIN_BIN_LEN);
+
+        double numNodes = 2.0 * density * pMemPlan->pBinLens[i];
+        if (numNodes < pMemPlan->maxPoolSize)
+            pMemPlan->pNumBuffs[i] = (uint32_t) (numNodes / pMemPlan->buffCapacity) + 1;
+    }
+
+    if (pMemPlan->firstRefID < 0)
+        pMemPlan->firstRefID = 0;
+}
+
+uint32_t SR_MemPlanApply(const SR_MemPlan* pMemPlan, SR_BamInStream* pBamInStream, int32_t refID)
+{
+    if (pMemPlan->numChr == 0)
+        return pBamInStream->binLen;
+
+    if (refID < 0 || (uint32_t) refID >= pMemPlan->numChr)
+        refID = pMemPlan->firstRefID;
+
+    SR_BamInStreamSetBinLen(pBamInStream, pMemPlan->pBinLens[refID]);
+    SR_BamInStreamSetMaxPoolSize(pBamInStream, pMemPlan->maxPoolSize);
+
+    // release the buffers left by a denser chromosome
+    SR_BamInStreamShrinkPool(pBamInStream, pMemPlan->pNumBuffs[refID]);
+
+    return pMemPlan->pBinLens[refID];
+}
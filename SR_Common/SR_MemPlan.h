@@ -0,0 +1,155 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_MemPlan.h
+ *
+ *    Description:  choose the bin lengths and the memory pool sizes of the bam
+ *                  in streams under a memory budget
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:44:44 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SR_MEMPLAN_H
+#define  SR_MEMPLAN_H
+
+#include <stdint.h>
+
+#include "bam.h"
+#include "SR_Types.h"
+#include "SR_BamInStream.h"
+
+//===============================
+// Type and constant definition
+//===============================
+
+// the smallest bin length chosen by the planner. denser chromosomes
+// rely on the spill of the bam in stream instead of smaller bins
+#define SR_MEM_PLAN_MIN_BIN_LEN 1000
+
+// range of the number of alignments in a buffer of the memory pool
+#define SR_MEM_PLAN_MIN_BUFF_CAP 100
+#define SR_MEM_PLAN_MAX_BUFF_CAP 8192
+
+// the memory pool is planned to reach its maximum size in this many buffers
+#define SR_MEM_PLAN_NUM_BUFFS 64
+
+// memory plan of the bam in streams. all the streams share the same plan
+typedef struct SR_MemPlan
+{
+    uint64_t memLimit;            // memory budget in bytes for the memory pools of all the streams
+
+    unsigned int numStreams;      // number of streams running at the same time
+
+    unsigned int buffCapacity;    // number of alignments in each buffer of a memory pool
+
+    unsigned int maxPoolSize;     // maximum number of alignments in the memory pool of a stream
+
+    uint32_t* pBinLens;           // bin length of each chromosome
+
+    uint32_t* pNumBuffs;          // number of buffers a stream is expected to need on each chromosome
+
+    int32_t firstRefID;           // the first chromosome with mapped reads
+
+    uint32_t numChr;              // number of chromosomes in the plan
+
+    uint32_t capacity;            // capacity of the per-chromosome arrays
+
+}SR_MemPlan;
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+//==============================================================
+// function:
+//      create a memory plan
+//
+// args:
+//      1. memLimit  : memory budget in bytes for buffering the
+//                     alignments of all the streams
+//      2. numStreams: number of streams running at the same time
+//
+// return:
+//      a pointer to a memory plan. the buffer capacity and the
+//      maximum size of the memory pools are fixed here, the bin
+//      lengths are set by "SR_MemPlanSet"
+//
+// discussion:
+//      the budget only covers the nodes of the memory pools: the
+//      node, its payload slot of SR_BAM_DATA_SLOT_SIZE bytes and
+//      its entries in the name tables. it does not cover the
+//      payloads longer than the slot, which are moved to the
+//      heap, the deferred mates of the filter (up to
+//      SR_MAX_DEFERRED_MATES for each stream), the read names
+//      kept by the spill of a stream or the read pair tables of
+//      the shards. the process may therefore use more memory
+//      than the budget
+//==============================================================
+SR_MemPlan* SR_MemPlanAlloc(uint64_t memLimit, unsigned int numStreams);
+
+void SR_MemPlanFree(SR_MemPlan* pMemPlan);
+
+
+//======================
+// Interface functions
+//======================
+
+//==============================================================
+// function:
+//      plan the bin length and the pool size of each chromosome
+//      of a bam file
+//
+// args:
+//      1. pMemPlan   : a pointer to a memory plan
+//      2. pBamIndex  : index of the bam file (NULL if there is
+//                      none)
+//      3. pHeader    : header of the bam file
+//      4. binLen     : the requested bin length
+//      5. fragLenHigh: the longest normal fragment length of the
+//                      libraries (0 if it is unknown yet)
+//
+// discussion:
+//      the bins are as long as the requested bin length and the
+//      longest normal fragment so that normal mates are paired
+//      in memory. the number of mapped reads in the index tells
+//      how many alignments two bins of a chromosome may hold.
+//      if they do not fit into the pool, the bins of that
+//      chromosome are shortened (down to SR_MEM_PLAN_MIN_BIN_LEN)
+//      and the mates farther apart are loaded through the index.
+//      without the numbers in the index every chromosome gets
+//      the longest bins and the pool size is only capped
+//==============================================================
+void SR_MemPlanSet(SR_MemPlan* pMemPlan, const bam_index_t* pBamIndex, const bam_header_t* pHeader, uint32_t binLen, uint32_t fragLenHigh);
+
+//==============================================================
+// function:
+//      apply the plan of a chromosome to a bam in stream
+//
+// args:
+//      1. pMemPlan    : a pointer to a memory plan
+//      2. pBamInStream: a pointer to a bam in stream
+//      3. refID       : the chromosome the stream is about to
+//                       read (-1 for the first chromosome of the
+//                       file)
+//
+// return:
+//      the bin length set to the stream, which should also be
+//      set to the filter data of the stream
+//
+// discussion:
+//      this should be called before the first alignment of the
+//      chromosome is loaded. the buffers the chromosome is not
+//      expected to need are released
+//==============================================================
+uint32_t SR_MemPlanApply(const SR_MemPlan* pMemPlan, SR_BamInStream* pBamInStream, int32_t refID);
+
+#endif  /*SR_MEMPLAN_H*/
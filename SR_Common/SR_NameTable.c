@@ -0,0 +1,236 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_NameTable.c
+ *
+ *    Description:  fingerprint-keyed read name table used to pair the mates
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:26:15 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SR_Error.h"
+#include "SR_NameTable.h"
+
+// maximum load factor (used slots / capacity) before the table is rebuilt
+#define SR_NAME_TABLE_MAX_LOAD 0.7
+
+
+//===================
+// Static functions
+//===================
+
+static inline SR_Bool SR_NameSlotIsUsed(const SR_NameTable* pNameTable, const SR_NameSlot* pSlot)
+{
+    return (pSlot->gen == pNameTable->gen);
+}
+
+// rebuild the table with the given capacity, dropping the deleted entries
+static void SR_NameTableRehash(SR_NameTable* pNameTable, uint32_t newCapacity)
+{
+    SR_NameSlot* oldSlots = pNameTable->slots;
+    uint32_t oldCapacity = pNameTable->capacity;
+    uint32_t oldGen = pNameTable->gen;
+
+    pNameTable->slots = (SR_NameSlot*) calloc(newCapacity, sizeof(SR_NameSlot));
+    if (pNameTable->slots == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the slots in the name table object.\n");
+
+    pNameTable->capacity = newCapacity;
+    pNameTable->gen = 1;
+    pNameTable->size = 0;
+    pNameTable->numUsed = 0;
+
+    uint32_t mask = newCapacity - 1;
+    for (uint32_t i = 0; i != oldCapacity; ++i)
+    {
+        if (oldSlots[i].gen != oldGen || oldSlots[i].pNode == NULL)
+            continue;
+
+        uint32_t pos = (uint32_t) oldSlots[i].fingerprint & mask;
+        while (pNameTable->slots[pos].gen == pNameTable->gen)
+            pos = (pos + 1) & mask;
+
+        pNameTable->slots[pos] = oldSlots[i];
+        pNameTable->slots[pos].gen = pNameTable->gen;
+
+        ++(pNameTable->size);
+        ++(pNameTable->numUsed);
+    }
+
+    free(oldSlots);
+}
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_NameTable* SR_NameTableAlloc(uint32_t capacity)
+{
+    SR_NameTable* pNameTable = (SR_NameTable*) malloc(sizeof(SR_NameTable));
+    if (pNameTable == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for a name table object.\n");
+
+    if (capacity == 0)
+        capacity = DEFAULT_NAME_TABLE_CAPACITY;
+
+    // round the capacity up to a power of two
+    uint32_t realCap = 16;
+    while (realCap < capacity)
+        realCap <<= 1;
+
+    // slots with generation 0 are never used
+    pNameTable->slots = (SR_NameSlot*) calloc(realCap, sizeof(SR_NameSlot));
+    if (pNameTable->slots == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the slots in the name table object.\n");
+
+    pNameTable->capacity = realCap;
+    pNameTable->size = 0;
+    pNameTable->numUsed = 0;
+    pNameTable->gen = 1;
+
+    return pNameTable;
+}
+
+void SR_NameTableFree(SR_NameTable* pNameTable)
+{
+    if (pNameTable != NULL)
+    {
+        free(pNameTable->slots);
+        free(pNameTable);
+    }
+}
+
+
+//======================
+// Interface functions
+//======================
+
+uint64_t SR_NameTableFingerprint(const char* queryName)
+{
+    // FNV-1a followed by the 64-bit finalizer of murmur3 so that
+    // the low bits used as the slot index are well mixed
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char* pChar = (const unsigned char*) queryName; *pChar != '\0'; ++pChar)
+    {
+        hash ^= *pChar;
+        hash *= 0x100000001b3ULL;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+void SR_NameTableClear(SR_NameTable* pNameTable)
+{
+    ++(pNameTable->gen);
+
+    // the generation wraps around, really clean the slots
+    if (pNameTable->gen == 0)
+    {
+        memset(pNameTable->slots, 0, pNameTable->capacity * sizeof(SR_NameSlot));
+        pNameTable->gen = 1;
+    }
+
+    pNameTable->size = 0;
+    pNameTable->numUsed = 0;
+}
+
+SR_BamNode* SR_NameTableTake(SR_NameTable* pNameTable, uint64_t fingerprint, const char* queryName)
+{
+    if (pNameTable->size == 0)
+        return NULL;
+
+    uint32_t mask = pNameTable->capacity - 1;
+    uint32_t pos = (uint32_t) fingerprint & mask;
+
+    SR_NameSlot* pSlot = pNameTable->slots + pos;
+    while (SR_NameSlotIsUsed(pNameTable, pSlot))
+    {
+        if (pSlot->fingerprint == fingerprint && pSlot->pNode != NULL
+            && strcmp(bam1_qname(&(pSlot->pNode->alignment)), queryName) == 0)
+        {
+            SR_BamNode* pMate = pSlot->pNode;
+            pSlot->pNode = NULL;
+            --(pNameTable->size);
+
+            return pMate;
+        }
+
+        pos = (pos + 1) & mask;
+        pSlot = pNameTable->slots + pos;
+    }
+
+    return NULL;
+}
+
+SR_BamNode* SR_NameTableTakeOrPut(SR_NameTable* pNameTable, uint64_t fingerprint, SR_BamNode* pNode)
+{
+    // keep at least one empty slot so that a probe always ends
+    if (pNameTable->numUsed + 1 > (uint32_t) (pNameTable->capacity * SR_NAME_TABLE_MAX_LOAD))
+    {
+        uint32_t newCapacity = pNameTable->capacity;
+        if (pNameTable->size + 1 > (uint32_t) (pNameTable->capacity * SR_NAME_TABLE_MAX_LOAD / 2))
+            newCapacity <<= 1;
+
+        SR_NameTableRehash(pNameTable, newCapacity);
+    }
+
+    const char* queryName = bam1_qname(&(pNode->alignment));
+    uint32_t mask = pNameTable->capacity - 1;
+    uint32_t pos = (uint32_t) fingerprint & mask;
+
+    SR_NameSlot* pDeleted = NULL;
+    SR_NameSlot* pSlot = pNameTable->slots + pos;
+    while (SR_NameSlotIsUsed(pNameTable, pSlot))
+    {
+        if (pSlot->pNode == NULL)
+        {
+            if (pDeleted == NULL)
+                pDeleted = pSlot;
+        }
+        else if (pSlot->fingerprint == fingerprint
+                 && strcmp(bam1_qname(&(pSlot->pNode->alignment)), queryName) == 0)
+        {
+            SR_BamNode* pMate = pSlot->pNode;
+            pSlot->pNode = NULL;
+            --(pNameTable->size);
+
+            return pMate;
+        }
+
+        pos = (pos + 1) & mask;
+        pSlot = pNameTable->slots + pos;
+    }
+
+    // reuse a deleted entry on the probe path if there is one
+    if (pDeleted != NULL)
+        pSlot = pDeleted;
+    else
+    {
+        pSlot->gen = pNameTable->gen;
+        ++(pNameTable->numUsed);
+    }
+
+    pSlot->fingerprint = fingerprint;
+    pSlot->pNode = pNode;
+    ++(pNameTable->size);
+
+    return NULL;
+}
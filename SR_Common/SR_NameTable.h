@@ -0,0 +1,132 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_NameTable.h
+ *
+ *    Description:  fingerprint-keyed read name table used to pair the mates
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:26:15 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SR_NAMETABLE_H
+#define  SR_NAMETABLE_H
+
+#include <stdint.h>
+
+#include "SR_Types.h"
+#include "SR_BamMemPool.h"
+
+//===============================
+// Type and constant definition
+//===============================
+
+// default number of slots in a name table
+#define DEFAULT_NAME_TABLE_CAPACITY 1024
+
+// a slot in the name table. it is empty if its generation is not the current one
+typedef struct SR_NameSlot
+{
+    uint64_t fingerprint;       // 64-bit fingerprint of the read name
+
+    uint32_t gen;               // generation in which the slot was written
+
+    SR_BamNode* pNode;          // the alignment waiting for its mate (NULL for a deleted entry)
+
+}SR_NameSlot;
+
+// open addressing table from read names to the alignments waiting for their mates.
+// the read names are only compared when the fingerprints match
+typedef struct SR_NameTable
+{
+    SR_NameSlot* slots;         // slots of the table
+
+    uint32_t capacity;          // number of slots (a power of 2)
+
+    uint32_t size;              // number of alignments in the table
+
+    uint32_t numUsed;           // number of slots used in the current generation (including deleted entries)
+
+    uint32_t gen;               // current generation
+
+}SR_NameTable;
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_NameTable* SR_NameTableAlloc(uint32_t capacity);
+
+void SR_NameTableFree(SR_NameTable* pNameTable);
+
+
+//======================
+// Interface functions
+//======================
+
+//==============================================================
+// function:
+//      get the fingerprint of a read name
+//
+// args:
+//      1. queryName: a read name
+//
+// return:
+//      the 64-bit fingerprint of the read name
+//==============================================================
+uint64_t SR_NameTableFingerprint(const char* queryName);
+
+//==============================================================
+// function:
+//      remove all the alignments in a name table
+//
+// args:
+//      1. pNameTable: a pointer to a name table
+//
+// discussion:
+//      the slots are not touched, a new generation is started
+//==============================================================
+void SR_NameTableClear(SR_NameTable* pNameTable);
+
+//==============================================================
+// function:
+//      take the mate of an alignment out of a name table
+//
+// args:
+//      1. pNameTable : a pointer to a name table
+//      2. fingerprint: fingerprint of the read name
+//      3. queryName  : the read name
+//
+// return:
+//      the alignment with the same read name, which is removed
+//      from the table. NULL if it is not found
+//==============================================================
+SR_BamNode* SR_NameTableTake(SR_NameTable* pNameTable, uint64_t fingerprint, const char* queryName);
+
+//==============================================================
+// function:
+//      take the mate of an alignment out of a name table or
+//      put the alignment into the table if its mate is not
+//      there
+//
+// args:
+//      1. pNameTable : a pointer to a name table
+//      2. fingerprint: fingerprint of the read name
+//      3. pNode      : the alignment
+//
+// return:
+//      the alignment with the same read name, which is removed
+//      from the table. NULL if the new alignment is put into
+//      the table
+//==============================================================
+SR_BamNode* SR_NameTableTakeOrPut(SR_NameTable* pNameTable, uint64_t fingerprint, SR_BamNode* pNode);
+
+#endif  /*SR_NAMETABLE_H*/
@@ -258,6 +258,10 @@ SR_SpecialRefInfo* SR_SpecialRefInfoAlloc(uint32_t capacity)
     pSpecialRefInfo->numRefs = 0;
     pSpecialRefInfo->capacity = capacity;
 
+    pSpecialRefInfo->bucketIndex = NULL;
+    pSpecialRefInfo->numBuckets = 0;
+    pSpecialRefInfo->bucketShift = 0;
+
     pSpecialRefInfo->endPos = (uint32_t*) malloc(sizeof(uint32_t) * capacity);
     if (pSpecialRefInfo->endPos == NULL)
         SR_ErrQuit("ERROR: Not enough memory for the storage of end indices of special references.\n");
@@ -270,6 +274,7 @@ void SR_SpecialRefInfoFree(SR_SpecialRefInfo* pSpecialRefInfo)
     if (pSpecialRefInfo != NULL)
     {
         free(pSpecialRefInfo->endPos);
+        free(pSpecialRefInfo->bucketIndex);
         free(pSpecialRefInfo);
     }
 }
@@ -334,6 +339,8 @@ SR_RefHeader* SR_RefHeaderRead(int64_t* pRefHeaderPos, FILE* refInput)
         readSize = fread(pRefHeader->pSpecialRefInfo->endPos, sizeof(uint32_t), numSpecialRefs, refInput);
         if (readSize != pRefHeader->pSpecialRefInfo->numRefs)
             SR_ErrQuit("ERROR: Cannot read the end positions of special references from the reference file.\n");
+
+        SR_SpecialRefInfoBuildIndex(pRefHeader->pSpecialRefInfo);
     }
     else
     {
@@ -463,40 +470,81 @@ void SR_ReferenceRead(SR_Reference* pRef, FILE* refInput)
 }
 
 
-SR_Status SR_GetRefFromSpecialPos(SR_RefView* pRefView, int32_t* pRefID, uint32_t* pPos, const SR_RefHeader* pRefHeader, const SR_Reference* pSpecialRef, uint32_t specialPos)
+// build the position bucket index of the special references
+void SR_SpecialRefInfoBuildIndex(SR_SpecialRefInfo* pSpecialRefInfo)
 {
-    if (pRefHeader->pSpecialRefInfo != NULL)
-    {
-        if (specialPos <= pRefHeader->pSpecialRefInfo->endPos[0])
-        {
-            *pRefID = pRefHeader->numSeqs - 1;
-            *pPos    = specialPos;
+    free(pSpecialRefInfo->bucketIndex);
+    pSpecialRefInfo->bucketIndex = NULL;
+    pSpecialRefInfo->numBuckets = 0;
 
-            pRefView->id = *pRefID;
-            pRefView->sequence = pSpecialRef->sequence;
-            pRefView->seqLen = pRefHeader->pSpecialRefInfo->endPos[0] + 1;
+    if (pSpecialRefInfo->numRefs == 0)
+        return;
 
-            return SR_OK;
-        }
+    uint32_t lastEnd = pSpecialRefInfo->endPos[pSpecialRefInfo->numRefs - 1];
+    uint32_t avgLen = lastEnd / pSpecialRefInfo->numRefs + 1;
 
-        for (unsigned int i = 0; i != pRefHeader->pSpecialRefInfo->numRefs - 1; ++i)
-        {
-            unsigned int beginPos = pRefHeader->pSpecialRefInfo->endPos[i] + DEFAULT_PADDING_LEN + 1;
-            if (specialPos >= beginPos && specialPos <= pRefHeader->pSpecialRefInfo->endPos[i + 1])
-            {
-                *pRefID = pRefHeader->numSeqs + i;
-                *pPos    = specialPos - beginPos;
+    pSpecialRefInfo->bucketShift = 0;
+    while (pSpecialRefInfo->bucketShift < 31 && ((uint32_t) 1 << pSpecialRefInfo->bucketShift) < avgLen)
+        ++(pSpecialRefInfo->bucketShift);
 
-                pRefView->id = *pRefID;
-                pRefView->sequence = pSpecialRef->sequence + beginPos;
-                pRefView->seqLen = pRefHeader->pSpecialRefInfo->endPos[i + 1] - beginPos + 1;
+    pSpecialRefInfo->numBuckets = (lastEnd >> pSpecialRefInfo->bucketShift) + 1;
+    pSpecialRefInfo->bucketIndex = (uint32_t*) malloc(sizeof(uint32_t) * pSpecialRefInfo->numBuckets);
+    if (pSpecialRefInfo->bucketIndex == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the position bucket index of special references.\n");
 
-                return SR_OK;
-            }
+    // the end positions are in ascending order so we can fill the buckets in a single pass
+    unsigned int refIndex = 0;
+    for (unsigned int i = 0; i != pSpecialRefInfo->numBuckets; ++i)
+    {
+        uint32_t bucketBegin = i << pSpecialRefInfo->bucketShift;
+        while (pSpecialRefInfo->endPos[refIndex] < bucketBegin)
+            ++refIndex;
+
+        pSpecialRefInfo->bucketIndex[i] = refIndex;
+    }
+}
+
+SR_Status SR_GetRefFromSpecialPos(SR_RefView* pRefView, int32_t* pRefID, uint32_t* pPos, const SR_RefHeader* pRefHeader, const SR_Reference* pSpecialRef, uint32_t specialPos)
+{
+    const SR_SpecialRefInfo* pSpecialRefInfo = pRefHeader->pSpecialRefInfo;
+    if (pSpecialRefInfo == NULL || pSpecialRefInfo->numRefs == 0 || specialPos > pSpecialRefInfo->endPos[pSpecialRefInfo->numRefs - 1])
+        return SR_ERR;
+
+    // find the first special reference that ends at or after the special position
+    unsigned int index = 0;
+    if (pSpecialRefInfo->bucketIndex != NULL)
+    {
+        index = pSpecialRefInfo->bucketIndex[specialPos >> pSpecialRefInfo->bucketShift];
+        while (pSpecialRefInfo->endPos[index] < specialPos)
+            ++index;
+    }
+    else
+    {
+        unsigned int max = pSpecialRefInfo->numRefs - 1;
+        while (index < max)
+        {
+            unsigned int mid = (index + max) / 2;
+            if (pSpecialRefInfo->endPos[mid] < specialPos)
+                index = mid + 1;
+            else
+                max = mid;
         }
     }
 
-    return SR_ERR;
+    uint32_t beginPos = SR_SpecialRefGetBeginPos(pRefHeader, index);
+
+    // the special position is in the padding between two special references
+    if (specialPos < beginPos)
+        return SR_ERR;
+
+    *pRefID = pRefHeader->numSeqs - 1 + index;
+    *pPos    = specialPos - beginPos;
+
+    pRefView->id = *pRefID;
+    pRefView->sequence = pSpecialRef->sequence + beginPos;
+    pRefView->seqLen = pSpecialRefInfo->endPos[index] - beginPos + 1;
+
+    return SR_OK;
 }
 
 
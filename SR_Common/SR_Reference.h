@@ -54,6 +54,12 @@ typedef struct SR_SpecialRefInfo
 
     uint32_t capacity;
 
+    uint32_t* bucketIndex;     // index of the first special reference that ends at or after the begin of each position bucket
+
+    uint32_t numBuckets;       // number of position buckets
+
+    uint32_t bucketShift;      // log2 of the position bucket size
+
 }SR_SpecialRefInfo;
 
 // reference header strcture
@@ -214,6 +220,24 @@ SR_Status SR_ReferenceJump(FILE* refInput, const SR_RefHeader* pRefHeader, int32
 //====================================================================
 void SR_ReferenceRead(SR_Reference* pRef, FILE* refInput);
 
+//=====================================================================
+// function:
+//      build the position bucket index of the special references so
+//      that a position on the special sequence can be resolved in
+//      constant time
+//
+// args:
+//      1. pSpecialRefInfo: a pointer to the special reference 
+//                          information structure
+//
+// discussion:
+//      the bucket size is the smallest power of 2 that is not less
+//      than the average length of a special reference (including
+//      padding), so each bucket only overlaps a few special
+//      references. this function is called by "SR_RefHeaderRead"
+//=====================================================================
+void SR_SpecialRefInfoBuildIndex(SR_SpecialRefInfo* pSpecialRefInfo);
+
 //=====================================================================
 // function:
 //      get the reference ID and the real position from the position 
@@ -23,6 +23,7 @@
 
 #include "SR_Error.h"
 #include "SR_Utilities.h"
+#include "SR_MapStats.h"
 #include "SR_HashRegionTable.h"
 
 // default capacity of a hash region array
@@ -79,27 +80,45 @@ static void ResetBestRegions(HashRegionTable* pRegionTable, unsigned short query
     (pRegionTable->pBestCloseRegions)->size = queryLen;
     (pRegionTable->pBestFarRegions)->size = queryLen;
 
-    for (unsigned int i = 0; i != queryLen; ++i)
+    SR_ARRAY_RESET(pRegionTable->pBestPos);
+
+    // start a new epoch so that all the best regions of the previous query become stale.
+    // the stamps only have to be cleared when the epoch wraps around
+    ++(pRegionTable->epoch);
+    if (pRegionTable->epoch == 0)
     {
-        BestRegion* tempRegion = pRegionTable->pBestCloseRegions->data + i;
-        tempRegion->length = 0;
-        tempRegion->numPos = 0;
+        for (unsigned int i = 0; i != (pRegionTable->pBestCloseRegions)->capacity; ++i)
+        {
+            SR_ARRAY_GET(pRegionTable->pBestCloseRegions, i).epoch = 0;
+            SR_ARRAY_GET(pRegionTable->pBestFarRegions, i).epoch = 0;
+        }
 
-        tempRegion = pRegionTable->pBestFarRegions->data + i;
-        tempRegion->length = 0;
-        tempRegion->numPos = 0;
+        pRegionTable->epoch = 1;
     }
 }
 
+// stamp a stale best region with the current epoch and clear it
+static inline SR_Bool ClaimBestRegion(const HashRegionTable* pRegionTable, BestRegion* pBestRegion)
+{
+    if (pBestRegion->epoch == pRegionTable->epoch)
+        return FALSE;
+
+    pBestRegion->epoch = pRegionTable->epoch;
+    pBestRegion->length = 0;
+    pBestRegion->numPos = 0;
+
+    return TRUE;
+}
+
 
 // calculate the hash key for a hash in a read that starts at a certain position
-static SR_Bool GetNextHashKey(const char* query, uint32_t queryLen, unsigned int* pPos, uint32_t* pHashKey, uint32_t mask, unsigned int hashSize)
+static SR_Bool GetNextHashKey(const char* query, uint32_t queryBegin, uint32_t queryLen, unsigned int* pPos, uint32_t* pHashKey, uint32_t mask, unsigned int hashSize)
 {
     // table use to translate a nucleotide into its corresponding 2-bit representation
     static const char translation[26] = { 0, -1, 1, -1, -1, -1, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, -1, -1, -1, -1, -1, -1 };
 
     unsigned int endPos = *pPos + hashSize;
-    unsigned int startPos = *pPos == 0 ? *pPos : endPos - 1;
+    unsigned int startPos = *pPos == queryBegin ? *pPos : endPos - 1;
 
     // remove the highest 2 bits in the previous hash key
     *pHashKey &= mask;
@@ -129,6 +148,27 @@ static SR_Bool GetNextHashKey(const char* query, uint32_t queryLen, unsigned int
     return FALSE;
 }
 
+// check if a hash in the query covers any base with low quality
+static SR_Bool IsLowQualHash(const SR_QueryRegion* pQueryRegion, unsigned int queryPos, unsigned int hashSize, unsigned char minBaseQual)
+{
+    const uint8_t* qual = bam1_qual(pQueryRegion->pOrphan);
+
+    // base qualities are not available
+    if (qual[0] == 0xff)
+        return FALSE;
+
+    // the base qualities are stored in the order of the bam record
+    unsigned int queryLen = SR_GetQueryLen(pQueryRegion->pOrphan);
+    for (unsigned int i = queryPos; i != queryPos + hashSize; ++i)
+    {
+        unsigned int qualPos = pQueryRegion->isOrphanInversed ? queryLen - 1 - i : i;
+        if (qual[qualPos] < minBaseQual)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
 // find the start index of the first hash position that is in our search region
 static unsigned int GetStartHashPosIndex(const HashPosView* pHashPosView, uint32_t refStart)
 {
@@ -160,13 +200,15 @@ static unsigned int GetStartHashPosIndex(const HashPosView* pHashPosView, uint32
 }
 
 
-// merge a new hash region with existing ones
-static SR_Bool MergeHashRegions(HashRegionTable* pRegionTable, HashRegion* pNewRegion)
+// merge a new hash region with existing ones (the previous hash was searched "step" bp before)
+static SR_Bool MergeHashRegions(HashRegionTable* pRegionTable, HashRegion* pNewRegion, unsigned int step)
 {
+    SR_MAP_STATS_ADD(numMergeTries, 1);
+
     if (pNewRegion->refBegin < SR_ARRAY_GET(pRegionTable->pPrevRegions, 0).refBegin)
         return TRUE;
 
-    uint32_t target = pNewRegion->refBegin + pNewRegion->length - 1;
+    uint32_t target = pNewRegion->refBegin + pNewRegion->length - step;
     unsigned int min = pRegionTable->searchBegin;
     unsigned int max = (pRegionTable->pPrevRegions)->size - 1;
 
@@ -183,7 +225,9 @@ static SR_Bool MergeHashRegions(HashRegionTable* pRegionTable, HashRegion* pNewR
             pRegionTable->searchBegin = mid + 1;
             pNewRegion->refBegin = SR_ARRAY_GET(pRegionTable->pPrevRegions, mid).refBegin;
             pNewRegion->queryBegin = SR_ARRAY_GET(pRegionTable->pPrevRegions, mid).queryBegin;
-            pNewRegion->length = SR_ARRAY_GET(pRegionTable->pPrevRegions, mid).length + 1;
+            pNewRegion->length = SR_ARRAY_GET(pRegionTable->pPrevRegions, mid).length + step;
+
+            SR_MAP_STATS_ADD(numMerged, 1);
             break;
         }
         else if (target > refEnd)
@@ -209,6 +253,11 @@ static void UpdateBestRegions(HashRegionTable* pRegionTable, const HashRegion* p
     BestRegion* pBestClose = SR_ARRAY_GET_PT(pRegionTable->pBestCloseRegions, pNewRegion->queryBegin);
     BestRegion* pBestFar = SR_ARRAY_GET_PT(pRegionTable->pBestFarRegions, pNewRegion->queryBegin);
 
+    // every new region is within the far search region so the far best region is the first
+    // one touched at a query position. we record the position for the reverse operation
+    if (ClaimBestRegion(pRegionTable, pBestFar))
+        SR_ARRAY_PUSH(pRegionTable->pBestPos, &(pNewRegion->queryBegin), uint32_t);
+
     if (pNewRegion->length > pBestFar->length)
     {
         pBestFar->length = pNewRegion->length;
@@ -226,6 +275,8 @@ static void UpdateBestRegions(HashRegionTable* pRegionTable, const HashRegion* p
     if (pNewRegion->refBegin >= pQueryRegion->closeRefBegin 
         && pNewRegion->refBegin <= pQueryRegion->closeRefEnd)
     {
+        ClaimBestRegion(pRegionTable, pBestClose);
+
         if (pNewRegion->length > pBestClose->length)
         {
             pBestClose->length = pNewRegion->length;
@@ -259,6 +310,15 @@ HashRegionTable* HashRegionTableAlloc(void)
     pNewTable->pBestCloseRegions = NULL;
     pNewTable->pBestFarRegions = NULL;
 
+    SR_ARRAY_ALLOC(pNewTable->pBestPos, DEFAULT_HASH_ARR_CAPACITY, BestPosArray, uint32_t);
+    pNewTable->epoch = 0;
+
+    pNewTable->numPrefiltered = 0;
+    pNewTable->numFiltered = 0;
+
+    pNewTable->stride = 1;
+    pNewTable->minBaseQual = 0;
+
     pNewTable->searchBegin = 0;
 
     return pNewTable;
@@ -272,6 +332,7 @@ void HashRegionTableFree(HashRegionTable* pRegionTable)
         SR_ARRAY_FREE(pRegionTable->pCurrRegions, TRUE);
         SR_ARRAY_FREE(pRegionTable->pBestCloseRegions, TRUE);
         SR_ARRAY_FREE(pRegionTable->pBestFarRegions, TRUE);
+        SR_ARRAY_FREE(pRegionTable->pBestPos, TRUE);
 
         free(pRegionTable);
     }
@@ -285,13 +346,26 @@ void HashRegionTableFree(HashRegionTable* pRegionTable)
 // for each query find the best hash regions in the reference
 void HashRegionTableLoad(HashRegionTable* pRegionTable, const SR_InHashTable* pHashTable, const SR_QueryRegion* pQueryRegion)
 {
-    unsigned int prevQueryPos = 0;
-    unsigned int currQueryPos = 0;
+    // only the hashed segment of the query is searched (the clipped part of a unique-soft mate)
+    unsigned int prevQueryPos = pQueryRegion->hashBegin;
+    unsigned int currQueryPos = pQueryRegion->hashBegin;
     uint32_t hashKey = 0;
 
+    SR_MAP_STATS_BEGIN(pHashTable->id, pQueryRegion->algnType);
+    SR_MAP_STATS_ADD(numQueries, 1);
+
     // get the next hash key in the query
-    while (GetNextHashKey(pQueryRegion->orphanSeq, SR_GetQueryLen(pQueryRegion->pOrphan), &currQueryPos, &hashKey, pHashTable->highEndMask, pHashTable->hashSize))
+    while (GetNextHashKey(pQueryRegion->orphanSeq, pQueryRegion->hashBegin, pQueryRegion->hashEnd, &currQueryPos, &hashKey, pHashTable->highEndMask, pHashTable->hashSize))
     {
+        // only the sampled hashes that do not cover low quality bases are searched.
+        // the hash key still has to be calculated at every position
+        if ((pRegionTable->stride > 1 && (currQueryPos - pQueryRegion->hashBegin) % pRegionTable->stride != 0)
+            || (pRegionTable->minBaseQual > 0 && IsLowQualHash(pQueryRegion, currQueryPos, pHashTable->hashSize, pRegionTable->minBaseQual)))
+        {
+            ++currQueryPos;
+            continue;
+        }
+
         // an array stores the hash positions under current hash key
         HashPosView hashPosArray;
         // this struct will store the new hash region from the query
@@ -301,9 +375,10 @@ void HashRegionTableLoad(HashRegionTable* pRegionTable, const SR_InHashTable* pH
         {
 
             // we only have to merge the hash regions when we do get some hash regions in the last round
-            // and the current query position is 1bp ahead the previous query position
+            // and the current hash overlaps or touches the previous searched hash
             SR_Bool doMerge = FALSE;
-            if (currQueryPos == prevQueryPos + 1 && SR_ARRAY_GET_SIZE(pRegionTable->pPrevRegions) > 0)
+            unsigned int step = currQueryPos - prevQueryPos;
+            if (step > 0 && step <= pHashTable->hashSize && SR_ARRAY_GET_SIZE(pRegionTable->pPrevRegions) > 0)
                 doMerge = TRUE;
 
             // find the start index of the first hash position that is in our search region
@@ -316,12 +391,14 @@ void HashRegionTableLoad(HashRegionTable* pRegionTable, const SR_InHashTable* pH
                 newRegion.length = pHashTable->hashSize;
 
                 if (doMerge)
-                    doMerge = MergeHashRegions(pRegionTable, &newRegion);
+                    doMerge = MergeHashRegions(pRegionTable, &newRegion, step);
 
                 // we will get out of the loop if the hash position in reference exceeds our search region
                 if (newRegion.refBegin > pQueryRegion->farRefEnd)
                     break;
 
+                SR_MAP_STATS_ADD(numInWindow, 1);
+
                 // we will update the best hash region with this new region and push it into the current hash region array for next round merge
                 UpdateBestRegions(pRegionTable, &newRegion, pQueryRegion);
                 SR_ARRAY_PUSH(pRegionTable->pCurrRegions, &newRegion, HashRegion);
@@ -338,32 +415,109 @@ void HashRegionTableLoad(HashRegionTable* pRegionTable, const SR_InHashTable* pH
         prevQueryPos = currQueryPos;
         ++currQueryPos;
     }
+
+#ifdef SR_MAP_STATS
+    // record the multiplicity of the best hash regions found for this query
+    for (unsigned int j = 0; j != SR_ARRAY_GET_SIZE(pRegionTable->pBestPos); ++j)
+    {
+        unsigned int i = SR_ARRAY_GET(pRegionTable->pBestPos, j);
+
+        if (BEST_REGION_IS_SET(pRegionTable, SR_ARRAY_GET_PT(pRegionTable->pBestCloseRegions, i)))
+            SR_MAP_STATS_NUM_POS(TRUE, SR_ARRAY_GET(pRegionTable->pBestCloseRegions, i).numPos);
+
+        if (BEST_REGION_IS_SET(pRegionTable, SR_ARRAY_GET_PT(pRegionTable->pBestFarRegions, i)))
+            SR_MAP_STATS_NUM_POS(FALSE, SR_ARRAY_GET(pRegionTable->pBestFarRegions, i).numPos);
+    }
+#endif
+}
+
+// set the seeding mode of the hash region table
+void HashRegionTableSetSeeding(HashRegionTable* pRegionTable, unsigned char hashSize, unsigned int minMatchLen, unsigned char minBaseQual)
+{
+    pRegionTable->stride = 1;
+    if (minMatchLen > hashSize)
+    {
+        pRegionTable->stride = minMatchLen - hashSize + 1;
+        if (pRegionTable->stride > hashSize)
+            pRegionTable->stride = hashSize;
+    }
+
+    pRegionTable->minBaseQual = minBaseQual;
+}
+
+// check if a query could have a partial alignment of the minimum length within the search region
+SR_Bool HashRegionTablePrefilter(HashRegionTable* pRegionTable, const SR_InHashTable* pHashTable, const SR_QueryRegion* pQueryRegion, unsigned int minPartialLen)
+{
+    if (minPartialLen < pHashTable->hashSize)
+        return TRUE;
+
+    // the probes of the prefilter are not counted as k-mer lookups of the loading
+    ++(pRegionTable->numPrefiltered);
+    SR_MAP_STATS_END();
+
+    // minimum number of hashes hitting the search region required by a partial alignment
+    unsigned int threshold = minPartialLen - pHashTable->hashSize + 1;
+    unsigned int numHits = 0;
+
+    unsigned int currQueryPos = pQueryRegion->hashBegin;
+    uint32_t hashKey = 0;
+
+    while (GetNextHashKey(pQueryRegion->orphanSeq, pQueryRegion->hashBegin, pQueryRegion->hashEnd, &currQueryPos, &hashKey, pHashTable->highEndMask, pHashTable->hashSize))
+    {
+        // the rest of the query does not have enough hashes to reach the threshold
+        if (numHits + (pQueryRegion->hashEnd - currQueryPos - pHashTable->hashSize + 1) < threshold)
+            break;
+
+        HashPosView hashPosArray;
+        if (SR_InHashTableSearch(&hashPosArray, pHashTable, hashKey))
+        {
+            unsigned int startIndex = GetStartHashPosIndex(&hashPosArray, pQueryRegion->farRefBegin);
+            if (startIndex < hashPosArray.size && hashPosArray.data[startIndex] <= pQueryRegion->farRefEnd)
+            {
+                ++numHits;
+                if (numHits >= threshold)
+                    return TRUE;
+            }
+        }
+
+        ++currQueryPos;
+    }
+
+    ++(pRegionTable->numFiltered);
+    SR_MAP_STATS_BEGIN(pHashTable->id, pQueryRegion->algnType);
+    SR_MAP_STATS_ADD(numFiltered, 1);
+
+    return FALSE;
 }
 
 // index the best hash regions with their end position
 void HashRegionTableReverseBest(HashRegionTable* pRegionTable)
 {
-    for (int i = SR_ARRAY_GET_SIZE(pRegionTable->pBestCloseRegions) - 1; i >= 0; --i)
+    // only the positions where a best region starts have to be visited.
+    // they are recorded in ascending order so we walk them backward
+    for (int j = SR_ARRAY_GET_SIZE(pRegionTable->pBestPos) - 1; j >= 0; --j)
     {
+        unsigned int i = SR_ARRAY_GET(pRegionTable->pBestPos, j);
+
         BestRegion* pCloseLowEnd = SR_ARRAY_GET_PT(pRegionTable->pBestCloseRegions, i);
-        if (pCloseLowEnd->length > 0)
+        if (BEST_REGION_IS_SET(pRegionTable, pCloseLowEnd))
         {
             unsigned short closeHighEndPos = i + pCloseLowEnd->length - 1;
             BestRegion* pCloseHighEnd = SR_ARRAY_GET_PT(pRegionTable->pBestCloseRegions, closeHighEndPos);
 
-            if (pCloseHighEnd->length < pCloseLowEnd->length)
+            if (!BEST_REGION_IS_SET(pRegionTable, pCloseHighEnd) || pCloseHighEnd->length < pCloseLowEnd->length)
                 *pCloseHighEnd = *pCloseLowEnd;
 
             pCloseLowEnd->length = 0;
         }
 
         BestRegion* pFarLowEnd = SR_ARRAY_GET_PT(pRegionTable->pBestFarRegions, i);
-        if (pFarLowEnd->length > 0)
+        if (BEST_REGION_IS_SET(pRegionTable, pFarLowEnd))
         {
             unsigned short closeHighEndPos = i + pFarLowEnd->length - 1;
             BestRegion* pFarHighEnd = SR_ARRAY_GET_PT(pRegionTable->pBestFarRegions, closeHighEndPos);
 
-            if (pFarHighEnd->length < pFarLowEnd->length)
+            if (!BEST_REGION_IS_SET(pRegionTable, pFarHighEnd) || pFarHighEnd->length < pFarLowEnd->length)
                 *pFarHighEnd = *pFarLowEnd;
 
             pFarLowEnd->length = 0;
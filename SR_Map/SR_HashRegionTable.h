@@ -51,6 +51,8 @@ typedef struct BestRegion
 
     uint32_t numPos;                             // number of locations of the hash region found in the reference
 
+    uint32_t epoch;                              // epoch of the query that set this best region (stale if not the current epoch)
+
 }BestRegion;
 
 // hash region array
@@ -75,6 +77,17 @@ typedef struct BestRegionArray
 
 }BestRegionArray;
 
+// array of the query positions that have best hash regions
+typedef struct BestPosArray
+{
+    uint32_t* data;
+
+    unsigned int size;
+
+    unsigned int capacity;
+
+}BestPosArray;
+
 typedef struct HashRegionTable
 {
     unsigned int searchBegin;              // lower limit in searching the prevHashArray
@@ -87,8 +100,23 @@ typedef struct HashRegionTable
 
     BestRegionArray* pBestFarRegions;      // an array hold the best hash regions within the further search region
 
+    BestPosArray* pBestPos;                // an array hold the query positions where the best hash regions start (in ascending order)
+
+    uint32_t epoch;                        // epoch of the current query, best regions stamped with other epochs are empty
+
+    uint64_t numPrefiltered;               // number of queries checked by the q-gram prefilter
+
+    uint64_t numFiltered;                  // number of queries rejected by the q-gram prefilter
+
+    unsigned int stride;                   // distance between two sampled hashes in the query (1 to search every hash)
+
+    unsigned char minBaseQual;             // hashes covering a base with lower quality will not be searched (0 to disable)
+
 }HashRegionTable;
 
+// check if a best hash region is set for the current query
+#define BEST_REGION_IS_SET(pRegionTable, pBestRegion) ((pBestRegion)->epoch == (pRegionTable)->epoch && (pBestRegion)->length > 0)
+
 
 //===============================
 // Constructors and Destructors
@@ -116,10 +144,59 @@ void HashRegionTableFree(HashRegionTable* pRegionTable);
 //      the best hash region start at each position of the query
 //      will be stored at the 'pBestCloseRegions' and the
 //      'pBestFarRegions' for close query region and far query
-//      region respectively after processing
+//      region respectively after processing. a best hash region
+//      is only valid if it passes the 'BEST_REGION_IS_SET' check
 //==================================================================
 void HashRegionTableLoad(HashRegionTable* pRegionTable, const SR_InHashTable* pHashTable, const SR_QueryRegion* pQueryRegion);
 
+//==================================================================
+// function:
+//      set the seeding mode of the hash region table
+//
+// args:
+//      1. pRegionTable: a pointer to a hash region table
+//      2. hashSize: hash size of the reference hash table
+//      3. minMatchLen: minimum length of an exact match that
+//                      must be found (0 to search every hash)
+//      4. minBaseQual: minimum base quality of a searched hash
+//
+// discussion:
+//      the stride is set to min(hashSize, minMatchLen -
+//      hashSize + 1). every exact match of at least minMatchLen
+//      bases contains a sampled hash, and two sampled hashes on
+//      the same diagonal always overlap or touch, so the merged
+//      hash regions are still exact matches. their ends are
+//      only known at the resolution of the stride. the quality
+//      filter drops sensitivity for matches with low quality
+//      bases in exchange for fewer lookups
+//==================================================================
+void HashRegionTableSetSeeding(HashRegionTable* pRegionTable, unsigned char hashSize, unsigned int minMatchLen, unsigned char minBaseQual);
+
+//==================================================================
+// function:
+//      check if a query could have a partial alignment of the
+//      minimum length within the search region before loading
+//      it into the hash region table
+//
+// args:
+//      1. pRegionTable: a pointer to a hash region table
+//      2. pHashTable: a pointer to a reference hash table
+//      3. pQueryRegion: a pointer to a query region
+//      4. minPartialLen: minimum length of a partial alignment
+//
+// return:
+//      FALSE if the query is rejected, otherwise TRUE
+//
+// discussion:
+//      an exact partial alignment of length L contains
+//      (L - hashSize + 1) hashes that all hit the search region
+//      (q-gram lemma). we only count the hashes of the query
+//      with at least one hash position in the far search region
+//      and reject the query if the count can not reach the
+//      threshold. no hash region is merged in this step
+//==================================================================
+SR_Bool HashRegionTablePrefilter(HashRegionTable* pRegionTable, const SR_InHashTable* pHashTable, const SR_QueryRegion* pQueryRegion, unsigned int minPartialLen);
+
 //==========================================================
 // function:
 //      initialize the hash region table for a new query
@@ -127,6 +204,11 @@ void HashRegionTableLoad(HashRegionTable* pRegionTable, const SR_InHashTable* pH
 // args:
 //      1. pRegionTable: a pointer to a hash region table
 //      2. queryLen: length of the query
+//
+// discussion:
+//      the best hash regions are not cleared. a new epoch is
+//      started instead so that all the best hash regions of
+//      the previous query become stale
 //==========================================================
 void HashRegionTableInit(HashRegionTable* pRegionTable, uint32_t queryLen);
 
@@ -145,7 +227,8 @@ void HashRegionTableInit(HashRegionTable* pRegionTable, uint32_t queryLen);
 //      "0" stores the best hash region that starts at query 
 //      position "0". This function will reverse each best 
 //      hash region so that it stores the best hash region 
-//      end instead of begin
+//      end instead of begin. only the positions recorded in
+//      "pBestPos" are visited
 //===========================================================
 void HashRegionTableReverseBest(HashRegionTable* pRegionTable);
 
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 
 #include "SR_Error.h"
+#include "SR_MapStats.h"
 #include "SR_InHashTable.h"
 
 SR_InHashTable* SR_InHashTableAlloc(unsigned char hashSize)
@@ -143,6 +144,8 @@ SR_Bool SR_InHashTableSearch(HashPosView* pHashPosView, const SR_InHashTable* pH
     if(hashKey >= pHashTable->numHashes)
         SR_ErrSys("ERROR: Invalid hash key.\n");
 
+    SR_MAP_STATS_ADD(numKmers, 1);
+
     uint32_t index = pHashTable->indices[hashKey];
     uint32_t nextIndex = hashKey == (pHashTable->numHashes - 1) ? pHashTable->numPos : pHashTable->indices[hashKey + 1];
 
@@ -152,5 +155,7 @@ SR_Bool SR_InHashTableSearch(HashPosView* pHashPosView, const SR_InHashTable* pH
     pHashPosView->size = nextIndex - index;
     pHashPosView->data = pHashTable->hashPos + index;
 
+    SR_MAP_STATS_BUCKET(pHashPosView->size);
+
     return TRUE;
 }
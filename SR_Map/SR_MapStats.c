@@ -0,0 +1,229 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_MapStats.c
+ *
+ *    Description:  optional hot-path statistics of the split mapping
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:06:26 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "SR_Error.h"
+#include "SR_MapStats.h"
+
+// counters used by the current thread
+__thread SR_MapStatsCell* srMapStatsCurrCell = NULL;
+
+// statistics object attached to the current thread
+static __thread SR_MapStats* pCurrMapStats = NULL;
+
+// names of the alignment types in the report
+static const char* SR_MAP_STATS_ALGN_NAMES[SR_MAP_STATS_NUM_ALGN_TYPES] = {"UNIQUE_ORPHAN", "UNIQUE_SOFT", "UNIQUE_MULTIPLE"};
+
+
+//=========================
+// Static methods
+//=========================
+
+static void WriteHistJSON(const uint64_t* hist, unsigned int numBins, FILE* output)
+{
+    fprintf(output, "[");
+    for (unsigned int i = 0; i != numBins; ++i)
+        fprintf(output, i == 0 ? "%" PRIu64 : ", %" PRIu64, hist[i]);
+
+    fprintf(output, "]");
+}
+
+static void WriteHistTSV(const uint64_t* hist, unsigned int numBins, FILE* output)
+{
+    for (unsigned int i = 0; i != numBins; ++i)
+        fprintf(output, i == 0 ? "%" PRIu64 : ",%" PRIu64, hist[i]);
+}
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_MapStats* SR_MapStatsAlloc(uint32_t numRefs)
+{
+    SR_MapStats* pMapStats = (SR_MapStats*) malloc(sizeof(SR_MapStats));
+    if (pMapStats == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for a split mapping statistics object.\n");
+
+    pMapStats->cells = (SR_MapStatsCell*) calloc(numRefs * SR_MAP_STATS_NUM_ALGN_TYPES, sizeof(SR_MapStatsCell));
+    if (pMapStats->cells == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the counters in the split mapping statistics object.\n");
+
+    pMapStats->numRefs = numRefs;
+
+    return pMapStats;
+}
+
+void SR_MapStatsFree(SR_MapStats* pMapStats)
+{
+    if (pMapStats != NULL)
+    {
+        if (pCurrMapStats == pMapStats)
+            SR_MapStatsAttach(NULL);
+
+        free(pMapStats->cells);
+        free(pMapStats);
+    }
+}
+
+
+//===============================
+// Interface functions
+//===============================
+
+void SR_MapStatsAttach(SR_MapStats* pMapStats)
+{
+    pCurrMapStats = pMapStats;
+    srMapStatsCurrCell = NULL;
+}
+
+void SR_MapStatsBegin(int32_t refID, SR_AlgnType algnType)
+{
+    srMapStatsCurrCell = NULL;
+
+    if (pCurrMapStats == NULL || refID < 0 || (uint32_t) refID >= pCurrMapStats->numRefs || (unsigned int) algnType >= SR_MAP_STATS_NUM_ALGN_TYPES)
+        return;
+
+    srMapStatsCurrCell = pCurrMapStats->cells + refID * SR_MAP_STATS_NUM_ALGN_TYPES + algnType;
+}
+
+void SR_MapStatsAddBucket(uint32_t bucketSize)
+{
+    if (srMapStatsCurrCell == NULL)
+        return;
+
+    // log2 bin of the bucket size
+    unsigned int bin = bucketSize == 0 ? 0 : 32 - __builtin_clz(bucketSize);
+    if (bin >= SR_MAP_STATS_NUM_BUCKET_BINS)
+        bin = SR_MAP_STATS_NUM_BUCKET_BINS - 1;
+
+    ++(srMapStatsCurrCell->bucketHist[bin]);
+    ++(srMapStatsCurrCell->numKmerHits);
+    srMapStatsCurrCell->numBucketPos += bucketSize;
+}
+
+void SR_MapStatsAddNumPos(SR_Bool isClose, uint32_t numPos)
+{
+    if (srMapStatsCurrCell == NULL)
+        return;
+
+    unsigned int bin = numPos < SR_MAP_STATS_NUM_POS_BINS ? numPos : SR_MAP_STATS_NUM_POS_BINS - 1;
+    if (isClose)
+        ++(srMapStatsCurrCell->closeNumPosHist[bin]);
+    else
+        ++(srMapStatsCurrCell->farNumPosHist[bin]);
+}
+
+void SR_MapStatsMerge(SR_MapStats* pDst, const SR_MapStats* pSrc)
+{
+    if (pDst->numRefs != pSrc->numRefs)
+        SR_ErrQuit("ERROR: Split mapping statistics with different number of references can not be merged.\n");
+
+    unsigned int numCells = pDst->numRefs * SR_MAP_STATS_NUM_ALGN_TYPES;
+    for (unsigned int i = 0; i != numCells; ++i)
+    {
+        SR_MapStatsCell* pDstCell = pDst->cells + i;
+        const SR_MapStatsCell* pSrcCell = pSrc->cells + i;
+
+        pDstCell->numQueries += pSrcCell->numQueries;
+        pDstCell->numFiltered += pSrcCell->numFiltered;
+        pDstCell->numKmers += pSrcCell->numKmers;
+        pDstCell->numKmerHits += pSrcCell->numKmerHits;
+        pDstCell->numBucketPos += pSrcCell->numBucketPos;
+        pDstCell->numInWindow += pSrcCell->numInWindow;
+        pDstCell->numMergeTries += pSrcCell->numMergeTries;
+        pDstCell->numMerged += pSrcCell->numMerged;
+
+        for (unsigned int j = 0; j != SR_MAP_STATS_NUM_BUCKET_BINS; ++j)
+            pDstCell->bucketHist[j] += pSrcCell->bucketHist[j];
+
+        for (unsigned int j = 0; j != SR_MAP_STATS_NUM_POS_BINS; ++j)
+        {
+            pDstCell->closeNumPosHist[j] += pSrcCell->closeNumPosHist[j];
+            pDstCell->farNumPosHist[j] += pSrcCell->farNumPosHist[j];
+        }
+    }
+}
+
+void SR_MapStatsWrite(const SR_MapStats* pMapStats, char** refNames, SR_MapStatsFormat format, FILE* output)
+{
+    if (format == SR_MAP_STATS_JSON)
+        fprintf(output, "[\n");
+    else
+        fprintf(output, "chr\talgnType\tnumQueries\tnumFiltered\tnumKmers\tnumKmerHits\tnumBucketPos\tnumInWindow\tnumMergeTries\tnumMerged\tbucketHist\tcloseNumPosHist\tfarNumPosHist\n");
+
+    SR_Bool isFirst = TRUE;
+    for (unsigned int refID = 0; refID != pMapStats->numRefs; ++refID)
+    {
+        for (unsigned int type = 0; type != SR_MAP_STATS_NUM_ALGN_TYPES; ++type)
+        {
+            const SR_MapStatsCell* pCell = pMapStats->cells + refID * SR_MAP_STATS_NUM_ALGN_TYPES + type;
+            // the queries rejected by the prefilter are never loaded
+            if (pCell->numQueries == 0 && pCell->numFiltered == 0)
+                continue;
+
+            if (format == SR_MAP_STATS_JSON)
+            {
+                if (!isFirst)
+                    fprintf(output, ",\n");
+
+                if (refNames != NULL)
+                    fprintf(output, "  {\"chr\": \"%s\", ", refNames[refID]);
+                else
+                    fprintf(output, "  {\"chr\": %u, ", refID);
+
+                fprintf(output, "\"algnType\": \"%s\", \"numQueries\": %" PRIu64 ", \"numFiltered\": %" PRIu64 ", \"numKmers\": %" PRIu64 ", \"numKmerHits\": %" PRIu64 ", \"numBucketPos\": %" PRIu64 ", "
+                                "\"numInWindow\": %" PRIu64 ", \"numMergeTries\": %" PRIu64 ", \"numMerged\": %" PRIu64 ", ",
+                        SR_MAP_STATS_ALGN_NAMES[type], pCell->numQueries, pCell->numFiltered, pCell->numKmers, pCell->numKmerHits, pCell->numBucketPos,
+                        pCell->numInWindow, pCell->numMergeTries, pCell->numMerged);
+
+                fprintf(output, "\"bucketHist\": ");
+                WriteHistJSON(pCell->bucketHist, SR_MAP_STATS_NUM_BUCKET_BINS, output);
+                fprintf(output, ", \"closeNumPosHist\": ");
+                WriteHistJSON(pCell->closeNumPosHist, SR_MAP_STATS_NUM_POS_BINS, output);
+                fprintf(output, ", \"farNumPosHist\": ");
+                WriteHistJSON(pCell->farNumPosHist, SR_MAP_STATS_NUM_POS_BINS, output);
+                fprintf(output, "}");
+            }
+            else
+            {
+                if (refNames != NULL)
+                    fprintf(output, "%s\t", refNames[refID]);
+                else
+                    fprintf(output, "%u\t", refID);
+
+                fprintf(output, "%s\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t", SR_MAP_STATS_ALGN_NAMES[type], pCell->numQueries, pCell->numFiltered, pCell->numKmers,
+                        pCell->numKmerHits, pCell->numBucketPos, pCell->numInWindow, pCell->numMergeTries, pCell->numMerged);
+
+                WriteHistTSV(pCell->bucketHist, SR_MAP_STATS_NUM_BUCKET_BINS, output);
+                fprintf(output, "\t");
+                WriteHistTSV(pCell->closeNumPosHist, SR_MAP_STATS_NUM_POS_BINS, output);
+                fprintf(output, "\t");
+                WriteHistTSV(pCell->farNumPosHist, SR_MAP_STATS_NUM_POS_BINS, output);
+                fprintf(output, "\n");
+            }
+
+            isFirst = FALSE;
+        }
+    }
+
+    if (format == SR_MAP_STATS_JSON)
+        fprintf(output, "\n]\n");
+}
@@ -0,0 +1,207 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_MapStats.h
+ *
+ *    Description:  optional hot-path statistics of the split mapping
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:06:26 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SR_MAPSTATS_H
+#define  SR_MAPSTATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "SR_Types.h"
+#include "SR_BamInStream.h"
+
+//===============================
+// Type and constant definition
+//===============================
+
+// number of alignment types tracked by the statistics (unique-orphan, unique-soft and unique-multiple)
+#define SR_MAP_STATS_NUM_ALGN_TYPES 3
+
+// number of log2 bins in the hash bucket size histogram
+#define SR_MAP_STATS_NUM_BUCKET_BINS 32
+
+// number of bins in the best region multiplicity histogram (the last bin holds everything larger)
+#define SR_MAP_STATS_NUM_POS_BINS 5
+
+// output format of the statistics report
+typedef enum
+{
+    SR_MAP_STATS_JSON = 0,
+
+    SR_MAP_STATS_TSV  = 1
+
+}SR_MapStatsFormat;
+
+// counters of one chromosome and one alignment type
+typedef struct SR_MapStatsCell
+{
+    uint64_t numQueries;                                      // number of queries loaded into the hash region table
+
+    uint64_t numFiltered;                                     // number of queries rejected by the q-gram prefilter
+
+    uint64_t numKmers;                                        // number of k-mers looked up in the reference hash table
+
+    uint64_t numKmerHits;                                     // number of k-mers found in the reference hash table
+
+    uint64_t numBucketPos;                                    // total number of hash positions in the buckets of the found k-mers
+
+    uint64_t numInWindow;                                     // number of hash positions that fall into the search window
+
+    uint64_t numMergeTries;                                   // number of attempts to merge a new hash region with the previous ones
+
+    uint64_t numMerged;                                       // number of new hash regions extended from a previous one
+
+    uint64_t bucketHist[SR_MAP_STATS_NUM_BUCKET_BINS];        // log2 histogram of the bucket sizes of the found k-mers
+
+    uint64_t closeNumPosHist[SR_MAP_STATS_NUM_POS_BINS];      // histogram of the best close region multiplicity (numPos)
+
+    uint64_t farNumPosHist[SR_MAP_STATS_NUM_POS_BINS];        // histogram of the best far region multiplicity (numPos)
+
+}SR_MapStatsCell;
+
+// statistics of the split mapping (one object for each thread)
+typedef struct SR_MapStats
+{
+    SR_MapStatsCell* cells;       // counters of each chromosome and each alignment type
+
+    uint32_t numRefs;             // number of chromosomes
+
+}SR_MapStats;
+
+// counters used by the current thread
+extern __thread SR_MapStatsCell* srMapStatsCurrCell;
+
+// the hooks in the hot path are only compiled when SR_MAP_STATS is defined
+#ifdef SR_MAP_STATS
+
+#define SR_MAP_STATS_BEGIN(refID, algnType) SR_MapStatsBegin((refID), (algnType))
+
+// the following hooks update nothing until the next begin
+#define SR_MAP_STATS_END() (srMapStatsCurrCell = NULL)
+
+#define SR_MAP_STATS_ADD(field, value) \
+    do                                                      \
+    {                                                       \
+        if (srMapStatsCurrCell != NULL)                     \
+            srMapStatsCurrCell->field += (value);           \
+    }while(0)
+
+#define SR_MAP_STATS_BUCKET(bucketSize) SR_MapStatsAddBucket(bucketSize)
+
+#define SR_MAP_STATS_NUM_POS(isClose, numPos) SR_MapStatsAddNumPos((isClose), (numPos))
+
+#else
+
+#define SR_MAP_STATS_BEGIN(refID, algnType)
+
+#define SR_MAP_STATS_END()
+
+#define SR_MAP_STATS_ADD(field, value)
+
+#define SR_MAP_STATS_BUCKET(bucketSize)
+
+#define SR_MAP_STATS_NUM_POS(isClose, numPos)
+
+#endif
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_MapStats* SR_MapStatsAlloc(uint32_t numRefs);
+
+void SR_MapStatsFree(SR_MapStats* pMapStats);
+
+
+//===============================
+// Interface functions
+//===============================
+
+//==============================================================
+// function:
+//      attach a statistics object to the calling thread. all
+//      the hooks in the split mapping hot path of this thread
+//      will update this object afterwards
+//
+// args:
+//      1. pMapStats: a pointer to a statistics object, NULL
+//                    to detach
+//==============================================================
+void SR_MapStatsAttach(SR_MapStats* pMapStats);
+
+//==============================================================
+// function:
+//      select the counters of a chromosome and an alignment
+//      type for the incoming query of the calling thread
+//
+// args:
+//      1. refID   : reference ID of the searched chromosome
+//      2. algnType: alignment type of the query pair
+//==============================================================
+void SR_MapStatsBegin(int32_t refID, SR_AlgnType algnType);
+
+//==============================================================
+// function:
+//      record the bucket size of a found k-mer
+//
+// args:
+//      1. bucketSize: number of hash positions in the bucket
+//==============================================================
+void SR_MapStatsAddBucket(uint32_t bucketSize);
+
+//==============================================================
+// function:
+//      record the multiplicity of a best hash region
+//
+// args:
+//      1. isClose: TRUE if the best region is in the close
+//                  search region
+//      2. numPos : number of positions of the best region
+//==============================================================
+void SR_MapStatsAddNumPos(SR_Bool isClose, uint32_t numPos);
+
+//==============================================================
+// function:
+//      merge the statistics of one thread into another
+//
+// args:
+//      1. pDst: a pointer to the destination statistics
+//      2. pSrc: a pointer to the source statistics
+//==============================================================
+void SR_MapStatsMerge(SR_MapStats* pDst, const SR_MapStats* pSrc);
+
+//==============================================================
+// function:
+//      write the statistics report of each chromosome and
+//      each alignment type
+//
+// args:
+//      1. pMapStats: a pointer to a statistics object
+//      2. refNames : names of the chromosomes, NULL to use
+//                    the reference IDs
+//      3. format   : report format (JSON or TSV)
+//      4. output   : output stream of the report
+//
+// discussion:
+//      cells without any loaded or filtered query are not
+//      reported
+//==============================================================
+void SR_MapStatsWrite(const SR_MapStats* pMapStats, char** refNames, SR_MapStatsFormat format, FILE* output);
+
+#endif  /*SR_MAPSTATS_H*/
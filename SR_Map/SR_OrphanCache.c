@@ -0,0 +1,199 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_OrphanCache.c
+ *
+ *    Description:  memo cache of the best hash regions of recent orphan sequences
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:14:20 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SR_Error.h"
+#include "SR_Utilities.h"
+#include "SR_OrphanCache.h"
+
+
+//=========================
+// Static methods
+//=========================
+
+// FNV-1a hash of the orphan sequence mixed with the strand and the search region
+static uint64_t GetQueryHash(const SR_QueryRegion* pQueryRegion, int32_t refID)
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (unsigned int i = 0; i != SR_GetQueryLen(pQueryRegion->pOrphan); ++i)
+    {
+        hash ^= (unsigned char) pQueryRegion->orphanSeq[i];
+        hash *= 1099511628211ULL;
+    }
+
+    hash ^= ((uint64_t) pQueryRegion->farRefBegin << 32) ^ ((uint64_t) refID << 1) ^ SR_GetStrand(pQueryRegion->pOrphan);
+    hash *= 1099511628211ULL;
+
+    // zero is reserved for the empty entries
+    return (hash == 0 ? 1 : hash);
+}
+
+// check if a cache entry holds the query
+static SR_Bool IsSameQuery(const SR_OrphanCacheEntry* pEntry, uint64_t seqHash, const SR_QueryRegion* pQueryRegion, int32_t refID)
+{
+    return (pEntry->seqHash == seqHash
+            && pEntry->refID == refID
+            && pEntry->strand == SR_GetStrand(pQueryRegion->pOrphan)
+            && pEntry->hashBegin == pQueryRegion->hashBegin
+            && pEntry->hashEnd == pQueryRegion->hashEnd
+            && pEntry->closeRefBegin == pQueryRegion->closeRefBegin
+            && pEntry->closeRefEnd == pQueryRegion->closeRefEnd
+            && pEntry->farRefBegin == pQueryRegion->farRefBegin
+            && pEntry->farRefEnd == pQueryRegion->farRefEnd
+            && pEntry->seqLen == SR_GetQueryLen(pQueryRegion->pOrphan)
+            && memcmp(pEntry->orphanSeq, pQueryRegion->orphanSeq, pEntry->seqLen) == 0);
+}
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_OrphanCache* SR_OrphanCacheAlloc(unsigned int capacity)
+{
+    SR_OrphanCache* pOrphanCache = (SR_OrphanCache*) malloc(sizeof(SR_OrphanCache));
+    if (pOrphanCache == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for an orphan cache object.\n");
+
+    if (capacity == 0)
+        capacity = DEFAULT_ORPHAN_CACHE_SIZE;
+
+    pOrphanCache->entries = (SR_OrphanCacheEntry*) calloc(capacity, sizeof(SR_OrphanCacheEntry));
+    if (pOrphanCache->entries == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the entries in the orphan cache object.\n");
+
+    pOrphanCache->capacity = capacity;
+    pOrphanCache->numLookups = 0;
+    pOrphanCache->numHits = 0;
+
+    return pOrphanCache;
+}
+
+void SR_OrphanCacheFree(SR_OrphanCache* pOrphanCache)
+{
+    if (pOrphanCache != NULL)
+    {
+        for (unsigned int i = 0; i != pOrphanCache->capacity; ++i)
+        {
+            free(pOrphanCache->entries[i].orphanSeq);
+            free(pOrphanCache->entries[i].bests);
+        }
+
+        free(pOrphanCache->entries);
+        free(pOrphanCache);
+    }
+}
+
+
+//======================
+// Interface functions
+//======================
+
+SR_Bool SR_OrphanCacheLoad(SR_OrphanCache* pOrphanCache, HashRegionTable* pRegionTable, const SR_QueryRegion* pQueryRegion, int32_t refID)
+{
+    ++(pOrphanCache->numLookups);
+
+    uint64_t seqHash = GetQueryHash(pQueryRegion, refID);
+    const SR_OrphanCacheEntry* pEntry = pOrphanCache->entries + (seqHash % pOrphanCache->capacity);
+
+    if (!IsSameQuery(pEntry, seqHash, pQueryRegion, refID))
+        return FALSE;
+
+    // restore the best regions with the epoch of the current query
+    for (unsigned int i = 0; i != pEntry->numBests; ++i)
+    {
+        const SR_CachedBest* pCachedBest = pEntry->bests + i;
+
+        BestRegion* pBestFar = SR_ARRAY_GET_PT(pRegionTable->pBestFarRegions, pCachedBest->queryPos);
+        *pBestFar = pCachedBest->bestFar;
+        pBestFar->epoch = pRegionTable->epoch;
+
+        if (pCachedBest->isCloseSet)
+        {
+            BestRegion* pBestClose = SR_ARRAY_GET_PT(pRegionTable->pBestCloseRegions, pCachedBest->queryPos);
+            *pBestClose = pCachedBest->bestClose;
+            pBestClose->epoch = pRegionTable->epoch;
+        }
+
+        SR_ARRAY_PUSH(pRegionTable->pBestPos, &(pCachedBest->queryPos), uint32_t);
+    }
+
+    ++(pOrphanCache->numHits);
+
+    return TRUE;
+}
+
+void SR_OrphanCacheStore(SR_OrphanCache* pOrphanCache, const HashRegionTable* pRegionTable, const SR_QueryRegion* pQueryRegion, int32_t refID)
+{
+    uint64_t seqHash = GetQueryHash(pQueryRegion, refID);
+    SR_OrphanCacheEntry* pEntry = pOrphanCache->entries + (seqHash % pOrphanCache->capacity);
+
+    uint32_t seqLen = SR_GetQueryLen(pQueryRegion->pOrphan);
+    if (pEntry->seqCap < seqLen)
+    {
+        free(pEntry->orphanSeq);
+
+        pEntry->seqCap = seqLen;
+        pEntry->orphanSeq = (char*) malloc(sizeof(char) * pEntry->seqCap);
+        if (pEntry->orphanSeq == NULL)
+            SR_ErrQuit("ERROR: Not enough memory for the orphan sequence in an orphan cache entry.\n");
+    }
+
+    unsigned int numBests = SR_ARRAY_GET_SIZE(pRegionTable->pBestPos);
+    if (pEntry->bestCap < numBests)
+    {
+        free(pEntry->bests);
+
+        pEntry->bestCap = numBests;
+        pEntry->bests = (SR_CachedBest*) malloc(sizeof(SR_CachedBest) * pEntry->bestCap);
+        if (pEntry->bests == NULL)
+            SR_ErrQuit("ERROR: Not enough memory for the best regions in an orphan cache entry.\n");
+    }
+
+    memcpy(pEntry->orphanSeq, pQueryRegion->orphanSeq, seqLen);
+    pEntry->seqLen = seqLen;
+    pEntry->seqHash = seqHash;
+
+    pEntry->refID = refID;
+    pEntry->strand = SR_GetStrand(pQueryRegion->pOrphan);
+    pEntry->hashBegin = pQueryRegion->hashBegin;
+    pEntry->hashEnd = pQueryRegion->hashEnd;
+    pEntry->closeRefBegin = pQueryRegion->closeRefBegin;
+    pEntry->closeRefEnd = pQueryRegion->closeRefEnd;
+    pEntry->farRefBegin = pQueryRegion->farRefBegin;
+    pEntry->farRefEnd = pQueryRegion->farRefEnd;
+
+    // only the positions that have best regions are stored
+    for (unsigned int i = 0; i != numBests; ++i)
+    {
+        SR_CachedBest* pCachedBest = pEntry->bests + i;
+        pCachedBest->queryPos = SR_ARRAY_GET(pRegionTable->pBestPos, i);
+
+        const BestRegion* pBestClose = SR_ARRAY_GET_PT(pRegionTable->pBestCloseRegions, pCachedBest->queryPos);
+        pCachedBest->isCloseSet = (pBestClose->epoch == pRegionTable->epoch);
+        if (pCachedBest->isCloseSet)
+            pCachedBest->bestClose = *pBestClose;
+
+        pCachedBest->bestFar = SR_ARRAY_GET(pRegionTable->pBestFarRegions, pCachedBest->queryPos);
+    }
+
+    pEntry->numBests = numBests;
+}
@@ -0,0 +1,171 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_OrphanCache.h
+ *
+ *    Description:  memo cache of the best hash regions of recent orphan sequences
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:14:20 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SR_ORPHANCACHE_H
+#define  SR_ORPHANCACHE_H
+
+#include <stdint.h>
+
+#include "SR_Types.h"
+#include "SR_HashRegionTable.h"
+#include "SR_QueryRegion.h"
+
+//===============================
+// Type and constant definition
+//===============================
+
+// default number of entries in an orphan cache
+#define DEFAULT_ORPHAN_CACHE_SIZE 64
+
+// best hash regions that start at a certain query position
+typedef struct SR_CachedBest
+{
+    uint32_t queryPos;           // query position where the best hash regions start
+
+    SR_Bool isCloseSet;          // boolean variable used to indicate if the best close region is set
+
+    BestRegion bestClose;        // best hash region within the close search region
+
+    BestRegion bestFar;          // best hash region within the far search region
+
+}SR_CachedBest;
+
+// the best hash regions of an orphan sequence in a certain search region
+typedef struct SR_OrphanCacheEntry
+{
+    uint64_t seqHash;            // hash value of the orphan sequence (0 for an empty entry)
+
+    char* orphanSeq;             // copy of the orphan sequence, used to rule out hash collisions
+
+    uint32_t seqLen;             // length of the orphan sequence
+
+    uint32_t seqCap;             // capacity of the orphan sequence copy
+
+    int32_t refID;               // reference ID of the search region
+
+    SR_Strand strand;            // strand of the orphan mate
+
+    uint32_t hashBegin;          // begin position of the hashed segment of the orphan sequence
+
+    uint32_t hashEnd;            // end position of the hashed segment of the orphan sequence
+
+    uint32_t closeRefBegin;      // begin position of the close search region
+
+    uint32_t closeRefEnd;        // end position of the close search region
+
+    uint32_t farRefBegin;        // begin position of the far search region
+
+    uint32_t farRefEnd;          // end position of the far search region
+
+    SR_CachedBest* bests;        // best hash regions of the orphan sequence
+
+    unsigned int numBests;       // number of the best hash regions
+
+    unsigned int bestCap;        // capacity of the best hash region array
+
+}SR_OrphanCacheEntry;
+
+// a small direct-mapped cache (one for each thread)
+typedef struct SR_OrphanCache
+{
+    SR_OrphanCacheEntry* entries;    // cache entries
+
+    unsigned int capacity;           // number of the cache entries
+
+    uint64_t numLookups;             // number of lookups
+
+    uint64_t numHits;                // number of lookups that reused the cached best regions
+
+}SR_OrphanCache;
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_OrphanCache* SR_OrphanCacheAlloc(unsigned int capacity);
+
+void SR_OrphanCacheFree(SR_OrphanCache* pOrphanCache);
+
+
+//======================
+// Interface functions
+//======================
+
+//==============================================================
+// function:
+//      restore the best hash regions of a query from the cache
+//
+// args:
+//      1. pOrphanCache: a pointer to an orphan cache
+//      2. pRegionTable: a pointer to a hash region table that
+//                       has been initialized for the query
+//      3. pQueryRegion: a pointer to a query region
+//      4. refID       : reference ID of the search region
+//
+// return:
+//      TRUE if the query was found in the cache and its best
+//      hash regions were restored into the hash region table.
+//      FALSE if "HashRegionTableLoad" has to be called
+//
+// discussion:
+//      the key is the orphan sequence, its strand, the hashed
+//      segment and the search regions. a typical usage is:
+//
+//      HashRegionTableInit(pRegionTable, queryLen);
+//      if (!SR_OrphanCacheLoad(pCache, pRegionTable, pQueryRegion, refID))
+//      {
+//          HashRegionTableLoad(pRegionTable, pHashTable, pQueryRegion);
+//          SR_OrphanCacheStore(pCache, pRegionTable, pQueryRegion, refID);
+//      }
+//
+//      the seeding mode of the hash region table should not
+//      change while the cache is in use
+//==============================================================
+SR_Bool SR_OrphanCacheLoad(SR_OrphanCache* pOrphanCache, HashRegionTable* pRegionTable, const SR_QueryRegion* pQueryRegion, int32_t refID);
+
+//==============================================================
+// function:
+//      store the best hash regions of a query into the cache
+//
+// args:
+//      1. pOrphanCache: a pointer to an orphan cache
+//      2. pRegionTable: a pointer to a hash region table loaded
+//                       with the query (before the best hash
+//                       regions are reversed)
+//      3. pQueryRegion: a pointer to a query region
+//      4. refID       : reference ID of the search region
+//==============================================================
+void SR_OrphanCacheStore(SR_OrphanCache* pOrphanCache, const HashRegionTable* pRegionTable, const SR_QueryRegion* pQueryRegion, int32_t refID);
+
+//==============================================================
+// function:
+//      get the hit rate of an orphan cache
+//
+// args:
+//      1. pOrphanCache: a pointer to an orphan cache
+//
+// return:
+//      the fraction of lookups served by the cache
+//==============================================================
+static inline double SR_OrphanCacheGetHitRate(const SR_OrphanCache* pOrphanCache)
+{
+    return (pOrphanCache->numLookups == 0 ? 0.0 : (double) pOrphanCache->numHits / pOrphanCache->numLookups);
+}
+
+#endif  /*SR_ORPHANCACHE_H*/
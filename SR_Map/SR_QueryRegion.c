@@ -53,6 +53,9 @@ SR_QueryRegion* SR_QueryRegionAlloc(void)
     pNewRegion->isOrphanInversed = FALSE;
     pNewRegion->capacity = 0;
 
+    pNewRegion->hashBegin = 0;
+    pNewRegion->hashEnd = 0;
+
     pNewRegion->closeRefBegin = 0;
     pNewRegion->closeRefEnd = 0;
     pNewRegion->farRefBegin = 0;
@@ -70,6 +73,30 @@ void SR_QueryRegionFree(SR_QueryRegion* pQueryRegion)
     }
 }
 
+SR_SearchArgsTable* SR_SearchArgsTableAlloc(const SR_SearchArgs* pDefaultArgs)
+{
+    SR_SearchArgsTable* pArgsTable = (SR_SearchArgsTable*) calloc(1, sizeof(SR_SearchArgsTable));
+    if (pArgsTable == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for a search arguments table object.\n");
+
+    pArgsTable->defaultArgs = *pDefaultArgs;
+    pArgsTable->pReadGrpArgs = NULL;
+
+    pArgsTable->size = 0;
+    pArgsTable->capacity = 0;
+
+    return pArgsTable;
+}
+
+void SR_SearchArgsTableFree(SR_SearchArgsTable* pArgsTable)
+{
+    if (pArgsTable != NULL)
+    {
+        free(pArgsTable->pReadGrpArgs);
+        free(pArgsTable);
+    }
+}
+
 
 //======================
 // Interface functions
@@ -112,6 +139,12 @@ void SR_QueryRegionLoadSeq(SR_QueryRegion* pQueryRegion)
     {
         pQueryRegion->orphanSeq[i] = SR_BASE_MAP[bam1_seqi(seq, i)];
     }
+
+    pQueryRegion->isOrphanInversed = FALSE;
+
+    // by default the whole sequence will be hashed
+    pQueryRegion->hashBegin = 0;
+    pQueryRegion->hashEnd = pQueryRegion->pOrphan->core.l_qseq;
 }
 
 void SR_QueryRegionChangeSeq(SR_QueryRegion* pQueryRegion, SR_SeqAction action)
@@ -122,6 +155,12 @@ void SR_QueryRegionChangeSeq(SR_QueryRegion* pQueryRegion, SR_SeqAction action)
         {
             SR_SWAP(pQueryRegion->orphanSeq[i], pQueryRegion->orphanSeq[j], char);
         }
+
+        uint32_t hashBegin = pQueryRegion->pOrphan->core.l_qseq - pQueryRegion->hashEnd;
+        pQueryRegion->hashEnd = pQueryRegion->pOrphan->core.l_qseq - pQueryRegion->hashBegin;
+        pQueryRegion->hashBegin = hashBegin;
+
+        pQueryRegion->isOrphanInversed = !(pQueryRegion->isOrphanInversed);
     }
 
     if (action == SR_COMP || action == SR_REVERSE_COMP)
@@ -150,6 +189,53 @@ void SR_QueryRegionChangeSeq(SR_QueryRegion* pQueryRegion, SR_SeqAction action)
     }
 }
 
+SR_Bool SR_QueryRegionSetSoftClip(SR_QueryRegion* pQueryRegion, unsigned char hashSize)
+{
+    if (pQueryRegion->algnType != SR_UNIQUE_SOFT)
+        return FALSE;
+
+    const bam1_t* pOrphan = pQueryRegion->pOrphan;
+    const uint32_t* cigar = bam1_cigar(pOrphan);
+    uint32_t queryLen = pOrphan->core.l_qseq;
+
+    uint32_t headClip = 0;
+    if ((cigar[0] & BAM_CIGAR_MASK) == BAM_CSOFT_CLIP)
+        headClip = cigar[0] >> BAM_CIGAR_SHIFT;
+
+    uint32_t tailClip = 0;
+    unsigned int lastIndex = pOrphan->core.n_cigar - 1;
+    if ((cigar[lastIndex] & BAM_CIGAR_MASK) == BAM_CSOFT_CLIP)
+        tailClip = cigar[lastIndex] >> BAM_CIGAR_SHIFT;
+
+    if (headClip == 0 && tailClip == 0)
+        return FALSE;
+
+    // the mate is clipped on only one side in a unique-soft pair (SR_CheckAlignment).
+    // we take the longer clip in case a short clip below the tolerance is on the other side
+    uint32_t hashBegin = 0;
+    uint32_t hashEnd = queryLen;
+    if (headClip >= tailClip)
+    {
+        hashEnd = headClip + hashSize - 1;
+        if (hashEnd > queryLen)
+            hashEnd = queryLen;
+    }
+    else
+    {
+        if (tailClip + hashSize - 1 < queryLen)
+            hashBegin = queryLen - tailClip - (hashSize - 1);
+    }
+
+    pQueryRegion->hashBegin = hashBegin;
+    pQueryRegion->hashEnd = hashEnd;
+
+    // the aligned part is kept as the close partial alignment
+    pQueryRegion->closeRefBegin = pOrphan->core.pos;
+    pQueryRegion->closeRefEnd = bam_calend(&(pOrphan->core), cigar) - 1;
+
+    return TRUE;
+}
+
 SR_Bool SR_QueryRegionSetRange(SR_QueryRegion* pQueryRegion, const SR_SearchArgs* pSearchArgs, uint32_t refLen, SR_Direction direction)
 {
     if (direction == SR_DOWNSTREAM) // the position of the search region is greater than that of the anchor mate
@@ -205,3 +291,60 @@ SR_Bool SR_QueryRegionSetRange(SR_QueryRegion* pQueryRegion, const SR_SearchArgs
 
     return TRUE;
 }
+
+void SR_SearchArgsTableInit(SR_SearchArgsTable* pArgsTable, const SR_LibInfoTable* pLibTable, unsigned int maxReadLen)
+{
+    if (pLibTable->size > pArgsTable->capacity)
+    {
+        free(pArgsTable->pReadGrpArgs);
+
+        pArgsTable->capacity = pLibTable->size;
+        pArgsTable->pReadGrpArgs = (SR_SearchArgs*) malloc(pArgsTable->capacity * sizeof(SR_SearchArgs));
+        if (pArgsTable->pReadGrpArgs == NULL)
+            SR_ErrQuit("ERROR: Not enough memory for the storage of search arguments in the search arguments table object.\n");
+    }
+
+    pArgsTable->size = pLibTable->size;
+
+    const SR_SearchArgs* pDefaultArgs = &(pArgsTable->defaultArgs);
+    for (unsigned int i = 0; i != pArgsTable->size; ++i)
+    {
+        const SR_LibInfo* pLibInfo = pLibTable->pLibInfo + i;
+        SR_SearchArgs* pReadGrpArgs = pArgsTable->pReadGrpArgs + i;
+
+        *pReadGrpArgs = *pDefaultArgs;
+
+        // the library does not have a valid fragment length distribution
+        // we have to fall back to the global search arguments
+        if (pLibInfo->fragLenMedian <= 0 || pLibInfo->fragLenHigh < pLibInfo->fragLenLow)
+            continue;
+
+        // the close region is centred on the library so that it covers
+        // the whole normal fragment length range of the library
+        pReadGrpArgs->fragLen = pLibInfo->fragLenMedian;
+        pReadGrpArgs->closeRange = (pLibInfo->fragLenHigh - pLibInfo->fragLenLow) + 2 * maxReadLen;
+
+        if (pReadGrpArgs->farRange < pReadGrpArgs->closeRange)
+            pReadGrpArgs->farRange = pReadGrpArgs->closeRange;
+    }
+}
+
+const SR_SearchArgs* SR_SearchArgsTableGet(const SR_SearchArgsTable* pArgsTable, const SR_LibInfoTable* pLibTable, const bam1_t* pAnchor)
+{
+    if (pLibTable == NULL || pArgsTable->size == 0)
+        return &(pArgsTable->defaultArgs);
+
+    static const char tagRG[2] = {'R', 'G'};
+    uint8_t* rgPos = bam_aux_get(pAnchor, tagRG);
+    if (rgPos == NULL)
+        return &(pArgsTable->defaultArgs);
+
+    int32_t readGrpID = 0;
+    if (SR_LibInfoTableGetRGIndex(&readGrpID, pLibTable, bam_aux2Z(rgPos)) != SR_OK
+        || readGrpID < 0 || (uint32_t) readGrpID >= pArgsTable->size)
+    {
+        return &(pArgsTable->defaultArgs);
+    }
+
+    return (pArgsTable->pReadGrpArgs + readGrpID);
+}
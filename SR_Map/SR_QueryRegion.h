@@ -21,7 +21,9 @@
 
 #include "bam.h"
 #include "SR_Types.h"
+#include "SR_LibInfo.h"
 #include "SR_BamInStream.h"
+#include "SR_RefSliceCache.h"
 
 //===============================
 // Type and constant definition
@@ -41,6 +43,19 @@ typedef struct SR_SearchArgs
 
 }SR_SearchArgs;
 
+// search arguments of each read group derived from the library information table
+typedef struct SR_SearchArgsTable
+{
+    SR_SearchArgs defaultArgs;      // global search arguments, used when the read group of an anchor is unknown
+
+    SR_SearchArgs* pReadGrpArgs;    // search arguments of each read group (indexed by the read group ID in the library table)
+
+    uint32_t size;                  // number of read groups
+
+    uint32_t capacity;              // capacity of the search arguments array
+
+}SR_SearchArgsTable;
+
 // an object that hold the unique-orphan pair and the targeting region for split alignment
 typedef struct SR_QueryRegion
 {
@@ -56,6 +71,10 @@ typedef struct SR_QueryRegion
 
     unsigned int capacity;          // capacity of the sequence of the orphan read in the current object
 
+    uint32_t hashBegin;             // begin position of the segment of the orphan sequence that will be hashed
+
+    uint32_t hashEnd;               // end position (exclusive) of the segment of the orphan sequence that will be hashed
+
     uint32_t closeRefBegin;         // the begin position of the search region for the first partial alignment (closer to the anchor mate)
 
     uint32_t closeRefEnd;           // the end position of the search region for the first partial alignment (closer to the anchor mate)
@@ -75,6 +94,10 @@ SR_QueryRegion* SR_QueryRegionAlloc(void);
 
 void SR_QueryRegionFree(SR_QueryRegion* pQueryRegion);
 
+SR_SearchArgsTable* SR_SearchArgsTableAlloc(const SR_SearchArgs* pDefaultArgs);
+
+void SR_SearchArgsTableFree(SR_SearchArgsTable* pArgsTable);
+
 
 //==================
 // Inline functions
@@ -155,10 +178,40 @@ void SR_QueryRegionLoadSeq(SR_QueryRegion* pQueryRegion);
 //
 // discussion:
 //      the strand of the orphan mate will not be set.
-//      you have to set it through the "SR_SetStrand"
+//      you have to set it through the "SR_SetStrand". the
+//      hashed segment is flipped along with the sequence
 //==============================================================
 void SR_QueryRegionChangeSeq(SR_QueryRegion* pQueryRegion, SR_SeqAction action);
 
+//==============================================================
+// function:
+//      restrict the hashed segment of a unique-soft pair to the
+//      soft clipped part of the mate and use its aligned part
+//      as the close partial alignment
+//
+// args:
+//      1. pQueryRegion: a pointer to an query region structure
+//      2. hashSize    : hash size of the reference hash table
+//
+// return:
+//      TRUE if the query region is in the soft clipping mode.
+//      FALSE if the pair is not a unique-soft pair and the
+//      whole sequence will be hashed
+//
+// discussion:
+//      this function should be called after the sequence is
+//      loaded ("SR_QueryRegionLoadSeq") and the search region
+//      is set ("SR_QueryRegionSetRange") but before the
+//      sequence is changed ("SR_QueryRegionChangeSeq"), which
+//      flips the hashed segment if needed. the hashed segment
+//      covers the clipped bases plus (hashSize - 1) bases of
+//      the aligned part so that the k-mers spanning the clip
+//      boundary are kept. the close search region is replaced
+//      by the span of the aligned part on the reference and
+//      the clipped segment is searched in the far region
+//==============================================================
+SR_Bool SR_QueryRegionSetSoftClip(SR_QueryRegion* pQueryRegion, unsigned char hashSize);
+
 
 //==============================================================
 // function:
@@ -181,6 +234,71 @@ void SR_QueryRegionChangeSeq(SR_QueryRegion* pQueryRegion, SR_SeqAction action);
 //==============================================================
 SR_Bool SR_QueryRegionSetRange(SR_QueryRegion* pQueryRegion, const SR_SearchArgs* pSearchArgs, uint32_t refLen, SR_Direction direction);
 
+//==============================================================
+// function:
+//      precompute the search arguments of each read group from
+//      the fragment length distribution of its library
+//
+// args:
+//      1. pArgsTable: a pointer to a search arguments table
+//      2. pLibTable : a pointer to the library information
+//                     table
+//      3. maxReadLen: maximum read length of the libraries
+//
+// discussion:
+//      the fragment length is set to the library median and
+//      the close range is set to the spread between the low
+//      and high fragment length cutoffs, padded by the read
+//      length on both sides so that a whole read can still
+//      fit into the search region. the far range bounds the
+//      event size rather than the library so it is kept from
+//      the global search arguments (it is widened to the close
+//      range if needed). the library table is not kept by the
+//      search arguments table
+//==============================================================
+void SR_SearchArgsTableInit(SR_SearchArgsTable* pArgsTable, const SR_LibInfoTable* pLibTable, unsigned int maxReadLen);
+
+//==============================================================
+// function:
+//      get the search arguments for the read group of an
+//      anchor alignment
+//
+// args:
+//      1. pArgsTable: a pointer to a search arguments table
+//      2. pLibTable : the library information table the search
+//                     arguments table was initialized with
+//      3. pAnchor   : a pointer to the anchor alignment
+//
+// return:
+//      the search arguments of the anchor's read group. if
+//      the anchor has no read group or its read group is not
+//      found in the table the global search arguments will be
+//      returned
+//==============================================================
+const SR_SearchArgs* SR_SearchArgsTableGet(const SR_SearchArgsTable* pArgsTable, const SR_LibInfoTable* pLibTable, const bam1_t* pAnchor);
+
+//==============================================================
+// function:
+//      set the search region for the split aligner with the
+//      search arguments of the anchor's read group
+//
+// args:
+//      1. pQueryRegion: a pointer to an query region structure
+//      2. pArgsTable  : a pointer to a search arguments table
+//      3. pLibTable   : the library information table of the
+//                       search arguments table
+//      4. refLen      : length of the current chromosome
+//      5. direction   : search direction relative to the anchor
+//                       position, upstream or downstream
+// return:
+//      same as "SR_QueryRegionSetRange"
+//==============================================================
+static inline SR_Bool SR_QueryRegionSetRangeRG(SR_QueryRegion* pQueryRegion, const SR_SearchArgsTable* pArgsTable, const SR_LibInfoTable* pLibTable,
+                                               uint32_t refLen, SR_Direction direction)
+{
+    return SR_QueryRegionSetRange(pQueryRegion, SR_SearchArgsTableGet(pArgsTable, pLibTable, pQueryRegion->pAnchor), refLen, direction);
+}
+
 //==============================================================
 // function:
 //      set the search region on special reference for the 
@@ -199,6 +317,30 @@ static inline void SR_QueryRegionSetRangeSpecial(SR_QueryRegion* pQueryRegion, u
     pQueryRegion->farRefEnd = specialRefLen - 1;
 }
 
+//==============================================================
+// function:
+//      get the decoded reference window covering both search
+//      regions of a query region from a slice cache
+//
+// args:
+//      1. pQueryRegion: a pointer to an query region structure
+//      2. pSliceCache : a pointer to a reference slice cache
+//      3. pRefView    : a view of the whole reference sequence
+//      4. format      : format of the decoded window
+//
+// return:
+//      a pointer to the slice, which must be released by
+//      "SR_RefSliceCacheRelease" after use. NULL if no slice
+//      is available
+//==============================================================
+static inline const SR_RefSlice* SR_QueryRegionGetSlice(const SR_QueryRegion* pQueryRegion, SR_RefSliceCache* pSliceCache, const SR_RefView* pRefView, SR_SliceFormat format)
+{
+    uint32_t refBegin = pQueryRegion->closeRefBegin < pQueryRegion->farRefBegin ? pQueryRegion->closeRefBegin : pQueryRegion->farRefBegin;
+    uint32_t refEnd = pQueryRegion->closeRefEnd > pQueryRegion->farRefEnd ? pQueryRegion->closeRefEnd : pQueryRegion->farRefEnd;
+
+    return SR_RefSliceCacheGet(pSliceCache, pRefView, refBegin, refEnd, format);
+}
+
 #endif  /*SR_QUERYREGION_H*/
 
 
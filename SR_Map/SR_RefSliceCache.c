@@ -0,0 +1,191 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_RefSliceCache.c
+ *
+ *    Description:  cache of decoded reference windows for the split aligner
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:12:21 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SR_Error.h"
+#include "SR_RefSliceCache.h"
+
+
+//=========================
+// Static methods
+//=========================
+
+// decode a window of the reference sequence into a slice
+static void DecodeSlice(SR_RefSlice* pSlice, const SR_RefView* pRefView, uint32_t refBegin, uint32_t refEnd, SR_SliceFormat format)
+{
+    // table use to translate a nucleotide into its corresponding 2-bit representation
+    static const uint8_t translation[26] = { 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0 };
+
+    uint32_t sliceLen = refEnd - refBegin + 1;
+    uint32_t numBytes = (format == SR_SLICE_2BIT ? (sliceLen + 3) / 4 : sliceLen);
+
+    if (pSlice->capacity < numBytes)
+    {
+        free(pSlice->data);
+
+        pSlice->capacity = numBytes;
+        pSlice->data = (char*) malloc(sizeof(char) * pSlice->capacity);
+        if (pSlice->data == NULL)
+            SR_ErrQuit("ERROR: Not enough memory for the storage of a reference slice.\n");
+    }
+
+    const char* sequence = pRefView->sequence + refBegin;
+    if (format == SR_SLICE_2BIT)
+    {
+        memset(pSlice->data, 0, numBytes);
+        for (unsigned int i = 0; i != sliceLen; ++i)
+        {
+            unsigned char base = sequence[i] - 'A';
+            if (base < 26)
+                pSlice->data[i >> 2] |= translation[base] << ((i & 3) << 1);
+        }
+    }
+    else
+        memcpy(pSlice->data, sequence, sliceLen);
+
+    pSlice->source = pRefView->sequence;
+    pSlice->refBegin = refBegin;
+    pSlice->format = format;
+
+    pSlice->view.sequence = pSlice->data;
+    pSlice->view.id = pRefView->id;
+    pSlice->view.seqLen = sliceLen;
+}
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_RefSliceCache* SR_RefSliceCacheAlloc(unsigned int capacity)
+{
+    SR_RefSliceCache* pSliceCache = (SR_RefSliceCache*) malloc(sizeof(SR_RefSliceCache));
+    if (pSliceCache == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for a reference slice cache object.\n");
+
+    if (capacity == 0)
+        capacity = DEFAULT_NUM_REF_SLICES;
+
+    pSliceCache->slices = (SR_RefSlice*) calloc(capacity, sizeof(SR_RefSlice));
+    if (pSliceCache->slices == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the slices in the reference slice cache object.\n");
+
+    pSliceCache->size = 0;
+    pSliceCache->capacity = capacity;
+
+    pSliceCache->clock = 0;
+    pSliceCache->numHits = 0;
+    pSliceCache->numMisses = 0;
+
+    return pSliceCache;
+}
+
+void SR_RefSliceCacheFree(SR_RefSliceCache* pSliceCache)
+{
+    if (pSliceCache != NULL)
+    {
+        for (unsigned int i = 0; i != pSliceCache->capacity; ++i)
+            free(pSliceCache->slices[i].data);
+
+        free(pSliceCache->slices);
+        free(pSliceCache);
+    }
+}
+
+
+//======================
+// Interface functions
+//======================
+
+const SR_RefSlice* SR_RefSliceCacheGet(SR_RefSliceCache* pSliceCache, const SR_RefView* pRefView, uint32_t refBegin, uint32_t refEnd, SR_SliceFormat format)
+{
+    if (refBegin > refEnd || refEnd >= pRefView->seqLen)
+        return NULL;
+
+    ++(pSliceCache->clock);
+
+    // look for a slice that already contains the window
+    SR_RefSlice* pFreeSlice = NULL;
+    for (unsigned int i = 0; i != pSliceCache->size; ++i)
+    {
+        SR_RefSlice* pSlice = pSliceCache->slices + i;
+        if (pSlice->source == pRefView->sequence
+            && pSlice->view.id == pRefView->id
+            && pSlice->format == format
+            && pSlice->refBegin <= refBegin
+            && pSlice->refBegin + pSlice->view.seqLen > refEnd)
+        {
+            ++(pSlice->refCount);
+            pSlice->lastUse = pSliceCache->clock;
+            ++(pSliceCache->numHits);
+
+            return pSlice;
+        }
+
+        // least recently used slice that is not held by anyone
+        if (pSlice->refCount == 0 && (pFreeSlice == NULL || pSlice->lastUse < pFreeSlice->lastUse))
+            pFreeSlice = pSlice;
+    }
+
+    // use an empty slot before evicting an existing slice
+    if (pSliceCache->size < pSliceCache->capacity)
+    {
+        pFreeSlice = pSliceCache->slices + pSliceCache->size;
+        ++(pSliceCache->size);
+    }
+
+    if (pFreeSlice == NULL)
+        return NULL;
+
+    // extend the slice downstream so that the windows of the following anchors fall into it
+    uint32_t sliceEnd = refEnd + (refEnd - refBegin + 1);
+    if (sliceEnd >= pRefView->seqLen || sliceEnd < refEnd)
+        sliceEnd = pRefView->seqLen - 1;
+
+    DecodeSlice(pFreeSlice, pRefView, refBegin, sliceEnd, format);
+
+    pFreeSlice->refCount = 1;
+    pFreeSlice->lastUse = pSliceCache->clock;
+    ++(pSliceCache->numMisses);
+
+    return pFreeSlice;
+}
+
+void SR_RefSliceCacheRelease(SR_RefSliceCache* pSliceCache, const SR_RefSlice* pSlice)
+{
+    SR_RefSlice* pCacheSlice = pSliceCache->slices + (pSlice - pSliceCache->slices);
+    if (pCacheSlice->refCount == 0)
+        SR_ErrQuit("ERROR: A reference slice is released more times than it is requested.\n");
+
+    --(pCacheSlice->refCount);
+}
+
+void SR_RefSliceCacheClear(SR_RefSliceCache* pSliceCache)
+{
+    for (unsigned int i = 0; i != pSliceCache->size; ++i)
+    {
+        SR_RefSlice* pSlice = pSliceCache->slices + i;
+        if (pSlice->refCount == 0)
+        {
+            pSlice->source = NULL;
+            pSlice->view.seqLen = 0;
+        }
+    }
+}
@@ -0,0 +1,184 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_RefSliceCache.h
+ *
+ *    Description:  cache of decoded reference windows for the split aligner
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:12:21 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SR_REFSLICECACHE_H
+#define  SR_REFSLICECACHE_H
+
+#include <stdint.h>
+
+#include "SR_Types.h"
+#include "SR_Reference.h"
+
+//===============================
+// Type and constant definition
+//===============================
+
+// default number of slices held by a slice cache
+#define DEFAULT_NUM_REF_SLICES 8
+
+// format of the reference bases in a slice
+typedef enum
+{
+    SR_SLICE_ASCII = 0,      // one character for each base
+
+    SR_SLICE_2BIT  = 1       // 2 bits for each base (A:0, C:1, G:2, T:3), 4 bases in a byte. other characters are stored as 0
+
+}SR_SliceFormat;
+
+// a decoded window of a reference sequence
+typedef struct SR_RefSlice
+{
+    SR_RefView view;            // view of the window (the sequence points to the decoded data, the length is the window length)
+
+    const char* source;         // the reference sequence the window was decoded from
+
+    uint32_t refBegin;          // begin position of the window on the reference
+
+    char* data;                 // storage of the decoded window
+
+    uint32_t capacity;          // capacity of the storage in bytes
+
+    SR_SliceFormat format;      // format of the decoded window
+
+    unsigned int refCount;      // number of the consumers holding this slice
+
+    uint64_t lastUse;           // time stamp of the last request for this slice
+
+}SR_RefSlice;
+
+// a cache of reference slices
+typedef struct SR_RefSliceCache
+{
+    SR_RefSlice* slices;        // array of the reference slices
+
+    unsigned int size;          // number of the slices in use
+
+    unsigned int capacity;      // maximum number of slices in the cache
+
+    uint64_t clock;             // time stamp of the last request
+
+    uint64_t numHits;           // number of requests served by an existing slice
+
+    uint64_t numMisses;         // number of requests that decoded a new slice
+
+}SR_RefSliceCache;
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_RefSliceCache* SR_RefSliceCacheAlloc(unsigned int capacity);
+
+void SR_RefSliceCacheFree(SR_RefSliceCache* pSliceCache);
+
+
+//==================
+// Inline functions
+//==================
+
+//==============================================================
+// function:
+//      get the address of a reference position in an ASCII
+//      slice
+//
+// args:
+//      1. pSlice: a pointer to a reference slice
+//      2. refPos: a position on the reference inside the slice
+//
+// return:
+//      the address of the base at the reference position
+//==============================================================
+static inline const char* SR_RefSliceGetSeq(const SR_RefSlice* pSlice, uint32_t refPos)
+{
+    return pSlice->data + (refPos - pSlice->refBegin);
+}
+
+//==============================================================
+// function:
+//      get the 2-bit code of a reference position in a 2-bit
+//      slice
+//
+// args:
+//      1. pSlice: a pointer to a reference slice
+//      2. refPos: a position on the reference inside the slice
+//
+// return:
+//      the 2-bit code of the base at the reference position
+//==============================================================
+static inline uint8_t SR_RefSliceGet2Bit(const SR_RefSlice* pSlice, uint32_t refPos)
+{
+    uint32_t offset = refPos - pSlice->refBegin;
+    return (((uint8_t) pSlice->data[offset >> 2]) >> ((offset & 3) << 1)) & 3;
+}
+
+
+//======================
+// Interface functions
+//======================
+
+//==============================================================
+// function:
+//      get a decoded window of a reference sequence
+//
+// args:
+//      1. pSliceCache: a pointer to a slice cache
+//      2. pRefView   : a view of the whole reference sequence
+//                      (a chromosome or the special reference)
+//      3. refBegin   : begin position of the window
+//      4. refEnd     : end position of the window (inclusive)
+//      5. format     : format of the decoded window
+//
+// return:
+//      a pointer to the slice containing the window. the
+//      slice will not be reused until it is released by
+//      "SR_RefSliceCacheRelease". NULL if the window is out
+//      of the reference range or all the slices are in use
+//
+// discussion:
+//      if an existing slice of the same reference and format
+//      contains the window, it is returned without decoding.
+//      otherwise the least recently used free slice is
+//      decoded again. a new slice is extended downstream by
+//      the length of the requested window so that the search
+//      windows of the next anchors ([closeRefBegin, farRefEnd])
+//      can be served by the same slice
+//==============================================================
+const SR_RefSlice* SR_RefSliceCacheGet(SR_RefSliceCache* pSliceCache, const SR_RefView* pRefView, uint32_t refBegin, uint32_t refEnd, SR_SliceFormat format);
+
+//==============================================================
+// function:
+//      release a slice returned by "SR_RefSliceCacheGet"
+//
+// args:
+//      1. pSliceCache: a pointer to a slice cache
+//      2. pSlice     : a pointer to a reference slice
+//==============================================================
+void SR_RefSliceCacheRelease(SR_RefSliceCache* pSliceCache, const SR_RefSlice* pSlice);
+
+//==============================================================
+// function:
+//      drop all the free slices (for example, after the
+//      reference sequence has been replaced)
+//
+// args:
+//      1. pSliceCache: a pointer to a slice cache
+//==============================================================
+void SR_RefSliceCacheClear(SR_RefSliceCache* pSliceCache);
+
+#endif  /*SR_REFSLICECACHE_H*/
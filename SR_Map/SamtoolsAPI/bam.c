@@ -177,6 +177,19 @@ static void swap_endian_data(const bam1_core_t *c, int data_len, uint8_t *data)
 }
 
 int bam_read1(bamFile fp, bam1_t *b)
+{
+	return bam_read1_ext(fp, b, 0);
+}
+
+int bam_read1_ext(bamFile fp, bam1_t *b, int is_borrowed)
+{
+	int ret;
+	if ((ret = bam_read1_core(fp, b)) < 0) return ret;
+	if ((ret = bam_read1_data(fp, b, is_borrowed, 0)) < 0) return ret;
+	return 4 + BAM_CORE_SIZE + ret;
+}
+
+int bam_read1_core(bamFile fp, bam1_t *b)
 {
 	bam1_core_t *c = &b->core;
 	int32_t block_len, ret, i;
@@ -198,15 +211,54 @@ int bam_read1(bamFile fp, bam1_t *b)
 	c->l_qseq = x[4];
 	c->mtid = x[5]; c->mpos = x[6]; c->isize = x[7];
 	b->data_len = block_len - BAM_CORE_SIZE;
-	if (b->m_data < b->data_len) {
-		b->m_data = b->data_len;
+	b->l_aux = b->data_len - c->n_cigar * 4 - c->l_qname - c->l_qseq - (c->l_qseq+1)/2;
+	return 4 + BAM_CORE_SIZE;
+}
+
+int bam_read1_data(bamFile fp, bam1_t *b, int is_borrowed, int drop)
+{
+	bam1_core_t *c = &b->core;
+	int data_len = b->data_len;
+	int head_len = c->l_qname + c->n_cigar * 4;
+	int seq_len = c->l_qseq + (c->l_qseq+1)/2;
+	int keep_len = data_len;
+
+	if (drop & BAM_DROP_SEQ) keep_len -= seq_len;
+	if (drop & BAM_DROP_AUX) keep_len -= b->l_aux;
+	if (b->m_data < keep_len) {
+		b->m_data = keep_len;
 		kroundup32(b->m_data);
-		b->data = (uint8_t*)realloc(b->data, b->m_data);
+		// a borrowed buffer is not ours to free, the record moves to the heap
+		if (is_borrowed) b->data = (uint8_t*)malloc(b->m_data);
+		else b->data = (uint8_t*)realloc(b->data, b->m_data);
+	}
+	if (drop == 0) {
+		if (bam_read(fp, b->data, data_len) != data_len) return -4;
+	} else {
+		uint8_t *p = b->data;
+		if (bam_read(fp, p, head_len) != head_len) return -4;
+		p += head_len;
+		if (drop & BAM_DROP_SEQ) {
+			if (bam_skip(fp, seq_len) != seq_len) return -4;
+			c->l_qseq = 0;
+		} else {
+			if (bam_read(fp, p, seq_len) != seq_len) return -4;
+			p += seq_len;
+		}
+		if (drop & BAM_DROP_AUX) {
+			if (bam_skip(fp, b->l_aux) != b->l_aux) return -4;
+			b->l_aux = 0;
+		} else if (bam_read(fp, p, b->l_aux) != b->l_aux) return -4;
+		b->data_len = keep_len;
 	}
-	if (bam_read(fp, b->data, b->data_len) != b->data_len) return -4;
-	b->l_aux = b->data_len - c->n_cigar * 4 - c->l_qname - c->l_qseq - (c->l_qseq+1)/2;
 	if (bam_is_be) swap_endian_data(c, b->data_len, b->data);
-	return 4 + block_len;
+	return data_len;
+}
+
+int bam_skip1_data(bamFile fp, const bam1_t *b)
+{
+	if (bam_skip(fp, b->data_len) != b->data_len) return -4;
+	return b->data_len;
 }
 
 inline int bam_write1_core(bamFile fp, const bam1_core_t *c, int data_len, uint8_t *data)
@@ -56,6 +56,7 @@ typedef BGZF *bamFile;
 #define bam_dopen(fd, mode) bgzf_fdopen(fd, mode)
 #define bam_close(fp) bgzf_close(fp)
 #define bam_read(fp, buf, size) bgzf_read(fp, buf, size)
+#define bam_skip(fp, size) bgzf_skip(fp, size)
 #define bam_write(fp, buf, size) bgzf_write(fp, buf, size)
 #define bam_tell(fp) bgzf_tell(fp)
 #define bam_seek(fp, pos, dir) bgzf_seek(fp, pos, dir)
@@ -67,6 +68,7 @@ typedef gzFile bamFile;
 #define bam_dopen(fd, mode) gzdopen(fd, mode)
 #define bam_close(fp) gzclose(fp)
 #define bam_read(fp, buf, size) gzread(fp, buf, size)
+#define bam_skip(fp, size) (gzseek(fp, size, SEEK_CUR) < 0? -1 : (size))
 /* no bam_write/bam_tell/bam_seek() here */
 #endif
 
@@ -415,6 +417,59 @@ extern "C" {
 	 */
 	int bam_read1(bamFile fp, bam1_t *b);
 
+	/*!
+	  @abstract   Read an alignment from BAM into a buffer that may not
+	  be owned by the alignment.
+	  @param  fp  BAM file handler
+	  @param  b   read alignment; all members are updated.
+	  @param  is_borrowed  non-zero if b->data points into memory owned
+	  by the caller (e.g. a slab shared by many alignments)
+	  @return     number of bytes read from the file
+
+	  @discussion Same as bam_read1() except that a borrowed buffer is
+	  never passed to realloc() or free(). If the record does not fit,
+	  a new buffer is allocated on the heap and b->data points to it
+	  afterwards; the borrowed buffer is left untouched.
+	 */
+	int bam_read1_ext(bamFile fp, bam1_t *b, int is_borrowed);
+
+	/*! @abstract drop the sequence and the qualities of a record (core.l_qseq is set to 0) */
+#define BAM_DROP_SEQ 0x1
+	/*! @abstract drop the auxiliary data of a record (l_aux is set to 0) */
+#define BAM_DROP_AUX 0x2
+
+	/*!
+	  @abstract   Read the block length and the fixed-size core of an
+	  alignment, leaving the variable-length data in the file.
+	  @param  fp  BAM file handler
+	  @param  b   read alignment; core, data_len and l_aux are updated.
+	  @return     number of bytes read from the file, negative on error
+	  or end of file (same codes as bam_read1())
+
+	  @discussion Must be followed by either bam_read1_data() or
+	  bam_skip1_data() on the same alignment.
+	 */
+	int bam_read1_core(bamFile fp, bam1_t *b);
+
+	/*!
+	  @abstract   Read the variable-length data of an alignment whose
+	  core was read by bam_read1_core().
+	  @param  fp  BAM file handler
+	  @param  b   read alignment
+	  @param  is_borrowed  see bam_read1_ext()
+	  @param  drop  BAM_DROP_SEQ and/or BAM_DROP_AUX; the dropped parts
+	  are skipped in the file and never copied
+	  @return     number of bytes consumed from the file, -4 on error
+	 */
+	int bam_read1_data(bamFile fp, bam1_t *b, int is_borrowed, int drop);
+
+	/*!
+	  @abstract   Skip the variable-length data of an alignment whose
+	  core was read by bam_read1_core().
+	  @return     number of bytes skipped, -4 on error
+	 */
+	int bam_skip1_data(bamFile fp, const bam1_t *b);
+
 	/*!
 	  @abstract Write an alignment to BAM.
 	  @param  fp       BAM file handler
@@ -596,6 +651,16 @@ extern "C" {
 	 */
 	void bam_index_destroy(bam_index_t *idx);
 
+	/*!
+	  @abstract        Get the number of mapped and unmapped reads of a reference from the index.
+	  @param  idx      pointer to the index structure
+	  @param  tid      chromosome ID as is defined in the header
+	  @param  mapped   the returned number of mapped reads
+	  @param  unmapped the returned number of unmapped reads placed on the reference
+	  @return          0 on success; -1 if the index does not keep the numbers
+	 */
+	int bam_index_get_stat(const bam_index_t *idx, int tid, uint64_t *mapped, uint64_t *unmapped);
+
 	/*! @typedef
 	  @abstract      Type of function to be called by bam_fetch().
 	  @param  b     the alignment
@@ -622,6 +687,10 @@ extern "C" {
 
 	bam_iter_t bam_iter_query(const bam_index_t *idx, int tid, int beg, int end);
 	int bam_iter_read(bamFile fp, bam_iter_t iter, bam1_t *b);
+
+	/*! @abstract same as bam_iter_read() for a buffer that may be borrowed (see bam_read1_ext())
+	  and without the parts of the records given by drop (see bam_read1_data()) */
+	int bam_iter_read_ext(bamFile fp, bam_iter_t iter, bam1_t *b, int is_borrowed, int drop);
 	void bam_iter_destroy(bam_iter_t iter);
 
 	/*!
@@ -514,6 +514,21 @@ int bam_index(int argc, char *argv[])
 	return 0;
 }
 
+int bam_index_get_stat(const bam_index_t *idx, int tid, uint64_t *mapped, uint64_t *unmapped)
+{
+	khint_t k;
+	khash_t(i) *h;
+	*mapped = *unmapped = 0;
+	if (tid < 0 || tid >= idx->n) return -1;
+	h = idx->index[tid];
+	k = kh_get(i, h, BAM_MAX_BIN);
+	// the pseudo-bin keeps the offsets of the reference followed by the read counts
+	if (k == kh_end(h) || kh_val(h, k).n < 2) return -1;
+	*mapped = kh_val(h, k).list[1].u;
+	*unmapped = kh_val(h, k).list[1].v;
+	return 0;
+}
+
 int bam_idxstats(int argc, char *argv[])
 {
 	bam_index_t *idx;
@@ -673,11 +688,24 @@ void bam_iter_destroy(bam_iter_t iter)
 }
 
 int bam_iter_read(bamFile fp, bam_iter_t iter, bam1_t *b)
+{
+	return bam_iter_read_ext(fp, iter, b, 0, 0);
+}
+
+static inline int iter_read1(bamFile fp, bam1_t *b, int is_borrowed, int drop)
+{
+	int ret;
+	if ((ret = bam_read1_core(fp, b)) < 0) return ret;
+	if ((ret = bam_read1_data(fp, b, is_borrowed, drop)) < 0) return ret;
+	return 4 + BAM_CORE_SIZE + ret;
+}
+
+int bam_iter_read_ext(bamFile fp, bam_iter_t iter, bam1_t *b, int is_borrowed, int drop)
 {
 	int ret;
 	if (iter && iter->finished) return -1;
 	if (iter == 0 || iter->from_first) {
-		ret = bam_read1(fp, b);
+		ret = iter_read1(fp, b, is_borrowed, drop);
 		if (ret < 0 && iter) iter->finished = 1;
 		return ret;
 	}
@@ -692,7 +720,7 @@ int bam_iter_read(bamFile fp, bam_iter_t iter, bam1_t *b)
 			}
 			++iter->i;
 		}
-		if ((ret = bam_read1(fp, b)) >= 0) {
+		if ((ret = iter_read1(fp, b, is_borrowed, drop)) >= 0) {
 			iter->curr_off = bam_tell(fp);
 			if (b->core.tid != iter->tid || b->core.pos >= iter->end) { // no need to proceed
 				ret = bam_validate1(NULL, b)? -1 : -5; // determine whether end of region or error
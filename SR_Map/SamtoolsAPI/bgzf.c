@@ -33,6 +33,7 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <pthread.h>
 #include "bgzf.h"
 
 #include "khash.h"
@@ -198,6 +199,7 @@ open_write(int fd, int compress_level) // compress_level==-1 for the default lev
     fp->block_offset = 0;
     fp->block_length = 0;
     fp->error = NULL;
+    fp->mt = 0;
     return fp;
 }
 
@@ -363,37 +365,47 @@ deflate_block(BGZF* fp, int block_length)
 }
 
 static
-int
-inflate_block(BGZF* fp, int block_length)
+const char*
+inflate_raw(const bgzf_byte_t* compressed_block, int block_length, void* uncompressed_block, int uncompressed_block_size, int* total_out)
 {
-    // Inflate the block in fp->compressed_block into fp->uncompressed_block
+    // Inflate a compressed block into an uncompressed buffer. Touches no BGZF
+    // state, so the read-ahead workers can call it concurrently.
 
     z_stream zs;
 	int status;
     zs.zalloc = NULL;
     zs.zfree = NULL;
-    zs.next_in = fp->compressed_block + 18;
+    zs.next_in = (Bytef*) compressed_block + 18;
     zs.avail_in = block_length - 16;
-    zs.next_out = fp->uncompressed_block;
-    zs.avail_out = fp->uncompressed_block_size;
+    zs.next_out = uncompressed_block;
+    zs.avail_out = uncompressed_block_size;
 
     status = inflateInit2(&zs, GZIP_WINDOW_BITS);
-    if (status != Z_OK) {
-        report_error(fp, "inflate init failed");
-        return -1;
-    }
+    if (status != Z_OK) return "inflate init failed";
     status = inflate(&zs, Z_FINISH);
     if (status != Z_STREAM_END) {
         inflateEnd(&zs);
-        report_error(fp, "inflate failed");
-        return -1;
+        return "inflate failed";
     }
     status = inflateEnd(&zs);
-    if (status != Z_OK) {
-        report_error(fp, "inflate failed");
+    if (status != Z_OK) return "inflate failed";
+    *total_out = zs.total_out;
+    return NULL;
+}
+
+static
+int
+inflate_block(BGZF* fp, int block_length)
+{
+    // Inflate the block in fp->compressed_block into fp->uncompressed_block
+
+	int total_out = 0;
+	const char* error = inflate_raw(fp->compressed_block, block_length, fp->uncompressed_block, fp->uncompressed_block_size, &total_out);
+    if (error != NULL) {
+        report_error(fp, error);
         return -1;
     }
-    return zs.total_out;
+    return total_out;
 }
 
 static
@@ -467,48 +479,281 @@ static void cache_block(BGZF *fp, int size)
 	memcpy(kh_val(h, k).block, fp->uncompressed_block, MAX_BLOCK_SIZE);
 }
 
-int
-bgzf_read_block(BGZF* fp)
+static inline int64_t raw_tell(BGZF *fp)
 {
-    bgzf_byte_t header[BLOCK_HEADER_LENGTH];
-	int count, size = 0, block_length, remaining;
 #ifdef _USE_KNETFILE
-    int64_t block_address = knet_tell(fp->x.fpr);
-	if (load_block_from_cache(fp, block_address)) return 0;
-    count = knet_read(fp->x.fpr, header, sizeof(header));
+	return knet_tell(fp->x.fpr);
 #else
-    int64_t block_address = ftello(fp->file);
-	if (load_block_from_cache(fp, block_address)) return 0;
-    count = fread(header, 1, sizeof(header), fp->file);
+	return ftello(fp->file);
 #endif
-    if (count == 0) {
-        fp->block_length = 0;
-        return 0;
-    }
-	size = count;
-    if (count != sizeof(header)) {
-        report_error(fp, "read failed");
-        return -1;
-    }
-    if (!check_header(header)) {
-        report_error(fp, "invalid block header");
-        return -1;
-    }
-    block_length = unpackInt16((uint8_t*)&header[16]) + 1;
-    bgzf_byte_t* compressed_block = (bgzf_byte_t*) fp->compressed_block;
-    memcpy(compressed_block, header, BLOCK_HEADER_LENGTH);
-    remaining = block_length - BLOCK_HEADER_LENGTH;
+}
+
+/* Read the next compressed block into compressed_block. Returns the
+ * length of the block, 0 at the end of the file or -1 on error. */
+static int read_raw_block(BGZF *fp, bgzf_byte_t *compressed_block, const char **error)
+{
+	int count, block_length, remaining;
 #ifdef _USE_KNETFILE
-    count = knet_read(fp->x.fpr, &compressed_block[BLOCK_HEADER_LENGTH], remaining);
+	count = knet_read(fp->x.fpr, compressed_block, BLOCK_HEADER_LENGTH);
 #else
-    count = fread(&compressed_block[BLOCK_HEADER_LENGTH], 1, remaining, fp->file);
+	count = fread(compressed_block, 1, BLOCK_HEADER_LENGTH, fp->file);
 #endif
-    if (count != remaining) {
-        report_error(fp, "read failed");
-        return -1;
-    }
-	size += count;
-    count = inflate_block(fp, block_length);
+	if (count == 0) return 0;
+	if (count != BLOCK_HEADER_LENGTH) {
+		*error = "read failed";
+		return -1;
+	}
+	if (!check_header(compressed_block)) {
+		*error = "invalid block header";
+		return -1;
+	}
+	block_length = unpackInt16((uint8_t*)&compressed_block[16]) + 1;
+	remaining = block_length - BLOCK_HEADER_LENGTH;
+#ifdef _USE_KNETFILE
+	count = knet_read(fp->x.fpr, &compressed_block[BLOCK_HEADER_LENGTH], remaining);
+#else
+	count = fread(&compressed_block[BLOCK_HEADER_LENGTH], 1, remaining, fp->file);
+#endif
+	if (count != remaining) {
+		*error = "read failed";
+		return -1;
+	}
+	return block_length;
+}
+
+/*
+ * Multi-threaded read-ahead. The thread calling bgzf_read keeps doing all
+ * the file I/O: it reads up to n_slots compressed blocks ahead into a ring
+ * of slots and a pool of workers inflates them. Blocks are handed to
+ * bgzf_read strictly in file order by swapping the inflated buffer with
+ * fp->uncompressed_block, so block_address/block_offset/bgzf_tell keep
+ * their single-threaded meaning.
+ */
+
+#define MT_SLOTS_PER_THREAD 4
+
+enum { MT_EMPTY = 0, MT_QUEUED, MT_INFLATING, MT_DONE };
+
+typedef struct {
+	bgzf_byte_t *compressed_block;
+	void *uncompressed_block;
+	int block_length; // compressed length
+	int size;         // inflated length
+	const char *error;
+	int64_t block_address, end_address;
+	int state;
+} mt_slot_t;
+
+typedef struct {
+	int n_threads, n_slots;
+	pthread_t *threads;
+	pthread_mutex_t lock;
+	pthread_cond_t work_cond, done_cond;
+	mt_slot_t *slots;
+	int head, n_used, n_queued; // next slot to consume; slots holding a block; slots waiting for a worker
+	int is_eof, stop;
+	int64_t block_end; // file offset after the block in fp->uncompressed_block
+} mt_t;
+
+static void *mt_worker(void *data)
+{
+	mt_t *mt = (mt_t*)data;
+	mt_slot_t *s = 0;
+	int i;
+	pthread_mutex_lock(&mt->lock);
+	for (;;) {
+		while (!mt->stop && mt->n_queued == 0)
+			pthread_cond_wait(&mt->work_cond, &mt->lock);
+		if (mt->stop) break;
+		for (i = 0; i < mt->n_used; ++i) { // the oldest queued block first
+			s = &mt->slots[(mt->head + i) % mt->n_slots];
+			if (s->state == MT_QUEUED) break;
+		}
+		s->state = MT_INFLATING;
+		--mt->n_queued;
+		pthread_mutex_unlock(&mt->lock);
+		s->error = inflate_raw(s->compressed_block, s->block_length, s->uncompressed_block, MAX_BLOCK_SIZE, &s->size);
+		pthread_mutex_lock(&mt->lock);
+		s->state = MT_DONE;
+		pthread_cond_broadcast(&mt->done_cond);
+	}
+	pthread_mutex_unlock(&mt->lock);
+	return 0;
+}
+
+/* Read compressed blocks into the free slots and queue them. Only the
+ * consumer calls this, so the file is never touched by the workers. */
+static void mt_fill(BGZF *fp)
+{
+	mt_t *mt = (mt_t*)fp->mt;
+	mt_slot_t *s;
+	while (!mt->is_eof) {
+		pthread_mutex_lock(&mt->lock);
+		if (mt->n_used == mt->n_slots) {
+			pthread_mutex_unlock(&mt->lock);
+			break;
+		}
+		s = &mt->slots[(mt->head + mt->n_used) % mt->n_slots];
+		pthread_mutex_unlock(&mt->lock);
+
+		s->block_address = raw_tell(fp);
+		s->error = NULL;
+		s->block_length = read_raw_block(fp, s->compressed_block, &s->error);
+		if (s->block_length == 0) { // end of file
+			mt->is_eof = 1;
+			break;
+		}
+
+		pthread_mutex_lock(&mt->lock);
+		if (s->block_length < 0) { // surfaces when bgzf_read reaches this block
+			mt->is_eof = 1;
+			s->state = MT_DONE;
+		} else {
+			s->end_address = s->block_address + s->block_length;
+			s->state = MT_QUEUED;
+			++mt->n_queued;
+			pthread_cond_signal(&mt->work_cond);
+		}
+		++mt->n_used;
+		pthread_mutex_unlock(&mt->lock);
+	}
+}
+
+static int mt_read_block(BGZF *fp)
+{
+	mt_t *mt = (mt_t*)fp->mt;
+	mt_slot_t *s;
+	void *tmp;
+	mt_fill(fp);
+	pthread_mutex_lock(&mt->lock);
+	if (mt->n_used == 0) {
+		pthread_mutex_unlock(&mt->lock);
+		fp->block_length = 0;
+		return 0;
+	}
+	s = &mt->slots[mt->head];
+	while (s->state != MT_DONE)
+		pthread_cond_wait(&mt->done_cond, &mt->lock);
+	pthread_mutex_unlock(&mt->lock);
+	if (s->error) {
+		report_error(fp, s->error);
+		return -1;
+	}
+
+	tmp = fp->uncompressed_block;
+	fp->uncompressed_block = s->uncompressed_block;
+	s->uncompressed_block = tmp;
+	if (fp->block_length != 0) {
+		// Do not reset offset if this read follows a seek.
+		fp->block_offset = 0;
+	}
+	fp->block_address = s->block_address;
+	fp->block_length = s->size;
+	mt->block_end = s->end_address;
+
+	pthread_mutex_lock(&mt->lock);
+	s->state = MT_EMPTY;
+	mt->head = (mt->head + 1) % mt->n_slots;
+	--mt->n_used;
+	pthread_mutex_unlock(&mt->lock);
+	mt_fill(fp);
+	return 0;
+}
+
+/* Drop the blocks read ahead, e.g. before a seek. */
+static void mt_reset(BGZF *fp)
+{
+	mt_t *mt = (mt_t*)fp->mt;
+	int i, n_inflating;
+	pthread_mutex_lock(&mt->lock);
+	for (;;) { // the workers may still be writing into the slots
+		for (i = n_inflating = 0; i < mt->n_slots; ++i)
+			if (mt->slots[i].state == MT_INFLATING) ++n_inflating;
+		if (n_inflating == 0) break;
+		pthread_cond_wait(&mt->done_cond, &mt->lock);
+	}
+	for (i = 0; i < mt->n_slots; ++i) mt->slots[i].state = MT_EMPTY;
+	mt->head = mt->n_used = mt->n_queued = 0;
+	mt->is_eof = 0;
+	pthread_mutex_unlock(&mt->lock);
+}
+
+static void mt_destroy(BGZF *fp)
+{
+	mt_t *mt = (mt_t*)fp->mt;
+	int i;
+	if (mt == 0) return;
+	pthread_mutex_lock(&mt->lock);
+	mt->stop = 1;
+	pthread_cond_broadcast(&mt->work_cond);
+	pthread_mutex_unlock(&mt->lock);
+	for (i = 0; i < mt->n_threads; ++i) pthread_join(mt->threads[i], 0);
+	for (i = 0; i < mt->n_slots; ++i) {
+		free(mt->slots[i].compressed_block);
+		free(mt->slots[i].uncompressed_block);
+	}
+	pthread_cond_destroy(&mt->work_cond);
+	pthread_cond_destroy(&mt->done_cond);
+	pthread_mutex_destroy(&mt->lock);
+	free(mt->slots);
+	free(mt->threads);
+	free(mt);
+	fp->mt = 0;
+}
+
+int bgzf_set_threads(BGZF *fp, int n_threads)
+{
+	mt_t *mt;
+	int i;
+	if (fp == 0 || fp->open_mode != 'r' || fp->mt || n_threads < 2) return -1;
+	mt = calloc(1, sizeof(mt_t));
+	mt->n_slots = n_threads * MT_SLOTS_PER_THREAD;
+	mt->slots = calloc(mt->n_slots, sizeof(mt_slot_t));
+	for (i = 0; i < mt->n_slots; ++i) {
+		mt->slots[i].compressed_block = malloc(MAX_BLOCK_SIZE);
+		mt->slots[i].uncompressed_block = malloc(MAX_BLOCK_SIZE);
+	}
+	mt->threads = calloc(n_threads, sizeof(pthread_t));
+	pthread_mutex_init(&mt->lock, 0);
+	pthread_cond_init(&mt->work_cond, 0);
+	pthread_cond_init(&mt->done_cond, 0);
+	mt->block_end = raw_tell(fp); // the end of the block loaded so far, if any
+	fp->mt = mt;
+	for (i = 0; i < n_threads; ++i) {
+		if (pthread_create(&mt->threads[i], 0, mt_worker, mt) != 0) break;
+		++mt->n_threads;
+	}
+	if (mt->n_threads == 0) {
+		mt_destroy(fp);
+		return -1;
+	}
+	return 0;
+}
+
+int64_t bgzf_next_block_address(BGZF *fp)
+{
+	return fp->mt? ((mt_t*)fp->mt)->block_end : raw_tell(fp);
+}
+
+int
+bgzf_read_block(BGZF* fp)
+{
+	int count, size;
+	const char* error = NULL;
+	int64_t block_address;
+	if (fp->mt) return mt_read_block(fp);
+	block_address = raw_tell(fp);
+	if (load_block_from_cache(fp, block_address)) return 0;
+	size = read_raw_block(fp, fp->compressed_block, &error);
+	if (size < 0) {
+		report_error(fp, error);
+		return -1;
+	}
+	if (size == 0) {
+		fp->block_length = 0;
+		return 0;
+	}
+    count = inflate_block(fp, size);
     if (count < 0) return -1;
     if (fp->block_length != 0) {
         // Do not reset offset if this read follows a seek.
@@ -520,8 +765,12 @@ bgzf_read_block(BGZF* fp)
     return 0;
 }
 
-int
-bgzf_read(BGZF* fp, void* data, int length)
+/*
+ * Shared by bgzf_read and bgzf_skip: a NULL output only advances the
+ * position indicator.
+ */
+static int
+read_or_skip(BGZF* fp, void* data, int length)
 {
     if (length <= 0) {
         return 0;
@@ -547,23 +796,34 @@ bgzf_read(BGZF* fp, void* data, int length)
         }
         copy_length = bgzf_min(length-bytes_read, available);
         buffer = fp->uncompressed_block;
-        memcpy(output, buffer + fp->block_offset, copy_length);
+        if (output != NULL) {
+            memcpy(output, buffer + fp->block_offset, copy_length);
+            output += copy_length;
+        }
         fp->block_offset += copy_length;
-        output += copy_length;
         bytes_read += copy_length;
     }
     if (fp->block_offset == fp->block_length) {
-#ifdef _USE_KNETFILE
-        fp->block_address = knet_tell(fp->x.fpr);
-#else
-        fp->block_address = ftello(fp->file);
-#endif
+        fp->block_address = bgzf_next_block_address(fp);
         fp->block_offset = 0;
         fp->block_length = 0;
     }
     return bytes_read;
 }
 
+int
+bgzf_read(BGZF* fp, void* data, int length)
+{
+    if (data == NULL) return -1;
+    return read_or_skip(fp, data, length);
+}
+
+int
+bgzf_skip(BGZF* fp, int length)
+{
+    return read_or_skip(fp, NULL, length);
+}
+
 int bgzf_flush(BGZF* fp)
 {
     while (fp->block_offset > 0) {
@@ -653,6 +913,7 @@ int bgzf_close(BGZF* fp)
         if (fclose(fp->file) != 0) return -1;
 #endif
     }
+	if (fp->open_mode == 'r') mt_destroy(fp);
     free(fp->uncompressed_block);
     free(fp->compressed_block);
 	free_cache(fp);
@@ -699,6 +960,7 @@ int64_t bgzf_seek(BGZF* fp, int64_t pos, int where)
     }
     block_offset = pos & 0xFFFF;
     block_address = (pos >> 16) & 0xFFFFFFFFFFFFLL;
+	if (fp->mt) mt_reset(fp);
 #ifdef _USE_KNETFILE
     if (knet_seek(fp->x.fpr, block_address, SEEK_SET) != 0) {
 #else
@@ -55,6 +55,7 @@ typedef struct {
 	int cache_size;
     const char* error;
 	void *cache; // a pointer to a hash table
+	void *mt; // read-ahead workers, see bgzf_set_threads()
 } BGZF;
 
 #ifdef __cplusplus
@@ -91,6 +92,13 @@ int bgzf_close(BGZF* fp);
  */
 int bgzf_read(BGZF* fp, void* data, int length);
 
+/*
+ * Move the position indicator forward by length bytes without copying
+ * the uncompressed data out. Returns the number of bytes skipped, which
+ * is smaller than length at the end of file. Returns -1 on error.
+ */
+int bgzf_skip(BGZF* fp, int length);
+
 /*
  * Write length bytes from data to the file.
  * Returns the number of bytes written.
@@ -124,6 +132,20 @@ int64_t bgzf_seek(BGZF* fp, int64_t pos, int where);
  */
 void bgzf_set_cache_size(BGZF *fp, int cache_size);
 
+/*
+ * Inflate the blocks on n_threads worker threads while reading ahead.
+ * Only for files opened for reading; bgzf_read, bgzf_seek and bgzf_tell
+ * behave exactly as in the single-threaded mode. The block cache is not
+ * used afterwards.
+ * Returns zero on success, -1 on error (the file stays single-threaded).
+ */
+int bgzf_set_threads(BGZF *fp, int n_threads);
+
+/*
+ * File offset of the block following the one currently loaded.
+ */
+int64_t bgzf_next_block_address(BGZF *fp);
+
 int bgzf_check_EOF(BGZF *fp);
 int bgzf_read_block(BGZF* fp);
 int bgzf_flush(BGZF* fp);
@@ -143,11 +165,7 @@ static inline int bgzf_getc(BGZF *fp)
 	}
 	c = ((unsigned char*)fp->uncompressed_block)[fp->block_offset++];
     if (fp->block_offset == fp->block_length) {
-#ifdef _USE_KNETFILE
-        fp->block_address = knet_tell(fp->x.fpr);
-#else
-        fp->block_address = ftello(fp->file);
-#endif
+        fp->block_address = bgzf_next_block_address(fp);
         fp->block_offset = 0;
         fp->block_length = 0;
     }
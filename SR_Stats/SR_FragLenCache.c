@@ -0,0 +1,143 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_FragLenCache.c
+ *
+ *    Description:  sidecar cache of the fragment length histograms of a bam file
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:49:31 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "md5.h"
+#include "SR_Error.h"
+#include "SR_FragLenCache.h"
+
+// the first bytes of a cache file. bump the version when the layout changes
+static const char SR_FragLenCacheMagic[8] = {'S', 'R', 'F', 'L', 'H', 'C', '0', '1'};
+
+
+//===================
+// Static functions
+//===================
+
+static char* SR_FragLenCacheFileName(const char* bamFileName, const char* suffix)
+{
+    size_t nameLen = strlen(bamFileName) + strlen(SR_FRAG_LEN_CACHE_SUFFIX) + strlen(suffix) + 1;
+
+    char* cacheFileName = (char*) malloc(nameLen);
+    if (cacheFileName == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the name of the fragment length cache file.\n");
+
+    sprintf(cacheFileName, "%s%s%s", bamFileName, SR_FRAG_LEN_CACHE_SUFFIX, suffix);
+
+    return cacheFileName;
+}
+
+
+//======================
+// Interface functions
+//======================
+
+SR_Status SR_FragLenCacheSetKey(SR_FragLenCacheKey* pKey, const char* bamFileName, const SR_BamHeader* pBamHeader,
+                                uint32_t binLen, uint8_t minMQ, double sampleTol, uint32_t numHists)
+{
+    // the padding bytes are compared as well
+    memset(pKey, 0, sizeof(SR_FragLenCacheKey));
+
+    struct stat fileStat;
+    if (stat(bamFileName, &fileStat) != 0)
+        return SR_ERR;
+
+    pKey->fileSize = fileStat.st_size;
+    pKey->mtime = fileStat.st_mtime;
+
+    const bam_header_t* pHeader = pBamHeader->pOrigHeader;
+
+    MD5_CTX md5Context;
+    MD5Init(&md5Context);
+    MD5Update(&md5Context, (unsigned char*) pHeader->text, pHeader->l_text);
+    for (int i = 0; i != pHeader->n_targets; ++i)
+    {
+        MD5Update(&md5Context, (unsigned char*) pHeader->target_name[i], strlen(pHeader->target_name[i]));
+        MD5Update(&md5Context, (unsigned char*) (pHeader->target_len + i), sizeof(uint32_t));
+    }
+
+    MD5Final(pKey->headerMD5, &md5Context);
+
+    pKey->binLen = binLen;
+    pKey->minMQ = minMQ;
+    pKey->numHists = numHists;
+    pKey->sampleTol = sampleTol;
+
+    return SR_OK;
+}
+
+SR_Status SR_FragLenCacheLoad(SR_FragLenHistArray* pHistArray, const SR_FragLenCacheKey* pKey, const char* bamFileName)
+{
+    char* cacheFileName = SR_FragLenCacheFileName(bamFileName, "");
+    FILE* cacheInput = fopen(cacheFileName, "rb");
+    free(cacheFileName);
+
+    if (cacheInput == NULL)
+        return SR_ERR;
+
+    char magic[sizeof(SR_FragLenCacheMagic)];
+    SR_FragLenCacheKey cachedKey;
+
+    SR_Status status = SR_ERR;
+    if (fread(magic, sizeof(magic), 1, cacheInput) == 1
+        && memcmp(magic, SR_FragLenCacheMagic, sizeof(magic)) == 0
+        && fread(&cachedKey, sizeof(SR_FragLenCacheKey), 1, cacheInput) == 1
+        && memcmp(&cachedKey, pKey, sizeof(SR_FragLenCacheKey)) == 0
+        && pKey->numHists == pHistArray->size)
+    {
+        status = SR_FragLenHistArrayLoad(pHistArray, cacheInput);
+    }
+
+    fclose(cacheInput);
+
+    return status;
+}
+
+void SR_FragLenCacheSave(const SR_FragLenHistArray* pHistArray, const SR_FragLenCacheKey* pKey, const char* bamFileName)
+{
+    char* cacheFileName = SR_FragLenCacheFileName(bamFileName, "");
+    char* tmpFileName = SR_FragLenCacheFileName(bamFileName, ".tmp");
+
+    FILE* cacheOutput = fopen(tmpFileName, "wb");
+    if (cacheOutput == NULL)
+    {
+        SR_ErrMsg("WARNING: Cannot create the fragment length cache file: %s\n", cacheFileName);
+    }
+    else
+    {
+        SR_Bool isWritten = (fwrite(SR_FragLenCacheMagic, sizeof(SR_FragLenCacheMagic), 1, cacheOutput) == 1
+                             && fwrite(pKey, sizeof(SR_FragLenCacheKey), 1, cacheOutput) == 1
+                             && SR_FragLenHistArrayDump(pHistArray, cacheOutput) == SR_OK);
+
+        if (fclose(cacheOutput) != 0)
+            isWritten = FALSE;
+
+        if (!isWritten || rename(tmpFileName, cacheFileName) != 0)
+        {
+            SR_ErrMsg("WARNING: Cannot write the fragment length cache file: %s\n", cacheFileName);
+            remove(tmpFileName);
+        }
+    }
+
+    free(cacheFileName);
+    free(tmpFileName);
+}
@@ -0,0 +1,114 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_FragLenCache.h
+ *
+ *    Description:  sidecar cache of the fragment length histograms of a bam file
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 07:49:31 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SR_FRAGLENCACHE_H
+#define  SR_FRAGLENCACHE_H
+
+#include <stdint.h>
+
+#include "SR_Types.h"
+#include "SR_BamHeader.h"
+#include "SR_FragLenHist.h"
+
+//===============================
+// Type and constant definition
+//===============================
+
+// the cache file sits next to the bam file with this suffix
+#define SR_FRAG_LEN_CACHE_SUFFIX ".flh"
+
+// identity of a bam file and of the settings its histograms were built with.
+// a cache file is only used if its key matches byte by byte
+typedef struct SR_FragLenCacheKey
+{
+    uint64_t fileSize;            // size of the bam file
+
+    int64_t mtime;                // last modification time of the bam file
+
+    unsigned char headerMD5[16];  // md5 digest of the bam header
+
+    uint32_t binLen;              // bin length of the first pass
+
+    uint32_t minMQ;               // minimum mapping quality of a normal pair
+
+    uint32_t numHists;            // number of histograms (new read groups) in the bam file
+
+    double sampleTol;             // tolerance of the sampling of the first pass (0 for a full scan)
+
+}SR_FragLenCacheKey;
+
+
+//======================
+// Interface functions
+//======================
+
+//==============================================================
+// function:
+//      build the cache key of a bam file
+//
+// args:
+//      1. pKey       : a pointer to a cache key
+//      2. bamFileName: name of the bam file
+//      3. pBamHeader : header of the bam file
+//      4. binLen     : bin length of the first pass
+//      5. minMQ      : minimum mapping quality of a normal pair
+//      6. sampleTol  : tolerance of the sampling of the first pass
+//      7. numHists   : number of histograms of the bam file
+//
+// return:
+//      SR_OK if the key is built; SR_ERR if the bam file cannot
+//      be found on the disk
+//==============================================================
+SR_Status SR_FragLenCacheSetKey(SR_FragLenCacheKey* pKey, const char* bamFileName, const SR_BamHeader* pBamHeader,
+                                uint32_t binLen, uint8_t minMQ, double sampleTol, uint32_t numHists);
+
+//==============================================================
+// function:
+//      load the histogram counts of a bam file from its cache
+//
+// args:
+//      1. pHistArray : an initialized histogram array
+//      2. pKey       : cache key of the bam file
+//      3. bamFileName: name of the bam file
+//
+// return:
+//      SR_OK if the cache matches the key and is loaded, the
+//      histograms should then be finalized as if they were built
+//      from the bam file; otherwise SR_ERR and the histogram
+//      array is left empty
+//==============================================================
+SR_Status SR_FragLenCacheLoad(SR_FragLenHistArray* pHistArray, const SR_FragLenCacheKey* pKey, const char* bamFileName);
+
+//==============================================================
+// function:
+//      save the finalized histograms of a bam file into its
+//      cache
+//
+// args:
+//      1. pHistArray : the finalized histogram array
+//      2. pKey       : cache key of the bam file
+//      3. bamFileName: name of the bam file
+//
+// discussion:
+//      the cache is written into a temporary file and renamed,
+//      so a crashed run never leaves a broken cache behind. a
+//      cache that cannot be written only raises a warning
+//==============================================================
+void SR_FragLenCacheSave(const SR_FragLenHistArray* pHistArray, const SR_FragLenCacheKey* pKey, const char* bamFileName);
+
+#endif  /*SR_FRAGLENCACHE_H*/
@@ -43,11 +43,37 @@ static inline int CompareFragLenBin(const void* a, const void* b)
         return 0;
 }
 
-static void SR_FragLenHistToMature(SR_FragLenHist* pHist)
+// count a fragment length into the dense array of a histogram or its overflow bucket
+static inline void SR_FragLenHistAdd(SR_FragLenHist* pHist, uint32_t maxFragLen, uint32_t fragLen, uint32_t count)
 {
-    khash_t(fragLen)* pRawHist = pHist->rawHist;
+    if (fragLen < maxFragLen)
+    {
+        pHist->counts[fragLen] += count;
+        return;
+    }
+
+    int ret = 0;
+    khiter_t khIter = kh_put(fragLen, pHist->rawHist, fragLen, &ret);
+
+    if (ret == 0)
+        kh_value((khash_t(fragLen)*) pHist->rawHist, khIter) += count;
+    else
+        kh_value((khash_t(fragLen)*) pHist->rawHist, khIter) = count;
+}
+
+// fill the sorted fragment length array and the frequency array of a histogram with the counts of another one
+static void SR_FragLenHistSort(SR_FragLenHist* pHist, const SR_FragLenHist* pSrcHist, uint32_t maxFragLen)
+{
+    const khash_t(fragLen)* pRawHist = pSrcHist->rawHist;
+
+    uint32_t numDense = 0;
+    for (uint32_t i = 0; i != maxFragLen; ++i)
+    {
+        if (pSrcHist->counts[i] != 0)
+            ++numDense;
+    }
 
-    pHist->size = kh_size(pRawHist);
+    pHist->size = numDense + kh_size(pRawHist);
 
     if (pHist->size > pHist->capacity)
     {
@@ -65,7 +91,19 @@ static void SR_FragLenHistToMature(SR_FragLenHist* pHist)
             SR_ErrQuit("ERROR: Not enough memory for the storage of the frequency array in the fragment length histogram object.\n");
     }
 
+    // the dense counts are already in order
     unsigned int i = 0;
+    for (uint32_t fragLen = 0; fragLen != maxFragLen; ++fragLen)
+    {
+        if (pSrcHist->counts[fragLen] != 0)
+        {
+            pHist->fragLen[i] = fragLen;
+            pHist->freq[i] = pSrcHist->counts[fragLen];
+            ++i;
+        }
+    }
+
+    // only the few fragment lengths in the overflow bucket have to be sorted
     for (khiter_t khIter = kh_begin(pRawHist); khIter != kh_end(pRawHist); ++khIter)
     {
         if (kh_exist(pRawHist, khIter))
@@ -75,23 +113,33 @@ static void SR_FragLenHistToMature(SR_FragLenHist* pHist)
         }
     }
 
-    qsort(pHist->fragLen, pHist->size, sizeof(uint32_t), CompareFragLenBin);
+    qsort(pHist->fragLen + numDense, pHist->size - numDense, sizeof(uint32_t), CompareFragLenBin);
+
+    for (unsigned int j = numDense; j != pHist->size; ++j)
+    {
+        khiter_t khIter = kh_get(fragLen, pRawHist, pHist->fragLen[j]);
+        if (khIter == kh_end(pRawHist))
+            SR_ErrQuit("ERROR: Cannot find the fragment length frequency from the hash table.\n");
+
+        pHist->freq[j] = kh_value(pRawHist, khIter);
+    }
+}
+
+static void SR_FragLenHistToMature(SR_FragLenHist* pHist, uint32_t maxFragLen)
+{
+    khash_t(fragLen)* pRawHist = pHist->rawHist;
+
+    SR_FragLenHistSort(pHist, pHist, maxFragLen);
 
     double cumFreq = 0.0;
     double totalFragLen = 0.0;
     uint64_t totalFreq = pHist->modeCount[0];
     double cdf = 0;
-    uint32_t fragLenQual = 0;
+    int fragLenQual = 0;
 
     SR_Bool foundMedian = FALSE;
     for (unsigned int j = 0; j != pHist->size; ++j)
     {
-        khiter_t khIter = kh_get(fragLen, pRawHist, pHist->fragLen[j]);
-        if (khIter == kh_end(pRawHist))
-            SR_ErrQuit("ERROR: Cannot find the fragment length frequency from the hash table.\n");
-
-        pHist->freq[j] = kh_value(pRawHist, khIter);
-
         totalFragLen += pHist->fragLen[j] * pHist->freq[j];
         cumFreq += pHist->freq[j];
         cdf = cumFreq / totalFreq;
@@ -104,8 +152,20 @@ static void SR_FragLenHistToMature(SR_FragLenHist* pHist)
 
         cdf = cdf > 0.5 ? 1.0 - cdf : cdf;
 
-        fragLenQual = DoubleRoundToInt(-10.0 * log10(cdf));
-        kh_value(pRawHist, khIter) = fragLenQual;
+        // the quality of the longest fragment length has no bound, it is capped below the invalid value
+        fragLenQual = (cdf > 0.0 ? DoubleRoundToInt(-10.0 * log10(cdf)) : INVALID_FRAG_LEN_QUAL - 1);
+        if (fragLenQual >= INVALID_FRAG_LEN_QUAL)
+            fragLenQual = INVALID_FRAG_LEN_QUAL - 1;
+
+        if (pHist->fragLen[j] < maxFragLen)
+        {
+            pHist->quals[pHist->fragLen[j]] = fragLenQual;
+        }
+        else
+        {
+            khiter_t khIter = kh_get(fragLen, pRawHist, pHist->fragLen[j]);
+            kh_value(pRawHist, khIter) = fragLenQual;
+        }
     }
 
     pHist->mean = totalFragLen / totalFreq;
@@ -120,11 +180,13 @@ static void SR_FragLenHistToMature(SR_FragLenHist* pHist)
         pHist->stdev = sqrt(pHist->stdev / (double) (totalFreq - 1));
 }
 
-SR_FragLenHistArray* SR_FragLenHistArrayAlloc(unsigned int capacity)
+SR_FragLenHistArray* SR_FragLenHistArrayAlloc(unsigned int capacity, uint32_t maxFragLen)
 {
     SR_FragLenHistArray* pHistArray = NULL;
     SR_ARRAY_ALLOC(pHistArray, capacity, SR_FragLenHistArray, SR_FragLenHist);
 
+    pHistArray->maxFragLen = (maxFragLen != 0 ? maxFragLen : SR_DEFAULT_HIST_FRAG_LEN);
+
     return pHistArray;
 }
 
@@ -134,6 +196,8 @@ void SR_FragLenHistArrayFree(SR_FragLenHistArray* pHistArray)
     {
         for (unsigned int i = 0; i != pHistArray->capacity; ++i)
         {
+            free(pHistArray->data[i].counts);
+            free(pHistArray->data[i].quals);
             free(pHistArray->data[i].fragLen);
             free(pHistArray->data[i].freq);
 
@@ -156,6 +220,9 @@ void SR_FragLenHistArrayClear(SR_FragLenHistArray* pHistArray)
         pHistArray->data[i].modeCount[0] = 0;
         pHistArray->data[i].modeCount[1] = 0;
 
+        memset(pHistArray->data[i].counts, 0, pHistArray->maxFragLen * sizeof(uint32_t));
+        memset(pHistArray->data[i].quals, INVALID_FRAG_LEN_QUAL, pHistArray->maxFragLen);
+
         kh_clear(fragLen, pHistArray->data[i].rawHist);
     }
 }
@@ -166,16 +233,29 @@ void SR_FragLenHistArrayInit(SR_FragLenHistArray* pHistArray, unsigned int newSi
 
     if (newSize > pHistArray->capacity)
     {
+        unsigned int oldCapacity = pHistArray->capacity;
+
         SR_ARRAY_RESIZE(pHistArray, newSize * 2, SR_FragLenHist);
-        memset(pHistArray->data + pHistArray->size, 0, (newSize * 2 - pHistArray->size) * sizeof(SR_FragLenHist));
+        memset(pHistArray->data + oldCapacity, 0, (newSize * 2 - oldCapacity) * sizeof(SR_FragLenHist));
     }
 
     for (unsigned int i = 0; i != newSize; ++i)
     {
-        if (pHistArray->data[i].rawHist == NULL)
+        SR_FragLenHist* pHist = pHistArray->data + i;
+        if (pHist->counts == NULL)
         {
-            pHistArray->data[i].rawHist = kh_init(fragLen);
-            kh_resize(fragLen, pHistArray->data[i].rawHist, DEFAULT_NUM_HIST_ELMNT);
+            pHist->counts = (uint32_t*) calloc(pHistArray->maxFragLen, sizeof(uint32_t));
+            pHist->quals = (uint8_t*) malloc(pHistArray->maxFragLen);
+            if (pHist->counts == NULL || pHist->quals == NULL)
+                SR_ErrQuit("ERROR: Not enough memory for the storage of the dense counts in the fragment length histogram object.\n");
+
+            memset(pHist->quals, INVALID_FRAG_LEN_QUAL, pHistArray->maxFragLen);
+        }
+
+        if (pHist->rawHist == NULL)
+        {
+            pHist->rawHist = kh_init(fragLen);
+            kh_resize(fragLen, pHist->rawHist, DEFAULT_NUM_HIST_ELMNT);
         }
     }
 
@@ -197,27 +277,8 @@ SR_Status SR_FragLenHistArrayUpdate(SR_FragLenHistArray* pHistArray, unsigned in
         return SR_OK;
     }
 
-    // because we can have up to 2 different pair mode sets (4 differen pair modes)
-    // we should choose which histogram we should update
-    // the first one (with index 0 or 1) or the second one(2, 3)
-    khash_t(fragLen)* pCurrHash = pCurrHist->rawHist;
-
-    if (pCurrHash == NULL)
-    {
-        pCurrHash = kh_init(fragLen);
-        kh_resize(fragLen, pCurrHash, 20);
-    }
-
-    int ret = 0;
-    khiter_t khIter = kh_put(fragLen, pCurrHash, fragLen, &ret);
-
-    if (ret == 0)
-        kh_value(pCurrHash, khIter) += 1;
-    else
-        kh_value(pCurrHash, khIter) = 1;
-
+    SR_FragLenHistAdd(pCurrHist, pHistArray->maxFragLen, fragLen, 1);
     ++(pCurrHist->modeCount[0]);
-    pCurrHist->rawHist = pCurrHash;
 
     return SR_OK;
 }
@@ -229,6 +290,9 @@ int SR_FragLenHistArrayGetFragLenQual(const SR_FragLenHistArray* pHistArray, uns
 
     SR_FragLenHist* pCurrHist = pHistArray->data + (pHistArray->size - backHistIndex);
 
+    if (fragLen < pHistArray->maxFragLen)
+        return (pCurrHist->quals[fragLen] != INVALID_FRAG_LEN_QUAL ? pCurrHist->quals[fragLen] : -1);
+
     khash_t(fragLen)* pCurrHash = pCurrHist->rawHist;
     khiter_t khIter = kh_get(fragLen, pCurrHash, fragLen);
 
@@ -239,10 +303,35 @@ int SR_FragLenHistArrayGetFragLenQual(const SR_FragLenHistArray* pHistArray, uns
     return fragLenQual;
 }
 
+void SR_FragLenHistArrayMerge(SR_FragLenHistArray* pHistArray, const SR_FragLenHistArray* pShardArray)
+{
+    if (pShardArray->size != pHistArray->size || pShardArray->maxFragLen != pHistArray->maxFragLen)
+        SR_ErrQuit("ERROR: The fragment length histogram shard does not match the histogram array.\n");
+
+    for (unsigned int i = 0; i != pHistArray->size; ++i)
+    {
+        SR_FragLenHist* pHist = pHistArray->data + i;
+        const SR_FragLenHist* pShardHist = pShardArray->data + i;
+
+        pHist->modeCount[0] += pShardHist->modeCount[0];
+        pHist->modeCount[1] += pShardHist->modeCount[1];
+
+        for (uint32_t fragLen = 0; fragLen != pHistArray->maxFragLen; ++fragLen)
+            pHist->counts[fragLen] += pShardHist->counts[fragLen];
+
+        const khash_t(fragLen)* pRawHist = pShardHist->rawHist;
+        for (khiter_t khIter = kh_begin(pRawHist); khIter != kh_end(pRawHist); ++khIter)
+        {
+            if (kh_exist(pRawHist, khIter))
+                SR_FragLenHistAdd(pHist, pHistArray->maxFragLen, kh_key(pRawHist, khIter), kh_value(pRawHist, khIter));
+        }
+    }
+}
+
 void SR_FragLenHistArrayFinalize(SR_FragLenHistArray* pHistArray)
 {
     for (unsigned int i = 0; i != pHistArray->size; ++i)
-        SR_FragLenHistToMature(&(pHistArray->data[i]));
+        SR_FragLenHistToMature(&(pHistArray->data[i]), pHistArray->maxFragLen);
 }
 
 void SR_FragLenHistArrayWrite(const SR_FragLenHistArray* pHistArray, FILE* output)
@@ -256,3 +345,108 @@ void SR_FragLenHistArrayWrite(const SR_FragLenHistArray* pHistArray, FILE* outpu
 
     fflush(output);
 }
+
+void SR_FragLenHistArraySnapshot(SR_FragLenHist* pSnapshot, const SR_FragLenHistArray* pHistArray, unsigned int histIndex)
+{
+    const SR_FragLenHist* pHist = pHistArray->data + histIndex;
+
+    SR_FragLenHistSort(pSnapshot, pHist, pHistArray->maxFragLen);
+
+    pSnapshot->modeCount[0] = pHist->modeCount[0];
+    pSnapshot->modeCount[1] = pHist->modeCount[1];
+}
+
+void SR_FragLenHistGetCutoffs(int32_t* pFragLenLow, int32_t* pFragLenHigh, const SR_FragLenHist* pHist, double cutoff, double trimRate)
+{
+    double oneSideFlow = trimRate / 2.0 * pHist->modeCount[0];
+    double total = pHist->modeCount[0] * (1.0 - trimRate);
+
+    double cumFreq = 0.0;
+    double oneSideCutoff = cutoff / 2;
+    for (unsigned int i = 0; i != pHist->size; ++i)
+    {
+        cumFreq += pHist->freq[i];
+        if (((cumFreq - oneSideFlow) / total) > oneSideCutoff)
+        {
+            *pFragLenLow = pHist->fragLen[i];
+            break;
+        }
+    }
+
+    cumFreq = 0.0;
+    for (int i = pHist->size - 1; i != -1; --i)
+    {
+        cumFreq += pHist->freq[i];
+        if (((cumFreq - oneSideFlow) / total) > oneSideCutoff)
+        {
+            *pFragLenHigh = pHist->fragLen[i];
+            break;
+        }
+    }
+}
+
+SR_Status SR_FragLenHistArrayDump(const SR_FragLenHistArray* pHistArray, FILE* output)
+{
+    for (unsigned int i = 0; i != pHistArray->size; ++i)
+    {
+        const SR_FragLenHist* pHist = pHistArray->data + i;
+
+        if (fwrite(pHist->modeCount, sizeof(uint64_t), 2, output) != 2
+            || fwrite(&(pHist->size), sizeof(uint32_t), 1, output) != 1
+            || fwrite(pHist->fragLen, sizeof(uint32_t), pHist->size, output) != pHist->size
+            || fwrite(pHist->freq, sizeof(uint32_t), pHist->size, output) != pHist->size)
+        {
+            return SR_ERR;
+        }
+    }
+
+    return SR_OK;
+}
+
+SR_Status SR_FragLenHistArrayLoad(SR_FragLenHistArray* pHistArray, FILE* input)
+{
+    uint32_t* pBuff = NULL;
+    uint32_t buffCap = 0;
+
+    SR_Status status = SR_OK;
+    for (unsigned int i = 0; i != pHistArray->size && status == SR_OK; ++i)
+    {
+        SR_FragLenHist* pHist = pHistArray->data + i;
+        uint32_t numFragLen = 0;
+
+        if (fread(pHist->modeCount, sizeof(uint64_t), 2, input) != 2
+            || fread(&numFragLen, sizeof(uint32_t), 1, input) != 1)
+        {
+            status = SR_ERR;
+            break;
+        }
+
+        if (numFragLen > buffCap)
+        {
+            buffCap = 2 * numFragLen;
+            free(pBuff);
+
+            pBuff = (uint32_t*) malloc(2 * buffCap * sizeof(uint32_t));
+            if (pBuff == NULL)
+                SR_ErrQuit("ERROR: Not enough memory for the storage of the cached fragment length histogram.\n");
+        }
+
+        // the fragment lengths are followed by their frequencies
+        if (fread(pBuff, sizeof(uint32_t), 2 * numFragLen, input) != 2 * numFragLen)
+        {
+            status = SR_ERR;
+            break;
+        }
+
+        for (unsigned int j = 0; j != numFragLen; ++j)
+            SR_FragLenHistAdd(pHist, pHistArray->maxFragLen, pBuff[j], pBuff[numFragLen + j]);
+    }
+
+    free(pBuff);
+
+    // leave nothing half loaded behind
+    if (status != SR_OK)
+        SR_FragLenHistArrayClear(pHistArray);
+
+    return status;
+}
@@ -25,10 +25,17 @@
 
 #define INVALID_FRAG_LEN_QUAL 255
 
+// default length of the dense count arrays of the histograms
+#define SR_DEFAULT_HIST_FRAG_LEN 16384
+
 // the object used to hold the fragment length histogram of a given read group
 typedef struct SR_FragLenHist
 {
-    void* rawHist;                  // raw fragment length histogram. this is a hash table for histogram building
+    uint32_t* counts;               // dense counts of the fragment lengths shorter than the maximum of the histogram array
+
+    uint8_t* quals;                 // fragment length quality of each fragment length in the dense array (INVALID_FRAG_LEN_QUAL if it is never seen)
+
+    void* rawHist;                  // overflow bucket with the fragment lengths beyond the dense array. this is a hash table
 
     uint32_t* fragLen;              // array of the fragment length
 
@@ -56,9 +63,11 @@ typedef struct SR_FragLenHistArray
 
     uint32_t capacity;
 
+    uint32_t maxFragLen;            // length of the dense arrays of the histograms
+
 }SR_FragLenHistArray;
 
-SR_FragLenHistArray* SR_FragLenHistArrayAlloc(unsigned int capacity);
+SR_FragLenHistArray* SR_FragLenHistArrayAlloc(unsigned int capacity, uint32_t maxFragLen);
 
 void SR_FragLenHistArrayFree(SR_FragLenHistArray* pHistArray);
 
@@ -70,8 +79,28 @@ SR_Status SR_FragLenHistArrayUpdate(SR_FragLenHistArray* pHistArray, unsigned in
 
 int SR_FragLenHistArrayGetFragLenQual(const SR_FragLenHistArray* pHistArray, unsigned int backHistIndex, uint32_t fragLen);
 
+// add the counts of a histogram shard built by another thread. the shard should be initialized to the same size
+// and have the same maximum fragment length. the counts are only added up, so the finalized histograms do
+// not depend on how the pairs are split among the shards
+void SR_FragLenHistArrayMerge(SR_FragLenHistArray* pHistArray, const SR_FragLenHistArray* pShardArray);
+
 void SR_FragLenHistArrayFinalize(SR_FragLenHistArray* pHistArray);
 
 void SR_FragLenHistArrayWrite(const SR_FragLenHistArray* pHistArray, FILE* output);
 
+// copy the counts of a histogram that is still being built into the sorted arrays of a snapshot.
+// the snapshot should be zero initialized before its first use and its sorted arrays freed afterwards
+void SR_FragLenHistArraySnapshot(SR_FragLenHist* pSnapshot, const SR_FragLenHistArray* pHistArray, unsigned int histIndex);
+
+// get the fragment length cutoffs of a finalized histogram (or a snapshot). the cutoffs are left
+// untouched if the histogram is too small to reach them
+void SR_FragLenHistGetCutoffs(int32_t* pFragLenLow, int32_t* pFragLenHigh, const SR_FragLenHist* pHist, double cutoff, double trimRate);
+
+// write the counts of the finalized histograms so that they can be loaded again
+SR_Status SR_FragLenHistArrayDump(const SR_FragLenHistArray* pHistArray, FILE* output);
+
+// load the counts written by "SR_FragLenHistArrayDump" into an initialized histogram array.
+// the histograms still have to be finalized afterwards
+SR_Status SR_FragLenHistArrayLoad(SR_FragLenHistArray* pHistArray, FILE* input);
+
 #endif  /*SR_FRAGLENHIST_H*/
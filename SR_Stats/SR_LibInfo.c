@@ -1059,31 +1059,8 @@ void SR_LibInfoTableUpdate(SR_LibInfoTable* pTable, const SR_FragLenHistArray* p
 
         pTable->pLibInfo[oldSize].fragLenMedian = pHist->median;
 
-        double oneSideFlow = pTable->trimRate / 2.0 * pHist->modeCount[0];
-        double total = pHist->modeCount[0] * (1.0 - pTable->trimRate);
-
-        double cumFreq = 0.0;
-        double oneSideCutoff = pTable->cutoff / 2;
-        for (unsigned int i = 0; i != pHist->size; ++i)
-        {
-            cumFreq += pHist->freq[i];
-            if (((cumFreq - oneSideFlow) / total) > oneSideCutoff)
-            {
-                pTable->pLibInfo[oldSize].fragLenLow = pHist->fragLen[i];
-                break;
-            }
-        }
-
-        cumFreq = 0.0;
-        for (int i = pHist->size - 1; i != -1; --i)
-        {
-            cumFreq += pHist->freq[i];
-            if (((cumFreq - oneSideFlow) / total) > oneSideCutoff)
-            {
-                pTable->pLibInfo[oldSize].fragLenHigh = pHist->fragLen[i];
-                break;
-            }
-        }
+        SR_FragLenHistGetCutoffs(&(pTable->pLibInfo[oldSize].fragLenLow), &(pTable->pLibInfo[oldSize].fragLenHigh),
+                                 pHist, pTable->cutoff, pTable->trimRate);
 
         if (pTable->pLibInfo[oldSize].fragLenHigh > pTable->fragLenMax)
             pTable->fragLenMax = pTable->pLibInfo[oldSize].fragLenHigh;
@@ -16,70 +16,85 @@
  * =====================================================================================
  */
 
-#include <math.h>
 #include <dirent.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <pthread.h>
 
 #include "khash.h"
 #include "SR_Error.h"
 #include "SR_Utilities.h"
 #include "SR_BamPairAux.h"
 #include "SR_BamInStream.h"
+#include "SR_MemPlan.h"
+#include "SR_FragLenCache.h"
+#include "SR_ReadPairFile.h"
 #include "SR_ReadPairBuild.h"
 
 #define DEFAULT_RP_INFO_CAPACITY 50
 
-#define SR_NUM_RP_FILE 6
-
 #define DEFAULT_SP_TABLE_CAPACITY 10
 
+// length of the windows read by the sampling of the first pass
+#define SR_SAMPLE_WINDOW_LEN 1000000
+
+// the cutoffs of the sampled histograms are checked after this many windows
+#define SR_SAMPLE_ROUND_SIZE 16
+
+// a sampled histogram needs this many normal pairs before its cutoffs are trusted
+#define SR_SAMPLE_MIN_PAIRS 100000
+
 static const char* SR_LibTableFileName = "lib_table.dat";
 
 static const char* SR_HistFileName = "hist.dat";
 
-static const char* SR_READ_PAIR_FILE_NAME_TEMPLATE[] = 
+KHASH_MAP_INIT_STR(name, uint32_t);
+
+// a thread scanning a set of chromosomes of a bam file through the bam index
+typedef struct SR_ReadPairShard
 {
-    "refXXX_long_pairs.dat",
+    SR_BamInStream* pBamInStream;              // bam in stream of the thread
 
-    "refXXX_short_pairs.dat",
+    SR_FilterDataRP* pFilterData;              // filter data of the thread (it has its own bam file and index to load the mates)
 
-    "refXXX_reversed_pairs.dat",
+    SR_ReadPairTable* pReadPairTable;          // read pair table of the thread
 
-    "refXXX_inverted_pairs.dat",
+    const SR_LibInfoTable* pLibTable;          // library information table (shared, read only)
 
-    "refXXX_cross_pairs.dat",
+    const SR_FragLenHistArray* pHistArray;     // fragment length histogram array (shared, read only)
 
-    "refXXX_special_pairs.dat",
-};
+    SR_FragLenHistArray* pLocalHist;           // fragment length histograms counted by the thread in the first pass
 
-enum
-{
-    SR_LONG_PAIR_FILE = 0,
+    int32_t* pNextRefID;                       // the next chromosome to be scanned (shared by all the threads)
 
-    SR_SHORT_PAIR_FILE = 1,
+    const SR_MemPlan* pMemPlan;                // bin lengths and pool sizes of the chromosomes (NULL without a memory limit)
 
-    SR_REVERSED_PAIR_FILE = 2,
+    uint8_t minMQ;                             // minimum mapping quality for a read pair
 
-    SR_INVERTED_PAIR_FILE = 3,
+}SR_ReadPairShard;
 
-    SR_CROSS_PAIR_FILE = 4,
+// everything about a read pair the read pair table needs. the single-pass build
+// writes the summaries of the pairs that may be abnormal into a temporary file
+typedef struct SR_PairSummary
+{
+    SR_PairStats pairStats;       // read group, fragment length and pair mode
 
-    SR_SPEICAL_PAIR_FILE = 5
-};
+    int32_t refID[2];             // reference IDs of the up and down mates
 
-typedef struct SR_ReadPairOutStream
-{
-    FILE* output;
+    int32_t pos[2];               // alignment positions of the up and down mates
 
-    int64_t numPairs;
+    int32_t end[2];               // alignment ends of the up and down mates
 
-}SR_ReadPairOutStream;
+    int16_t numMM[2];             // number of mismatches of the up and down mates
 
-KHASH_MAP_INIT_STR(name, uint32_t);
+    uint8_t mapQ[2];              // mapping qualities of the up and down mates
+
+    SR_Bool hasZA;                // if the ZA tag is found
+
+    SR_ZAtag zaTag;               // the ZA tag
 
-KHASH_MAP_INIT_INT(file, SR_ReadPairOutStream);
+}SR_PairSummary;
 
 // check the read pair type
 static SV_ReadPairType SR_CheckReadPairType(const SR_ZAtag* pZAtag, const SR_PairStats* pPairStats, const SR_LibInfoTable* pLibTable)
@@ -137,28 +152,30 @@ static SV_ReadPairType SR_CheckReadPairType(const SR_ZAtag* pZAtag, const SR_Pai
 }
 
 // update the local pair array
-static void SR_LocalPairArrayUpdate(SR_LocalPairArray* pLocalPairArray, const bam1_t* pUpAlgn, const bam1_t* pDownAlgn, const SR_LibInfoTable* pLibTable, 
-        const SR_FragLenHistArray* pHistArray, const SR_PairStats* pPairStats, SV_ReadPairType readPairType)
+static void SR_LocalPairArrayUpdate(SR_LocalPairArray* pLocalPairArray, const SR_PairSummary* pSummary, const SR_LibInfoTable* pLibTable, 
+        const SR_FragLenHistArray* pHistArray, SV_ReadPairType readPairType)
 {
+    const SR_PairStats* pPairStats = &(pSummary->pairStats);
+
     if (pLocalPairArray->size == pLocalPairArray->capacity)
         SR_ARRAY_RESIZE(pLocalPairArray, pLocalPairArray->capacity * 2, SR_LocalPair);
 
     SR_LocalPair* pLocalPair = pLocalPairArray->data + pLocalPairArray->size;
 
     pLocalPair->readGrpID = pPairStats->readGrpID;
-    pLocalPair->refID = pUpAlgn->core.tid;
+    pLocalPair->refID = pSummary->refID[0];
 
-    pLocalPair->upPos = pUpAlgn->core.pos;
-    pLocalPair->downPos = pDownAlgn->core.pos;
+    pLocalPair->upPos = pSummary->pos[0];
+    pLocalPair->downPos = pSummary->pos[1];
 
     pLocalPair->fragLen = pPairStats->fragLen;
-    pLocalPair->upEnd = bam_calend(&(pUpAlgn->core), bam1_cigar(pUpAlgn));
+    pLocalPair->upEnd = pSummary->end[0];
 
-    pLocalPair->upNumMM = SR_GetNumMismatchFromBam(pUpAlgn);
-    pLocalPair->downNumMM = SR_GetNumMismatchFromBam(pDownAlgn);
+    pLocalPair->upNumMM = pSummary->numMM[0];
+    pLocalPair->downNumMM = pSummary->numMM[1];
 
-    pLocalPair->upMapQ = pUpAlgn->core.qual;
-    pLocalPair->downMapQ = pDownAlgn->core.qual;
+    pLocalPair->upMapQ = pSummary->mapQ[0];
+    pLocalPair->downMapQ = pSummary->mapQ[1];
 
     pLocalPair->pairMode = pPairStats->pairMode;
     pLocalPair->readPairType = readPairType;
@@ -170,28 +187,29 @@ static void SR_LocalPairArrayUpdate(SR_LocalPairArray* pLocalPairArray, const ba
 }
 
 // update the inverted array
-static void SR_InvertedPairArrayUpdate(SR_LocalPairArray* pInvertedPairArray, const bam1_t* pUpAlgn, const bam1_t* pDownAlgn, 
-        const SR_PairStats* pPairStats, SV_ReadPairType readPairType)
+static void SR_InvertedPairArrayUpdate(SR_LocalPairArray* pInvertedPairArray, const SR_PairSummary* pSummary, SV_ReadPairType readPairType)
 {
+    const SR_PairStats* pPairStats = &(pSummary->pairStats);
+
     if (pInvertedPairArray->size == pInvertedPairArray->capacity)
         SR_ARRAY_RESIZE(pInvertedPairArray, pInvertedPairArray->capacity * 2, SR_LocalPair);
 
     SR_LocalPair* pInvertedPair = pInvertedPairArray->data + pInvertedPairArray->size;
 
     pInvertedPair->readGrpID = pPairStats->readGrpID;
-    pInvertedPair->refID = pUpAlgn->core.tid;
+    pInvertedPair->refID = pSummary->refID[0];
 
-    pInvertedPair->upPos = pUpAlgn->core.pos;
-    pInvertedPair->downPos = pDownAlgn->core.pos;
+    pInvertedPair->upPos = pSummary->pos[0];
+    pInvertedPair->downPos = pSummary->pos[1];
 
     pInvertedPair->fragLen = pPairStats->fragLen;
-    pInvertedPair->upEnd = bam_calend(&(pUpAlgn->core), bam1_cigar(pUpAlgn));
+    pInvertedPair->upEnd = pSummary->end[0];
 
-    pInvertedPair->upNumMM = SR_GetNumMismatchFromBam(pUpAlgn);
-    pInvertedPair->downNumMM = SR_GetNumMismatchFromBam(pDownAlgn);
+    pInvertedPair->upNumMM = pSummary->numMM[0];
+    pInvertedPair->downNumMM = pSummary->numMM[1];
 
-    pInvertedPair->upMapQ = pUpAlgn->core.qual;
-    pInvertedPair->downMapQ = pDownAlgn->core.qual;
+    pInvertedPair->upMapQ = pSummary->mapQ[0];
+    pInvertedPair->downMapQ = pSummary->mapQ[1];
 
     pInvertedPair->pairMode = pPairStats->pairMode;
     pInvertedPair->readPairType = readPairType;
@@ -203,8 +221,10 @@ static void SR_InvertedPairArrayUpdate(SR_LocalPairArray* pInvertedPairArray, co
 }
 
 // update the cross pair array
-static void SR_CrossPairArrayUpdate(SR_CrossPairArray* pCrossPairArray, const bam1_t* pUpAlgn, const bam1_t* pDownAlgn, const SR_PairStats*  pPairStats)
+static void SR_CrossPairArrayUpdate(SR_CrossPairArray* pCrossPairArray, const SR_PairSummary* pSummary)
 {
+    const SR_PairStats* pPairStats = &(pSummary->pairStats);
+
     if (pCrossPairArray->size == pCrossPairArray->capacity)
         SR_ARRAY_RESIZE(pCrossPairArray, pCrossPairArray->capacity * 2, SR_CrossPair);
 
@@ -212,20 +232,20 @@ static void SR_CrossPairArrayUpdate(SR_CrossPairArray* pCrossPairArray, const ba
 
     pCrossPair->readGrpID = pPairStats->readGrpID;
 
-    pCrossPair->upRefID = pUpAlgn->core.tid;
-    pCrossPair->downRefID = pDownAlgn->core.tid;
+    pCrossPair->upRefID = pSummary->refID[0];
+    pCrossPair->downRefID = pSummary->refID[1];
 
-    pCrossPair->upPos = pUpAlgn->core.pos;
-    pCrossPair->downPos = pDownAlgn->core.pos;
+    pCrossPair->upPos = pSummary->pos[0];
+    pCrossPair->downPos = pSummary->pos[1];
 
-    pCrossPair->upEnd = bam_calend(&(pUpAlgn->core), bam1_cigar(pUpAlgn));
-    pCrossPair->downEnd = bam_calend(&(pDownAlgn->core), bam1_cigar(pDownAlgn));
+    pCrossPair->upEnd = pSummary->end[0];
+    pCrossPair->downEnd = pSummary->end[1];
 
-    pCrossPair->upNumMM = SR_GetNumMismatchFromBam(pUpAlgn);
-    pCrossPair->downNumMM = SR_GetNumMismatchFromBam(pDownAlgn);
+    pCrossPair->upNumMM = pSummary->numMM[0];
+    pCrossPair->downNumMM = pSummary->numMM[1];
 
-    pCrossPair->upMapQ = pUpAlgn->core.qual;
-    pCrossPair->downMapQ = pDownAlgn->core.qual;
+    pCrossPair->upMapQ = pSummary->mapQ[0];
+    pCrossPair->downMapQ = pSummary->mapQ[1];
 
     pCrossPair->pairMode = pPairStats->pairMode;
     pCrossPair->readPairType = PT_CROSS;
@@ -236,28 +256,32 @@ static void SR_CrossPairArrayUpdate(SR_CrossPairArray* pCrossPairArray, const ba
     ++(pCrossPairArray->size);
 }
 
-// update the special pair table
-static void SR_SpecialPairTableUpdate(SR_SpecialPairTable* pSpecialPairTable, const bam1_t* pUpAlgn, const bam1_t* pDownAlgn, const SR_LibInfoTable* pLibTable, 
-        const SR_FragLenHistArray* pHistArray, const SR_PairStats* pPairStats, const SR_ZAtag* pZAtag, SV_ReadPairType readPairType)
+// get the ID of a special reference name, a new ID is assigned if the name is not in the table yet
+static int SR_SpecialPairTableGetID(SR_SpecialPairTable* pSpecialPairTable, const char* spName)
 {
     if (pSpecialPairTable->size == pSpecialPairTable->capacity)
     {
         pSpecialPairTable->capacity *= 2;
-        pSpecialPairTable->names = (char (*)[3]) realloc(pSpecialPairTable->names, sizeof(char) * pSpecialPairTable->capacity);
+        pSpecialPairTable->names = (char (*)[3]) realloc(pSpecialPairTable->names, sizeof(char) * 3 * pSpecialPairTable->capacity);
         if (pSpecialPairTable->names == NULL)
             SR_ErrQuit("ERROR: Not enough memory for the special reference names.\n");
 
         for (unsigned int i = pSpecialPairTable->size; i != pSpecialPairTable->capacity; ++i)
             pSpecialPairTable->names[i][2] = '\0';
-    }
 
-    int anchorIndex = readPairType - PT_SPECIAL3;
-    int specialIndex = anchorIndex ^ 1;
+        // the keys of the name hash point into the name array
+        int ret = 0;
+        kh_clear(name, pSpecialPairTable->nameHash);
+        for (unsigned int i = 0; i != pSpecialPairTable->size; ++i)
+        {
+            khiter_t khIter = kh_put(name, pSpecialPairTable->nameHash, pSpecialPairTable->names[i], &ret);
+            kh_value((khash_t(name)*) pSpecialPairTable->nameHash, khIter) = i;
+        }
+    }
 
-    pSpecialPairTable->names[pSpecialPairTable->size][0] = pZAtag->spRef[specialIndex][0];
-    pSpecialPairTable->names[pSpecialPairTable->size][1] = pZAtag->spRef[specialIndex][1];
+    pSpecialPairTable->names[pSpecialPairTable->size][0] = spName[0];
+    pSpecialPairTable->names[pSpecialPairTable->size][1] = spName[1];
 
-    //  get the special reference ID
     int ret = 0;
     int spRefID = 0;
     khiter_t khIter = kh_put(name, pSpecialPairTable->nameHash, pSpecialPairTable->names[pSpecialPairTable->size], &ret);
@@ -271,11 +295,26 @@ static void SR_SpecialPairTableUpdate(SR_SpecialPairTable* pSpecialPairTable, co
     else
         spRefID = kh_value((khash_t(name)*) pSpecialPairTable->nameHash, khIter);
 
-    const bam1_t* pAlgns[2] = {pUpAlgn, pDownAlgn};
+    return spRefID;
+}
+
+// update the special pair table
+static void SR_SpecialPairTableUpdate(SR_SpecialPairTable* pSpecialPairTable, const SR_PairSummary* pSummary, const SR_LibInfoTable* pLibTable, 
+        const SR_FragLenHistArray* pHistArray, SV_ReadPairType readPairType)
+{
+    const SR_PairStats* pPairStats = &(pSummary->pairStats);
+    const SR_ZAtag* pZAtag = &(pSummary->zaTag);
+
+    int anchorIndex = readPairType - PT_SPECIAL3;
+    int specialIndex = anchorIndex ^ 1;
+
+    //  get the special reference ID
+    int spRefID = SR_SpecialPairTableGetID(pSpecialPairTable, pZAtag->spRef[specialIndex]);
+
     SR_SpecialPairArray* pSpecialPairArray = NULL;
 
     // to see which special pairs array should we use
-    if (pAlgns[anchorIndex]->core.tid == pUpAlgn->core.tid)
+    if (pSummary->refID[anchorIndex] == pSummary->refID[0])
         pSpecialPairArray = &(pSpecialPairTable->array);
     else
         pSpecialPairArray = &(pSpecialPairTable->crossArray);
@@ -287,22 +326,22 @@ static void SR_SpecialPairTableUpdate(SR_SpecialPairTable* pSpecialPairTable, co
 
     pSpecialPair->readGrpID = pPairStats->readGrpID;
 
-    pSpecialPair->refID[0] = pAlgns[anchorIndex]->core.tid;
-    pSpecialPair->refID[1] = pAlgns[specialIndex]->core.tid;
+    pSpecialPair->refID[0] = pSummary->refID[anchorIndex];
+    pSpecialPair->refID[1] = pSummary->refID[specialIndex];
 
-    pSpecialPair->pos[0] = pAlgns[anchorIndex]->core.pos;
-    pSpecialPair->pos[1] = pAlgns[specialIndex]->core.pos;
+    pSpecialPair->pos[0] = pSummary->pos[anchorIndex];
+    pSpecialPair->pos[1] = pSummary->pos[specialIndex];
 
-    pSpecialPair->end[0] = bam_calend(&(pAlgns[anchorIndex]->core), bam1_cigar(pAlgns[anchorIndex]));
-    pSpecialPair->end[1] = bam_calend(&(pAlgns[specialIndex]->core), bam1_cigar(pAlgns[specialIndex]));
+    pSpecialPair->end[0] = pSummary->end[anchorIndex];
+    pSpecialPair->end[1] = pSummary->end[specialIndex];
 
     pSpecialPair->numMM[0] = pZAtag->numMM[anchorIndex];
     pSpecialPair->numMM[1] = pZAtag->numMM[specialIndex];
 
     // FIXME: the mapping quality in the ZA tag is useless for current version.
     // use the mapping quality from the alignment instead
-    pSpecialPair->bestMQ[0] = pAlgns[anchorIndex]->core.qual;
-    pSpecialPair->bestMQ[1] = pAlgns[specialIndex]->core.qual;
+    pSpecialPair->bestMQ[0] = pSummary->mapQ[anchorIndex];
+    pSpecialPair->bestMQ[1] = pSummary->mapQ[specialIndex];
 
     pSpecialPair->secMQ[0] = pZAtag->secMQ[anchorIndex];
     pSpecialPair->secMQ[1] = pZAtag->secMQ[specialIndex];
@@ -317,12 +356,130 @@ static void SR_SpecialPairTableUpdate(SR_SpecialPairTable* pSpecialPairTable, co
     else
         pSpecialPair->fragLenQual = INVALID_FRAG_LEN_QUAL;
 
-    if (pAlgns[anchorIndex]->core.tid == pUpAlgn->core.tid)
+    if (pSummary->refID[anchorIndex] == pSummary->refID[0])
         ++(pSpecialPairArray->chrCount[pSpecialPair->refID[0]]);
 
     ++(pSpecialPairArray->size);
 }
 
+// get the type of a read pair, the pairs with low mapping qualities are unknown
+static SV_ReadPairType SR_GetReadPairType(const SR_ZAtag* pZAtag, const SR_PairStats* pPairStats, uint8_t upMapQ, uint8_t downMapQ,
+        const SR_LibInfoTable* pLibTable, uint8_t minMQ)
+{
+    SV_ReadPairType readPairType = SR_CheckReadPairType(pZAtag, pPairStats, pLibTable);
+
+    // check the mapping quality for all read pairs except the special read pairs
+    if (readPairType != PT_SPECIAL5 && readPairType != PT_SPECIAL3)
+    {
+        if (upMapQ < minMQ || downMapQ < minMQ)
+            readPairType = PT_UNKNOWN;
+    }
+
+    return readPairType;
+}
+
+// summarize a read pair for the read pair table
+static void SR_PairSummaryLoad(SR_PairSummary* pSummary, const bam1_t* pUpAlgn, const bam1_t* pDownAlgn, const SR_ZAtag* pZAtag, const SR_PairStats* pPairStats)
+{
+    const bam1_t* pAlgns[2] = {pUpAlgn, pDownAlgn};
+
+    pSummary->pairStats = *pPairStats;
+
+    for (unsigned int i = 0; i != 2; ++i)
+    {
+        pSummary->refID[i] = pAlgns[i]->core.tid;
+        pSummary->pos[i] = pAlgns[i]->core.pos;
+        pSummary->end[i] = bam_calend(&(pAlgns[i]->core), bam1_cigar(pAlgns[i]));
+        pSummary->numMM[i] = SR_GetNumMismatchFromBam(pAlgns[i]);
+        pSummary->mapQ[i] = pAlgns[i]->core.qual;
+    }
+
+    if (pZAtag != NULL)
+    {
+        pSummary->hasZA = TRUE;
+        pSummary->zaTag = *pZAtag;
+    }
+    else
+    {
+        pSummary->hasZA = FALSE;
+        memset(&(pSummary->zaTag), 0, sizeof(SR_ZAtag));
+    }
+}
+
+// add a summarized read pair of a given type into the read pair table
+static void SR_ReadPairTableAddSummary(SR_ReadPairTable* pReadPairTable, const SR_PairSummary* pSummary, SV_ReadPairType readPairType,
+        const SR_LibInfoTable* pLibTable, const SR_FragLenHistArray* pHistArray)
+{
+    switch (readPairType)
+    {
+        case PT_NORMAL:
+        case PT_UNKNOWN:
+            break;
+        case PT_LONG:
+            if (pReadPairTable->pLongPairArray != NULL)
+                SR_LocalPairArrayUpdate(pReadPairTable->pLongPairArray, pSummary, pLibTable, pHistArray, readPairType);
+            break;
+        case PT_SHORT:
+            if (pReadPairTable->pShortPairArray != NULL)
+                SR_LocalPairArrayUpdate(pReadPairTable->pShortPairArray, pSummary, pLibTable, pHistArray, readPairType);
+            break;
+        case PT_REVERSED:
+            if (pReadPairTable->pReversedPairArray != NULL)
+                SR_LocalPairArrayUpdate(pReadPairTable->pReversedPairArray, pSummary, pLibTable, pHistArray, readPairType);
+            break;
+        case PT_INVERTED3:
+        case PT_INVERTED5:
+            if (pReadPairTable->pInvertedPairArray != NULL)
+                SR_InvertedPairArrayUpdate(pReadPairTable->pInvertedPairArray, pSummary, readPairType);
+            break;
+        case PT_CROSS:
+            if (pReadPairTable->pCrossPairArray != NULL)
+                SR_CrossPairArrayUpdate(pReadPairTable->pCrossPairArray, pSummary);
+            break;
+        case PT_SPECIAL3:
+        case PT_SPECIAL5:
+            if (pReadPairTable->pSpecialPairTable != NULL) 
+                SR_SpecialPairTableUpdate(pReadPairTable->pSpecialPairTable, pSummary, pLibTable, pHistArray, readPairType);
+            break;
+        default:
+            break;
+    }
+}
+
+// check if a read pair may be abnormal before the fragment length distributions are known.
+// this is a heuristic used only by the opt-in single-pass mode. a pair in normal orientation
+// that the aligner flags as proper and whose fragment is shorter than the bin length is
+// dropped, so the proper pairs that "SR_GetReadPairType" would call abnormal against the
+// final cutoffs (fragments below the low cutoff, or between the high cutoff and the bin
+// length) are lost
+static SR_Bool SR_ReadPairMayBeAbnormal(const bam1_t* pUpAlgn, const bam1_t* pDownAlgn, const SR_ZAtag* pZAtag,
+        const SR_PairStats* pPairStats, uint8_t minMQ, uint32_t bigFragLen)
+{
+    if (pZAtag != NULL)
+    {
+        // the special pairs are judged by the ZA tag only
+        if (pZAtag->spRef[0][0] != ' ' || pZAtag->spRef[1][0] != ' ')
+            return TRUE;
+
+        if (pZAtag->numMappings[0] != 1 || pZAtag->numMappings[1] != 1)
+            return FALSE;
+    }
+
+    if (pUpAlgn->core.qual < minMQ || pDownAlgn->core.qual < minMQ)
+        return FALSE;
+
+    if (pPairStats->fragLen == -1)
+        return TRUE;
+
+    if (SV_ReadPairTypeMap[0][pPairStats->pairMode] != PT_NORMAL && SV_ReadPairTypeMap[1][pPairStats->pairMode] != PT_NORMAL)
+        return TRUE;
+
+    // a normal orientation. the proper pair flag of the aligner and the bin
+    // length stand in for the fragment length cutoffs of the library
+    return ((pUpAlgn->core.flag & BAM_FPROPER_PAIR) == 0 || (pDownAlgn->core.flag & BAM_FPROPER_PAIR) == 0
+            || (uint32_t) pPairStats->fragLen >= bigFragLen);
+}
+
 static void SR_SpecialPairTableClear(SR_SpecialPairTable* pSpecialPairTable, unsigned int numChr)
 {
     pSpecialPairTable->array.size = 0;
@@ -331,6 +488,507 @@ static void SR_SpecialPairTableClear(SR_SpecialPairTable* pSpecialPairTable, uns
     pSpecialPairTable->crossArray.size = 0;
 }
 
+// update the read pair table with a read pair
+static void SR_ReadPairBuildAdd(SR_ReadPairTable* pReadPairTable, const bam1_t* pUpAlgn, const bam1_t* pDownAlgn,
+        const SR_LibInfoTable* pLibTable, const SR_FragLenHistArray* pHistArray, uint8_t minMQ)
+{
+    SR_ZAtag zaTag;
+    SR_PairStats pairStats;
+
+    SR_Status readStatus = SR_LoadPairStats(&pairStats, pUpAlgn, pLibTable);
+
+    if (readStatus == SR_OK)
+    {
+        SR_Status ZAstatus = SR_LoadZAtag(&zaTag, pUpAlgn);
+
+        if (ZAstatus == SR_OK)
+            SR_ReadPairTableUpdate(pReadPairTable, pUpAlgn, pDownAlgn, &zaTag, &pairStats, pLibTable, pHistArray, minMQ);
+        else
+            SR_ReadPairTableUpdate(pReadPairTable, pUpAlgn, pDownAlgn, NULL, &pairStats, pLibTable, pHistArray, minMQ);
+    }
+}
+
+// count a read pair of the first pass into the fragment length histograms. in the single-pass
+// mode the pairs that may be abnormal are also summarized into a temporary file
+static void SR_ReadPairBuildCount(SR_FragLenHistArray* pHistArray, FILE* pairSpill, const bam1_t* pUpAlgn, const bam1_t* pDownAlgn,
+        const SR_LibInfoTable* pLibTable, uint8_t minMQ, uint32_t bigFragLen)
+{
+    SR_PairStats pairStats;
+    unsigned int backHistIndex = 0;
+
+    // check if the incoming read pair is normal (unique-unique pair)
+    // if yes, then update the corresponding fragment length histogram.
+    // the cross pairs only show up here in the single-pass mode
+    if (pUpAlgn->core.tid == pDownAlgn->core.tid
+        && SR_IsNormalPair(&pairStats, &backHistIndex, pUpAlgn, pDownAlgn, pLibTable, minMQ))
+    {
+        SR_FragLenHistArrayUpdate(pHistArray, backHistIndex, pairStats.fragLen);
+    }
+
+    if (pairSpill == NULL || SR_LoadPairStats(&pairStats, pUpAlgn, pLibTable) != SR_OK)
+        return;
+
+    SR_ZAtag zaTag;
+    const SR_ZAtag* pZAtag = (SR_LoadZAtag(&zaTag, pUpAlgn) == SR_OK ? &zaTag : NULL);
+
+    if (SR_ReadPairMayBeAbnormal(pUpAlgn, pDownAlgn, pZAtag, &pairStats, minMQ, bigFragLen))
+    {
+        SR_PairSummary summary;
+        SR_PairSummaryLoad(&summary, pUpAlgn, pDownAlgn, pZAtag, &pairStats);
+
+        if (fwrite(&summary, sizeof(SR_PairSummary), 1, pairSpill) != 1)
+            SR_ErrSys("ERROR: Cannot write the read pair summaries into a temporary file.\n");
+    }
+}
+
+// check if the cutoffs of the sampled histograms changed less than the tolerance since the last check
+static SR_Bool SR_ReadPairBuildIsStable(int32_t (*pCutoffs)[2], SR_FragLenHist* pSnapshot, const SR_FragLenHistArray* pHistArray,
+        const SR_LibInfoTable* pLibTable, double sampleTol)
+{
+    SR_Bool isStable = TRUE;
+    for (unsigned int i = 0; i != pHistArray->size; ++i)
+    {
+        SR_FragLenHistArraySnapshot(pSnapshot, pHistArray, i);
+
+        int32_t fragLenLow = 0;
+        int32_t fragLenHigh = 0;
+        SR_FragLenHistGetCutoffs(&fragLenLow, &fragLenHigh, pSnapshot, pLibTable->cutoff, pLibTable->trimRate);
+
+        if (pSnapshot->modeCount[0] < SR_SAMPLE_MIN_PAIRS
+            || abs(fragLenLow - pCutoffs[i][0]) > sampleTol * fragLenLow
+            || abs(fragLenHigh - pCutoffs[i][1]) > sampleTol * fragLenHigh)
+        {
+            isStable = FALSE;
+        }
+
+        pCutoffs[i][0] = fragLenLow;
+        pCutoffs[i][1] = fragLenHigh;
+    }
+
+    return isStable;
+}
+
+// fill the fragment length histograms of a bam file from the windows of its chromosomes in a random order.
+// the sampling stops once the cutoffs of all the histograms are stable or all the windows are read. return
+// FALSE if the bam file has no index or too few mapped reads for every histogram to become stable, it has
+// to be scanned from the beginning then
+static SR_Bool SR_ReadPairBuildSample(SR_FragLenHistArray* pHistArray, SR_BamInStream* pBamInStream, SR_FilterDataRP* pFilterData,
+        const SR_LibInfoTable* pLibTable, const SR_MemPlan* pMemPlan, uint8_t minMQ, uint32_t binLen, double sampleTol)
+{
+    if (pBamInStream->pBamIndex == NULL)
+        return FALSE;
+
+    const SR_AnchorInfo* pAnchorInfo = pLibTable->pAnchorInfo;
+
+    // the windows of the chromosomes with mapped reads. the reference ID is kept in the high bits
+    uint64_t numWindows = 0;
+    uint64_t numAllMapped = 0;
+    for (unsigned int i = 0; i != pAnchorInfo->size; ++i)
+    {
+        uint64_t numMapped = 0;
+        uint64_t numUnmapped = 0;
+        if (pAnchorInfo->pLength[i] > 0 && bam_index_get_stat(pBamInStream->pBamIndex, i, &numMapped, &numUnmapped) == 0 && numMapped != 0)
+        {
+            numWindows += (pAnchorInfo->pLength[i] + SR_SAMPLE_WINDOW_LEN - 1) / SR_SAMPLE_WINDOW_LEN;
+            numAllMapped += numMapped;
+        }
+    }
+
+    // a small library would be read through random jumps to all its windows, a
+    // sequential scan is faster and gives the same histograms
+    if (numAllMapped < 2 * (uint64_t) SR_SAMPLE_MIN_PAIRS * pHistArray->size)
+        return FALSE;
+
+    uint64_t* pWindows = (uint64_t*) malloc((numWindows + 1) * sizeof(uint64_t));
+    int32_t (*pCutoffs)[2] = calloc(pHistArray->size + 1, sizeof(*pCutoffs));
+    if (pWindows == NULL || pCutoffs == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the sampling windows.\n");
+
+    numWindows = 0;
+    for (unsigned int i = 0; i != pAnchorInfo->size; ++i)
+    {
+        uint64_t numMapped = 0;
+        uint64_t numUnmapped = 0;
+        if (pAnchorInfo->pLength[i] <= 0 || bam_index_get_stat(pBamInStream->pBamIndex, i, &numMapped, &numUnmapped) != 0 || numMapped == 0)
+            continue;
+
+        for (int32_t pos = 0; pos < pAnchorInfo->pLength[i]; pos += SR_SAMPLE_WINDOW_LEN)
+            pWindows[numWindows++] = ((uint64_t) i << 32) | (uint32_t) pos;
+    }
+
+    // the seed is fixed so that a bam file always gives the same histograms
+    unsigned short seed[3] = {0x5352, 0x4650, 0x4c48};
+    for (uint64_t i = numWindows; i > 1; --i)
+    {
+        uint64_t j = (uint64_t) nrand48(seed) % i;
+        uint64_t window = pWindows[i - 1];
+        pWindows[i - 1] = pWindows[j];
+        pWindows[j] = window;
+    }
+
+    SR_FragLenHist snapshot;
+    memset(&snapshot, 0, sizeof(SR_FragLenHist));
+
+    SR_BamNode* pUpNode = NULL;
+    SR_BamNode* pDownNode = NULL;
+
+    const bam1_t* pUpAlgn = NULL;
+    const bam1_t* pDownAlgn = NULL;
+
+    SR_Bool isStable = FALSE;
+    for (uint64_t i = 0; i != numWindows && !isStable; ++i)
+    {
+        int32_t refID = pWindows[i] >> 32;
+        int32_t windowBegin = (int32_t) (pWindows[i] & 0xffffffff);
+        int32_t windowEnd = windowBegin + SR_SAMPLE_WINDOW_LEN;
+
+        if (SR_BamInStreamJumpTo(pBamInStream, refID, windowBegin) == SR_OK)
+        {
+            if (pMemPlan != NULL)
+                pFilterData->binLen = SR_MemPlanApply(pMemPlan, pBamInStream, refID);
+
+            // stop at the first pair ending beyond the window or at the next chromosome
+            SR_Bool isPast = FALSE;
+            while (!isPast && SR_BamInStreamLoadPair(&pUpNode, &pDownNode, pBamInStream) == SR_OK)
+            {
+                if (!pFilterData->isFilled)
+                {
+                    pUpAlgn = &(pUpNode->alignment);
+                    pDownAlgn = &(pDownNode->alignment);
+                }
+                else
+                {
+                    pUpAlgn = pFilterData->pUpAlgn;
+                    pDownAlgn = pFilterData->pDownAlgn;
+                }
+
+                // positions restart on the next chromosome, its pairs are not in the window
+                isPast = (pDownAlgn->core.tid != refID || pDownAlgn->core.pos >= windowEnd);
+                if (pDownAlgn->core.tid == refID)
+                    SR_ReadPairBuildCount(pHistArray, NULL, pUpAlgn, pDownAlgn, pLibTable, minMQ, binLen);
+
+                if (!pFilterData->isFilled)
+                {
+                    SR_BamInStreamRecycle(pBamInStream, pUpNode);
+                    SR_BamInStreamRecycle(pBamInStream, pDownNode);
+                }
+            }
+
+            SR_FilterDataRPResolveMates(pFilterData);
+            while (SR_FilterDataRPGetMate(pFilterData, &pUpAlgn, &pDownAlgn))
+                SR_ReadPairBuildCount(pHistArray, NULL, pUpAlgn, pDownAlgn, pLibTable, minMQ, binLen);
+        }
+
+        if ((i + 1) % SR_SAMPLE_ROUND_SIZE == 0)
+            isStable = SR_ReadPairBuildIsStable(pCutoffs, &snapshot, pHistArray, pLibTable, sampleTol);
+    }
+
+    free(snapshot.fragLen);
+    free(snapshot.freq);
+    free(pCutoffs);
+    free(pWindows);
+
+    return TRUE;
+}
+
+// classify the read pairs summarized in the first pass with the finished library table
+static void SR_ReadPairBuildReplay(SR_ReadPairTable* pReadPairTable, FILE* pairSpill, const SR_LibInfoTable* pLibTable,
+        const SR_FragLenHistArray* pHistArray, uint8_t minMQ)
+{
+    SR_PairSummary summary;
+
+    rewind(pairSpill);
+    while (fread(&summary, sizeof(SR_PairSummary), 1, pairSpill) == 1)
+    {
+        const SR_ZAtag* pZAtag = (summary.hasZA ? &(summary.zaTag) : NULL);
+        SV_ReadPairType readPairType = SR_GetReadPairType(pZAtag, &(summary.pairStats), summary.mapQ[0], summary.mapQ[1], pLibTable, minMQ);
+
+        SR_ReadPairTableAddSummary(pReadPairTable, &summary, readPairType, pLibTable, pHistArray);
+    }
+
+    if (ferror(pairSpill))
+        SR_ErrSys("ERROR: Cannot read the read pair summaries from a temporary file.\n");
+}
+
+// load the mates of the far and cross read pairs deferred by the filter
+// in the finished chromosome and update the read pair table with them
+static void SR_ReadPairBuildResolve(SR_ReadPairTable* pReadPairTable, SR_FilterDataRP* pFilterData,
+        const SR_LibInfoTable* pLibTable, const SR_FragLenHistArray* pHistArray, uint8_t minMQ)
+{
+    const bam1_t* pUpAlgn = NULL;
+    const bam1_t* pDownAlgn = NULL;
+
+    SR_FilterDataRPResolveMates(pFilterData);
+    while (SR_FilterDataRPGetMate(pFilterData, &pUpAlgn, &pDownAlgn))
+        SR_ReadPairBuildAdd(pReadPairTable, pUpAlgn, pDownAlgn, pLibTable, pHistArray, minMQ);
+}
+
+// update the read pair table with a read pair loaded from the bam in stream
+static void SR_ReadPairBuildUpdate(SR_ReadPairTable* pReadPairTable, SR_BamInStream* pBamInStream, const SR_FilterDataRP* pFilterData, SR_BamNode* pUpNode, SR_BamNode* pDownNode,
+        const SR_LibInfoTable* pLibTable, const SR_FragLenHistArray* pHistArray, uint8_t minMQ)
+{
+    const bam1_t* pUpAlgn = NULL;
+    const bam1_t* pDownAlgn = NULL;
+
+    // load the read pairs
+    if (!pFilterData->isFilled)
+    {
+        // usually we should catch the read pairs here
+        // since their fragment length should be smaller than the bin length
+        pUpAlgn = &(pUpNode->alignment);
+        pDownAlgn = &(pDownNode->alignment);
+    }
+    else
+    {
+        // if the fragment length of the read pair is beyond our bin length
+        // we should catch them here
+        pUpAlgn = pFilterData->pUpAlgn;
+        pDownAlgn = pFilterData->pDownAlgn;
+    }
+
+    SR_ReadPairBuildAdd(pReadPairTable, pUpAlgn, pDownAlgn, pLibTable, pHistArray, minMQ);
+
+    // recycle those bam nodes that are allocated from the memory pool
+    if (!pFilterData->isFilled)
+    {
+        SR_BamInStreamRecycle(pBamInStream, pUpNode);
+        SR_BamInStreamRecycle(pBamInStream, pDownNode);
+    }
+}
+
+// plan the bin lengths and the pool sizes of the chromosomes in a bam file
+static void SR_ReadPairBuildPlan(SR_MemPlan* pMemPlan, const char* bamFileName, const SR_BamHeader* pBamHeader, uint32_t binLen, uint32_t fragLenHigh)
+{
+    // the numbers of mapped reads are kept in the index
+    bam_index_t* pBamIndex = bam_index_load(bamFileName);
+    if (pBamIndex == NULL)
+        SR_ErrMsg("WARNING: Cannot open the bam index file for: %s. The memory plan will not use the read counts.\n", bamFileName);
+
+    SR_MemPlanSet(pMemPlan, pBamIndex, pBamHeader->pOrigHeader, binLen, fragLenHigh);
+
+    if (pBamIndex != NULL)
+        bam_index_destroy(pBamIndex);
+}
+
+// scan the chromosomes taken from the shared counter until all of them are done
+static void* SR_ReadPairShardScan(void* pArg)
+{
+    SR_ReadPairShard* pShard = (SR_ReadPairShard*) pArg;
+    const SR_AnchorInfo* pAnchorInfo = pShard->pLibTable->pAnchorInfo;
+
+    SR_BamNode* pUpNode = NULL;
+    SR_BamNode* pDownNode = NULL;
+
+    // the chromosomes are taken in increasing order, which is required by "SR_ReadPairTableMerge"
+    int32_t refID = 0;
+    while ((refID = __sync_fetch_and_add(pShard->pNextRefID, 1)) < (int32_t) pAnchorInfo->size)
+    {
+        if (pAnchorInfo->pLength[refID] <= 0)
+            continue;
+
+        if (SR_BamInStreamJump(pShard->pBamInStream, refID) != SR_OK)
+            continue;
+
+        if (pShard->pMemPlan != NULL)
+            pShard->pFilterData->binLen = SR_MemPlanApply(pShard->pMemPlan, pShard->pBamInStream, refID);
+
+        // stop at the first alignment of the next chromosome
+        while (SR_BamInStreamLoadPair(&pUpNode, &pDownNode, pShard->pBamInStream) == SR_OK)
+        {
+            // the next chromosome belongs to another thread
+            const bam1_t* pUpAlgn = (pShard->pFilterData->isFilled ? pShard->pFilterData->pUpAlgn : &(pUpNode->alignment));
+            if (pUpAlgn->core.tid != refID)
+            {
+                if (!pShard->pFilterData->isFilled)
+                {
+                    SR_BamInStreamRecycle(pShard->pBamInStream, pUpNode);
+                    SR_BamInStreamRecycle(pShard->pBamInStream, pDownNode);
+                }
+
+                break;
+            }
+
+            SR_ReadPairBuildUpdate(pShard->pReadPairTable, pShard->pBamInStream, pShard->pFilterData, pUpNode, pDownNode,
+                                   pShard->pLibTable, pShard->pHistArray, pShard->minMQ);
+        }
+
+        SR_ReadPairBuildResolve(pShard->pReadPairTable, pShard->pFilterData, pShard->pLibTable, pShard->pHistArray, pShard->minMQ);
+    }
+
+    return NULL;
+}
+
+// count the normal pairs of the chromosomes taken from the shared counter into the histograms of the thread
+static void* SR_ReadPairShardCount(void* pArg)
+{
+    SR_ReadPairShard* pShard = (SR_ReadPairShard*) pArg;
+    const SR_AnchorInfo* pAnchorInfo = pShard->pLibTable->pAnchorInfo;
+
+    SR_BamNode* pUpNode = NULL;
+    SR_BamNode* pDownNode = NULL;
+
+    const bam1_t* pUpAlgn = NULL;
+    const bam1_t* pDownAlgn = NULL;
+
+    int32_t refID = 0;
+    while ((refID = __sync_fetch_and_add(pShard->pNextRefID, 1)) < (int32_t) pAnchorInfo->size)
+    {
+        if (pAnchorInfo->pLength[refID] <= 0)
+            continue;
+
+        if (SR_BamInStreamJump(pShard->pBamInStream, refID) != SR_OK)
+            continue;
+
+        if (pShard->pMemPlan != NULL)
+            pShard->pFilterData->binLen = SR_MemPlanApply(pShard->pMemPlan, pShard->pBamInStream, refID);
+
+        while (SR_BamInStreamLoadPair(&pUpNode, &pDownNode, pShard->pBamInStream) == SR_OK)
+        {
+            if (!pShard->pFilterData->isFilled)
+            {
+                pUpAlgn = &(pUpNode->alignment);
+                pDownAlgn = &(pDownNode->alignment);
+            }
+            else
+            {
+                pUpAlgn = pShard->pFilterData->pUpAlgn;
+                pDownAlgn = pShard->pFilterData->pDownAlgn;
+            }
+
+            // the pairs of the next chromosome are counted by another thread
+            SR_Bool isPast = (pUpAlgn->core.tid != refID);
+            if (!isPast)
+                SR_ReadPairBuildCount(pShard->pLocalHist, NULL, pUpAlgn, pDownAlgn, pShard->pLibTable, pShard->minMQ, 0);
+
+            if (!pShard->pFilterData->isFilled)
+            {
+                SR_BamInStreamRecycle(pShard->pBamInStream, pUpNode);
+                SR_BamInStreamRecycle(pShard->pBamInStream, pDownNode);
+            }
+
+            if (isPast)
+                break;
+        }
+
+        SR_FilterDataRPResolveMates(pShard->pFilterData);
+        while (SR_FilterDataRPGetMate(pShard->pFilterData, &pUpAlgn, &pDownAlgn))
+        {
+            if (pUpAlgn->core.tid == refID)
+                SR_ReadPairBuildCount(pShard->pLocalHist, NULL, pUpAlgn, pDownAlgn, pShard->pLibTable, pShard->minMQ, 0);
+        }
+    }
+
+    return NULL;
+}
+
+// run the scanning threads over all the chromosomes of a bam file
+static void SR_ReadPairShardsRun(SR_ReadPairShard* pShards, unsigned int numShards, void* (*scanFunc) (void*),
+        const char* bamFileName, SR_Bool loadCross)
+{
+    int32_t nextRefID = 0;
+
+    pthread_t* threads = (pthread_t*) malloc(numShards * sizeof(pthread_t));
+    if (threads == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the scanning threads.\n");
+
+    for (unsigned int i = 0; i != numShards; ++i)
+    {
+        SR_ReadPairShard* pShard = pShards + i;
+
+        SR_FilterDataRPInit(pShard->pFilterData, bamFileName);
+        pShard->pFilterData->loadCross = loadCross;
+
+        if (SR_BamInStreamOpen(pShard->pBamInStream, bamFileName) != SR_OK)
+            SR_ErrQuit("ERROR: Cannot scan the bam file by chromosomes without its index: %s\n", bamFileName);
+
+        pShard->pNextRefID = &nextRefID;
+
+        if (pthread_create(threads + i, NULL, scanFunc, pShard) != 0)
+            SR_ErrQuit("ERROR: Cannot create a scanning thread.\n");
+    }
+
+    for (unsigned int i = 0; i != numShards; ++i)
+        pthread_join(threads[i], NULL);
+
+    free(threads);
+
+    for (unsigned int i = 0; i != numShards; ++i)
+        SR_BamInStreamClose(pShards[i].pBamInStream);
+}
+
+// append the pairs of a chromosome in a local pair array to another one
+static void SR_LocalPairArrayAppend(SR_LocalPairArray* pDstArray, const SR_LocalPairArray* pSrcArray, uint64_t* pSrcPos, unsigned int refID)
+{
+    uint64_t numPairs = pSrcArray->chrCount[refID];
+    if (numPairs == 0)
+        return;
+
+    if (pDstArray->size + numPairs > pDstArray->capacity)
+        SR_ARRAY_RESIZE(pDstArray, (pDstArray->size + numPairs) * 2, SR_LocalPair);
+
+    memcpy(pDstArray->data + pDstArray->size, pSrcArray->data + *pSrcPos, sizeof(SR_LocalPair) * numPairs);
+
+    pDstArray->chrCount[refID] += numPairs;
+    pDstArray->size += numPairs;
+    *pSrcPos += numPairs;
+}
+
+// append the pairs of a chromosome in a cross pair array to another one
+static void SR_CrossPairArrayAppend(SR_CrossPairArray* pDstArray, const SR_CrossPairArray* pSrcArray, uint64_t* pSrcPos, unsigned int refID)
+{
+    uint64_t numPairs = pSrcArray->chrCount[refID];
+    if (numPairs == 0)
+        return;
+
+    if (pDstArray->size + numPairs > pDstArray->capacity)
+        SR_ARRAY_RESIZE(pDstArray, (pDstArray->size + numPairs) * 2, SR_CrossPair);
+
+    memcpy(pDstArray->data + pDstArray->size, pSrcArray->data + *pSrcPos, sizeof(SR_CrossPair) * numPairs);
+
+    pDstArray->chrCount[refID] += numPairs;
+    pDstArray->size += numPairs;
+    *pSrcPos += numPairs;
+}
+
+// append a special pair to a special pair array with its special reference ID renumbered in the destination table
+static void SR_SpecialPairArrayAppend(SR_SpecialPairArray* pDstArray, SR_SpecialPairTable* pDstTable, const SR_SpecialPair* pSrcPair, const SR_SpecialPairTable* pSrcTable)
+{
+    if (pDstArray->size == pDstArray->capacity)
+        SR_ARRAY_RESIZE(pDstArray, pDstArray->capacity * 2, SR_SpecialPair);
+
+    SR_SpecialPair* pDstPair = pDstArray->data + pDstArray->size;
+    *pDstPair = *pSrcPair;
+    pDstPair->specialID = SR_SpecialPairTableGetID(pDstTable, pSrcTable->names[pSrcPair->specialID]);
+
+    ++(pDstArray->size);
+}
+
+// number of pairs of a table whose mates are both on a chromosome. they can only
+// be found by the thread scanning that chromosome
+static uint64_t SR_ReadPairTableCountLocal(const SR_ReadPairTable* pTable, unsigned int refID)
+{
+    const SR_LocalPairArray* pLocalArrays[] =
+    {
+        pTable->pLongPairArray,
+
+        pTable->pShortPairArray,
+
+        pTable->pReversedPairArray,
+
+        pTable->pInvertedPairArray
+    };
+
+    uint64_t numPairs = 0;
+    for (unsigned int i = 0; i != sizeof(pLocalArrays) / sizeof(pLocalArrays[0]); ++i)
+    {
+        if (pLocalArrays[i] != NULL)
+            numPairs += pLocalArrays[i]->chrCount[refID];
+    }
+
+    return numPairs;
+}
+
+
 //===============================
 // Constructors and Destructors
 //===============================
@@ -494,6 +1152,18 @@ void SR_ReadPairBuild(const SR_ReadPairBuildPars* pBuildPars)
     unsigned int reportSize = 0;
     unsigned int numThread = 0;
 
+    // the scanning threads. each one has its own bam in stream, filter data and read pair table
+    unsigned int numShards = (pBuildPars->numThreads > 1 ? pBuildPars->numThreads : 0);
+
+    // under a memory limit the buffers are sized by the plan, which is
+    // shared by the streams that scan the chromosomes at the same time
+    SR_MemPlan* pMemPlan = NULL;
+    if (pBuildPars->memLimit != 0)
+    {
+        pMemPlan = SR_MemPlanAlloc(pBuildPars->memLimit, (numShards > 0 ? numShards : 1));
+        buffCapacity = pMemPlan->buffCapacity;
+    }
+
     // initialize the library information table
     SR_LibInfoTable* pLibTable = SR_LibInfoTableAlloc(capAnchor, capSample, capReadGrp);
     SR_LibInfoTableSetCutoff(pLibTable, pBuildPars->cutoff);
@@ -502,21 +1172,57 @@ void SR_ReadPairBuild(const SR_ReadPairBuildPars* pBuildPars)
     // this is the data used to filter the read pairs in the bam
     SR_FilterDataRP* pFilterData = SR_FilterDataRPAlloc(pLibTable->pAnchorInfo, pBuildPars->binLen);
 
+    // the mates of the far and cross read pairs are collected at the end of each chromosome
+    SR_FilterDataRPTurnOnDefer(pFilterData);
+
     // set the stream mode to read pair filter
     SR_StreamMode streamMode;
-    SR_SetStreamMode(&streamMode, SR_ReadPairFilter, pFilterData, SR_READ_PAIR_MODE);
+    // the sampling of the first pass reads the windows of the chromosomes through the index
+    SR_SetStreamMode(&streamMode, SR_ReadPairFilter, pFilterData, SR_READ_PAIR_MODE | (pBuildPars->sampleTol > 0.0 ? SR_USE_BAM_INDEX : 0));
+
+    // the read pairs are summarized from the core, the cigar and the
+    // tags, the sequence and the qualities are never decoded
+    SR_SetStreamPrefilter(&streamMode, SR_ReadPairCoreFilter, SR_DROP_SEQ_QUAL);
 
     // structure initialization
     SR_BamInStream* pBamInStream = SR_BamInStreamAlloc(pBuildPars->binLen, numThread, buffCapacity, reportSize, &streamMode);
-    SR_FragLenHistArray* pHistArray = SR_FragLenHistArrayAlloc(capHist);
+    SR_FragLenHistArray* pHistArray = SR_FragLenHistArrayAlloc(capHist, pBuildPars->maxHistFragLen);
     SR_BamHeader* pBamHeader = NULL;
 
     // a flag to indicate if we have created the read pair table
     SR_Bool hasReadPairTable = FALSE;
     SR_ReadPairTable* pReadPairTable = NULL;
 
-    // file hash
-    khash_t(file)* pFileHash = NULL;
+    // container of the read pairs of all the bam files
+    SR_ReadPairOutFile* pOutFile = NULL;
+
+    SR_ReadPairShard* pShards = NULL;
+    SR_ReadPairTable** pShardTables = NULL;
+
+    if (numShards > 0)
+    {
+        pShards = (SR_ReadPairShard*) calloc(numShards, sizeof(SR_ReadPairShard));
+        pShardTables = (SR_ReadPairTable**) calloc(numShards, sizeof(SR_ReadPairTable*));
+        if (pShards == NULL || pShardTables == NULL)
+            SR_ErrQuit("ERROR: Not enough memory for the scanning threads.\n");
+
+        SR_StreamMode shardMode;
+        for (unsigned int i = 0; i != numShards; ++i)
+        {
+            pShards[i].pFilterData = SR_FilterDataRPAlloc(pLibTable->pAnchorInfo, pBuildPars->binLen);
+            SR_FilterDataRPTurnOnDefer(pShards[i].pFilterData);
+
+            SR_SetStreamMode(&shardMode, SR_ReadPairFilter, pShards[i].pFilterData, SR_READ_PAIR_MODE | SR_USE_BAM_INDEX);
+            SR_SetStreamPrefilter(&shardMode, SR_ReadPairCoreFilter, SR_DROP_SEQ_QUAL);
+            pShards[i].pBamInStream = SR_BamInStreamAlloc(pBuildPars->binLen, numThread, buffCapacity, reportSize, &shardMode);
+            pShards[i].pLocalHist = SR_FragLenHistArrayAlloc(capHist, pBuildPars->maxHistFragLen);
+
+            pShards[i].pLibTable = pLibTable;
+            pShards[i].pHistArray = pHistArray;
+            pShards[i].pMemPlan = pMemPlan;
+            pShards[i].minMQ = pBuildPars->minMQ;
+        }
+    }
 
     // required arguments for bam in stream structure
     char* histOutputFile = SR_CreateFileName(pBuildPars->workingDir, SR_HistFileName);
@@ -551,18 +1257,87 @@ void SR_ReadPairBuild(const SR_ReadPairBuildPars* pBuildPars)
         // initialize the fragment length histogram array with the number of newly added libraries in the bam file
         SR_FragLenHistArrayInit(pHistArray, pLibTable->size - oldSize);
 
+        // the histograms of a bam file seen by an earlier run are loaded from its cache
+        // and the first pass is skipped. only the cutoffs are computed again
+        SR_Bool hasCacheKey = FALSE;
+        SR_Bool isCached = FALSE;
+        SR_FragLenCacheKey cacheKey;
+        if (pBuildPars->useHistCache)
+        {
+            hasCacheKey = (SR_FragLenCacheSetKey(&cacheKey, bamFileName, pBamHeader, pBuildPars->binLen, pBuildPars->minMQ,
+                                                 pBuildPars->sampleTol, pHistArray->size) == SR_OK);
+            isCached = (hasCacheKey && SR_FragLenCacheLoad(pHistArray, &cacheKey, bamFileName) == SR_OK);
+        }
+
+        // in the single-pass mode the bam file is read only once. the first pass keeps the
+        // summaries of the pairs that may be abnormal and they are classified afterwards
+        FILE* pairSpill = NULL;
+        if (pBuildPars->singlePass && !isCached && pBuildPars->sampleTol <= 0.0)
+        {
+            pairSpill = tmpfile();
+            if (pairSpill == NULL)
+                SR_ErrSys("ERROR: Cannot create a temporary file for the read pair summaries.\n");
+
+            if ((pBuildPars->detectSet & SV_INTER_CHR_TRNSLCTN) != 0)
+                SR_FilterDataRPTurnOnCross(pFilterData);
+        }
+
+        // the fragment lengths of the new libraries are not known yet
+        if (pMemPlan != NULL && !isCached)
+        {
+            SR_ReadPairBuildPlan(pMemPlan, bamFileName, pBamHeader, pBuildPars->binLen, pLibTable->fragLenMax);
+            pFilterData->binLen = SR_MemPlanApply(pMemPlan, pBamInStream, -1);
+        }
+
         SR_BamNode* pUpNode = NULL;
         SR_BamNode* pDownNode = NULL;
 
         const bam1_t* pUpAlgn = NULL;
         const bam1_t* pDownAlgn = NULL;
 
-        SR_Status bamStatus = SR_OK;
-        while ((bamStatus = SR_BamInStreamLoadPair(&pUpNode, &pDownNode, pBamInStream)) != SR_EOF && bamStatus != SR_ERR)
+        // only a part of the bam file is read if the histograms can be sampled
+        SR_Bool isSampled = (!isCached && pBuildPars->sampleTol > 0.0
+                             && SR_ReadPairBuildSample(pHistArray, pBamInStream, pFilterData, pLibTable, pMemPlan,
+                                                       pBuildPars->minMQ, pBuildPars->binLen, pBuildPars->sampleTol));
+
+        SR_Status bamStatus = (isCached || isSampled ? SR_EOF : SR_OK);
+
+        // count the chromosomes in parallel. the histograms of the threads are only added up,
+        // so they give the same histograms as a single stream. the summaries of the single-pass
+        // mode have to be written in order and are left to the single stream
+        if (bamStatus == SR_OK && numShards > 1 && pairSpill == NULL)
         {
-            // we hit another chromosome
-            if (bamStatus == SR_OUT_OF_RANGE)
+            if (pMemPlan != NULL)
+                SR_BamInStreamShrinkPool(pBamInStream, 1);
+
+            for (unsigned int i = 0; i != numShards; ++i)
+                SR_FragLenHistArrayInit(pShards[i].pLocalHist, pHistArray->size);
+
+            SR_ReadPairShardsRun(pShards, numShards, SR_ReadPairShardCount, bamFileName, FALSE);
+
+            for (unsigned int i = 0; i != numShards; ++i)
+                SR_FragLenHistArrayMerge(pHistArray, pShards[i].pLocalHist);
+
+            bamStatus = SR_EOF;
+        }
+
+        while (bamStatus != SR_EOF && bamStatus != SR_ERR)
+        {
+            bamStatus = SR_BamInStreamLoadPair(&pUpNode, &pDownNode, pBamInStream);
+
+            // we hit another chromosome or the end of the file.
+            // update the histogram with the read pairs deferred in the finished chromosome
+            if (bamStatus != SR_OK)
+            {
+                if (pMemPlan != NULL && bamStatus == SR_OUT_OF_RANGE)
+                    pFilterData->binLen = SR_MemPlanApply(pMemPlan, pBamInStream, SR_BamInStreamGetNextRefID(pBamInStream));
+
+                SR_FilterDataRPResolveMates(pFilterData);
+                while (SR_FilterDataRPGetMate(pFilterData, &pUpAlgn, &pDownAlgn))
+                    SR_ReadPairBuildCount(pHistArray, pairSpill, pUpAlgn, pDownAlgn, pLibTable, pBuildPars->minMQ, pBuildPars->binLen);
+
                 continue;
+            }
 
             // load the read pairs
             if (!pFilterData->isFilled)
@@ -580,12 +1355,7 @@ void SR_ReadPairBuild(const SR_ReadPairBuildPars* pBuildPars)
                 pDownAlgn = pFilterData->pDownAlgn;
             }
 
-            // check if the incoming read pair is normal (unique-unique pair)
-            // if yes, then update the corresponding fragment length histogram
-            SR_PairStats pairStats;
-            unsigned int backHistIndex = 0;
-            if (SR_IsNormalPair(&pairStats, &backHistIndex, pUpAlgn, pDownAlgn, pLibTable, pBuildPars->minMQ))
-                SR_FragLenHistArrayUpdate(pHistArray, backHistIndex, pairStats.fragLen);
+            SR_ReadPairBuildCount(pHistArray, pairSpill, pUpAlgn, pDownAlgn, pLibTable, pBuildPars->minMQ, pBuildPars->binLen);
 
             // recycle those bam nodes that are allocated from the memory pool
             if (!pFilterData->isFilled)
@@ -599,6 +1369,9 @@ void SR_ReadPairBuild(const SR_ReadPairBuildPars* pBuildPars)
         SR_FragLenHistArrayFinalize(pHistArray);
         SR_LibInfoTableUpdate(pLibTable, pHistArray, oldSize);
 
+        if (hasCacheKey && !isCached)
+            SR_FragLenCacheSave(pHistArray, &cacheKey, bamFileName);
+
         // write the fragment length histogram into the file
         SR_FragLenHistArrayWrite(pHistArray, histOutput);
 
@@ -607,67 +1380,77 @@ void SR_ReadPairBuild(const SR_ReadPairBuildPars* pBuildPars)
         SR_BamInStreamClear(pBamInStream);
 
         // rewind the bam file to the beginning of the alignments (right after the header)
-        SR_BamInStreamSeek(pBamInStream, bamPos, SEEK_SET);
+        if (pairSpill == NULL)
+            SR_BamInStreamSeek(pBamInStream, bamPos, SEEK_SET);
 
         // we only have to create the read pair table and open the read pair files once
         if (!hasReadPairTable)
         {
             pReadPairTable = SR_ReadPairTableAlloc(pLibTable->pAnchorInfo->size, pBuildPars->detectSet); 
-            pFileHash = SR_ReadPairFilesOpen(pLibTable, pBuildPars->detectSet, pBuildPars->workingDir);
+            pOutFile = SR_ReadPairFileOpen(pBuildPars->detectSet, pBuildPars->workingDir);
             hasReadPairTable =TRUE;
+
+            for (unsigned int i = 0; i != numShards; ++i)
+            {
+                pShardTables[i] = SR_ReadPairTableAlloc(pLibTable->pAnchorInfo->size, pBuildPars->detectSet);
+                pShards[i].pReadPairTable = pShardTables[i];
+            }
         }
 
         // we need to load the cross pair if we want to detect inter-chromosome translocation
         if ((pBuildPars->detectSet & SV_INTER_CHR_TRNSLCTN) != 0)
             SR_FilterDataRPTurnOnCross(pFilterData);
 
-        while ((bamStatus = SR_BamInStreamLoadPair(&pUpNode, &pDownNode, pBamInStream)) != SR_EOF && bamStatus != SR_ERR)
+        // the bins should now cover the normal fragments of the new libraries
+        if (pMemPlan != NULL && pairSpill == NULL)
+            SR_ReadPairBuildPlan(pMemPlan, bamFileName, pBamHeader, pBuildPars->binLen, pLibTable->fragLenMax);
+
+        if (pairSpill != NULL)
         {
-            // we hit another chromosome
-            if (bamStatus == SR_OUT_OF_RANGE)
-                continue;
+            // the summaries are kept in the order the second pass would add the pairs
+            SR_ReadPairBuildReplay(pReadPairTable, pairSpill, pLibTable, pHistArray, pBuildPars->minMQ);
+            fclose(pairSpill);
+        }
+        else if (numShards > 1)
+        {
+            // scan the chromosomes in parallel. each thread has its own bam in stream and read pair table.
+            // the main stream is idle while the threads scan the chromosomes
+            if (pMemPlan != NULL)
+                SR_BamInStreamShrinkPool(pBamInStream, 1);
 
-            // load the read pairs
-            if (!pFilterData->isFilled)
-            {
-                // usually we should catch the read pairs here
-                // since their fragment length should be smaller than the bin length
-                pUpAlgn = &(pUpNode->alignment);
-                pDownAlgn = &(pDownNode->alignment);
-            }
-            else
-            {
-                // if the fragment length of the read pair is beyond our bin length
-                // we should catch them here
-                pUpAlgn = pFilterData->pUpAlgn;
-                pDownAlgn = pFilterData->pDownAlgn;
-            }
+            SR_ReadPairShardsRun(pShards, numShards, SR_ReadPairShardScan, bamFileName, pFilterData->loadCross);
 
-            SR_ZAtag zaTag;
-            SR_PairStats pairStats;
+            SR_ReadPairTableMerge(pReadPairTable, pShardTables, numShards);
 
-            SR_Status readStatus = SR_LoadPairStats(&pairStats, pUpAlgn, pLibTable);
+            for (unsigned int i = 0; i != numShards; ++i)
+                SR_ReadPairTableClear(pShardTables[i]);
+        }
+        else
+        {
+            if (pMemPlan != NULL)
+                pFilterData->binLen = SR_MemPlanApply(pMemPlan, pBamInStream, -1);
 
-            if (readStatus == SR_OK)
+            while ((bamStatus = SR_BamInStreamLoadPair(&pUpNode, &pDownNode, pBamInStream)) != SR_EOF && bamStatus != SR_ERR)
             {
-                SR_Status ZAstatus = SR_LoadZAtag(&zaTag, pUpAlgn);
+                // we hit another chromosome, the pairs deferred in the finished one are added
+                // now so that the pairs of each chromosome stay together in the table
+                if (bamStatus == SR_OUT_OF_RANGE)
+                {
+                    SR_ReadPairBuildResolve(pReadPairTable, pFilterData, pLibTable, pHistArray, pBuildPars->minMQ);
 
-                if (ZAstatus == SR_OK)
-                    SR_ReadPairTableUpdate(pReadPairTable, pUpAlgn, pDownAlgn, &zaTag, &pairStats, pLibTable, pHistArray, pBuildPars->minMQ);
-                else
-                    SR_ReadPairTableUpdate(pReadPairTable, pUpAlgn, pDownAlgn, NULL, &pairStats, pLibTable, pHistArray, pBuildPars->minMQ);
-            }
+                    if (pMemPlan != NULL)
+                        pFilterData->binLen = SR_MemPlanApply(pMemPlan, pBamInStream, SR_BamInStreamGetNextRefID(pBamInStream));
 
+                    continue;
+                }
 
-            // recycle those bam nodes that are allocated from the memory pool
-            if (!pFilterData->isFilled)
-            {
-                SR_BamInStreamRecycle(pBamInStream, pUpNode);
-                SR_BamInStreamRecycle(pBamInStream, pDownNode);
+                SR_ReadPairBuildUpdate(pReadPairTable, pBamInStream, pFilterData, pUpNode, pDownNode, pLibTable, pHistArray, pBuildPars->minMQ);
             }
+
+            SR_ReadPairBuildResolve(pReadPairTable, pFilterData, pLibTable, pHistArray, pBuildPars->minMQ);
         }
 
-        SR_ReadPairTableWrite(pReadPairTable, pFileHash);
+        SR_ReadPairTableWrite(pReadPairTable, pOutFile);
         SR_ReadPairTableClear(pReadPairTable);
 
         // close the bam file
@@ -675,8 +1458,8 @@ void SR_ReadPairBuild(const SR_ReadPairBuildPars* pBuildPars)
         SR_BamHeaderFree(pBamHeader);
     }
 
-    // close all the read pair files
-    SR_ReadPairFilesClose(pFileHash);
+    // write the index of the read pair container
+    SR_ReadPairOutFileClose(pOutFile);
 
     // get the library table output file name
     char* libTableOutputFile = SR_CreateFileName(pBuildPars->workingDir, SR_LibTableFileName);
@@ -702,6 +1485,18 @@ void SR_ReadPairBuild(const SR_ReadPairBuildPars* pBuildPars)
     SR_FilterDataRPFree(pFilterData);
     SR_ReadPairTableFree(pReadPairTable);
     SR_BamInStreamFree(pBamInStream);
+    SR_MemPlanFree(pMemPlan);
+
+    for (unsigned int i = 0; i != numShards; ++i)
+    {
+        SR_FilterDataRPFree(pShards[i].pFilterData);
+        SR_ReadPairTableFree(pShardTables[i]);
+        SR_BamInStreamFree(pShards[i].pBamInStream);
+        SR_FragLenHistArrayFree(pShards[i].pLocalHist);
+    }
+
+    free(pShards);
+    free(pShardTables);
 }
 
 // clear the read pair table
@@ -745,277 +1540,160 @@ void SR_ReadPairTableUpdate(SR_ReadPairTable* pReadPairTable, const bam1_t* pUpA
         const SR_PairStats* pPairStats, const SR_LibInfoTable* pLibTable, const SR_FragLenHistArray* pHistArray, uint8_t minMQ)
 {
     // check the read pair type
-    SV_ReadPairType readPairType = PT_NORMAL;
-    readPairType = SR_CheckReadPairType(pZAtag, pPairStats, pLibTable);
-
-    // check the mapping quality for all read pairs except the special read pairs
-    if (readPairType != PT_SPECIAL5 && readPairType != PT_SPECIAL3)
-    {
-        if (pUpAlgn->core.qual < minMQ || pDownAlgn->core.qual < minMQ)
-            readPairType = PT_UNKNOWN;
-    }
+    SV_ReadPairType readPairType = SR_GetReadPairType(pZAtag, pPairStats, pUpAlgn->core.qual, pDownAlgn->core.qual, pLibTable, minMQ);
 
-    switch (readPairType)
+    // the mismatches and the alignment ends are only counted for the pairs we keep
+    if (readPairType != PT_NORMAL && readPairType != PT_UNKNOWN)
     {
-        case PT_NORMAL:
-        case PT_UNKNOWN:
-            break;
-        case PT_LONG:
-            if (pReadPairTable->pLongPairArray != NULL)
-                SR_LocalPairArrayUpdate(pReadPairTable->pLongPairArray, pUpAlgn, pDownAlgn, pLibTable, pHistArray, pPairStats, readPairType);
-            break;
-        case PT_SHORT:
-            if (pReadPairTable->pShortPairArray != NULL)
-                SR_LocalPairArrayUpdate(pReadPairTable->pShortPairArray, pUpAlgn, pDownAlgn, pLibTable, pHistArray, pPairStats, readPairType);
-            break;
-        case PT_REVERSED:
-            if (pReadPairTable->pReversedPairArray != NULL)
-                SR_LocalPairArrayUpdate(pReadPairTable->pReversedPairArray, pUpAlgn, pDownAlgn, pLibTable, pHistArray, pPairStats, readPairType);
-            break;
-        case PT_INVERTED3:
-        case PT_INVERTED5:
-            if (pReadPairTable->pInvertedPairArray != NULL)
-                SR_InvertedPairArrayUpdate(pReadPairTable->pInvertedPairArray, pUpAlgn, pDownAlgn, pPairStats, readPairType);
-            break;
-        case PT_CROSS:
-            if (pReadPairTable->pCrossPairArray != NULL)
-                SR_CrossPairArrayUpdate(pReadPairTable->pCrossPairArray, pUpAlgn, pDownAlgn, pPairStats);
-            break;
-        case PT_SPECIAL3:
-        case PT_SPECIAL5:
-            if (pReadPairTable->pSpecialPairTable != NULL) 
-                SR_SpecialPairTableUpdate(pReadPairTable->pSpecialPairTable, pUpAlgn, pDownAlgn, pLibTable, pHistArray, pPairStats, pZAtag, readPairType);
-            break;
-        default:
-            break;
+        SR_PairSummary summary;
+        SR_PairSummaryLoad(&summary, pUpAlgn, pDownAlgn, pZAtag, pPairStats);
+        SR_ReadPairTableAddSummary(pReadPairTable, &summary, readPairType, pLibTable, pHistArray);
     }
 }
 
-// open a seriers read pair files for output. A read pair
-// file will be open for each read pair type on each chromosome
-void* SR_ReadPairFilesOpen(const SR_LibInfoTable* pLibTable, uint32_t detectSet, const char* workingDir)
+// merge the read pair tables built by the scanning threads
+void SR_ReadPairTableMerge(SR_ReadPairTable* pDstTable, SR_ReadPairTable* const* ppSrcTables, unsigned int numSrc)
 {
-    khash_t(file)* pFileHash = kh_init(file);
-
-    // buffer to hold the reference ID
-    char refBuff[4];
+    // read positions in the arrays of each source table
+    uint64_t (*srcPos)[7] = (uint64_t (*)[7]) calloc(numSrc, sizeof(uint64_t) * 7);
+    if (srcPos == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for the merge of the read pair tables.\n");
 
-    // length of the working directory
-    int dirLen = strlen(workingDir);
+    // a chromosome is scanned by only one thread, so at most one source table has pairs in it
+    for (unsigned int i = 0; i != pDstTable->numChr; ++i)
+    {
+        // a chromosome scanned by two threads would be written twice
+        unsigned int numScanned = 0;
+        for (unsigned int j = 0; j != numSrc; ++j)
+        {
+            if (SR_ReadPairTableCountLocal(ppSrcTables[j], i) != 0)
+                ++numScanned;
+        }
 
-    // buffer to hold the full read pair file name
-    char nameBuff[dirLen + 50];
+        if (numScanned > 1)
+            SR_ErrQuit("ERROR: The chromosome %u is scanned by more than one thread.\n", i);
 
-    // copy the working directory name into the name buffer
-    strncpy(nameBuff, workingDir, dirLen);
-    char* namePos = nameBuff + dirLen;
-    char* replacePos = namePos + 3;
+        for (unsigned int j = 0; j != numSrc; ++j)
+        {
+            const SR_ReadPairTable* pSrcTable = ppSrcTables[j];
 
-    // the reference ID should not be larger than 1000 (arbitrary, but reasonable)
-    const SR_AnchorInfo* pAnchorInfo = pLibTable->pAnchorInfo;
-    if (pAnchorInfo->size > 1000)
-        SR_ErrQuit("ERROR: reference ID overflow (0-999).\n");
+            if (pDstTable->pLongPairArray != NULL)
+                SR_LocalPairArrayAppend(pDstTable->pLongPairArray, pSrcTable->pLongPairArray, &(srcPos[j][0]), i);
 
-    // this is the place holder put at the beginning of each read pair file
-    // different SV types may have different file headers
-    const uint64_t placeHolder = 0;
-    SR_ReadPairOutStream stream = {NULL, 0};
+            if (pDstTable->pShortPairArray != NULL)
+                SR_LocalPairArrayAppend(pDstTable->pShortPairArray, pSrcTable->pShortPairArray, &(srcPos[j][1]), i);
 
-    for (unsigned int i = 0; i != pAnchorInfo->size; ++i)
-    {
-        if (pAnchorInfo->pLength[i] <= 0)
-            continue;
+            if (pDstTable->pReversedPairArray != NULL)
+                SR_LocalPairArrayAppend(pDstTable->pReversedPairArray, pSrcTable->pReversedPairArray, &(srcPos[j][2]), i);
 
-        // copy the reference ID into the name buffer
-        unsigned int offset = 2 - (unsigned int) log10(i);
-        sprintf(refBuff, "000");
-        sprintf(refBuff + offset, "%d", i);
+            if (pDstTable->pInvertedPairArray != NULL)
+                SR_LocalPairArrayAppend(pDstTable->pInvertedPairArray, pSrcTable->pInvertedPairArray, &(srcPos[j][3]), i);
 
-        int fileID = 0;
-        int ret = 0;
-        khiter_t khIter = 0;
-        unsigned int fileIndex = SR_LONG_PAIR_FILE;
+            if (pDstTable->pCrossPairArray != NULL)
+                SR_CrossPairArrayAppend(pDstTable->pCrossPairArray, pSrcTable->pCrossPairArray, &(srcPos[j][4]), i);
 
-        for (unsigned int j = SV_DELETION; j <= SV_SPECIAL; ++j)
-        {
-            if ((detectSet & (1 << j)) != 0)
+            if (pDstTable->pSpecialPairTable != NULL)
             {
-                strcpy(namePos, SR_READ_PAIR_FILE_NAME_TEMPLATE[fileIndex]);
-                strncpy(replacePos, refBuff, 3);
+                SR_SpecialPairTable* pDstSpecial = pDstTable->pSpecialPairTable;
+                const SR_SpecialPairTable* pSrcSpecial = pSrcTable->pSpecialPairTable;
 
-                stream.output = fopen(nameBuff, "wb");
-                if (stream.output == NULL)
-                    SR_ErrQuit("ERROR: Cannot open file: %d\n", nameBuff);
+                uint64_t numPairs = pSrcSpecial->array.chrCount[i];
+                for (uint64_t k = 0; k != numPairs; ++k, ++(srcPos[j][5]))
+                    SR_SpecialPairArrayAppend(&(pDstSpecial->array), pDstSpecial, pSrcSpecial->array.data + srcPos[j][5], pSrcSpecial);
 
-                fileID = i * SR_NUM_RP_FILE + fileIndex; 
-                khIter = kh_put(file, pFileHash, fileID, &ret);
-                kh_value(pFileHash, khIter) = stream;
-                // leave a place for the total number of read pairs
-                fwrite(&placeHolder, sizeof(uint64_t), 1, stream.output);
+                pDstSpecial->array.chrCount[i] += numPairs;
 
-                // for tandem duplication we have two read types to take care
-                if (j == SV_TANDEM_DUP)
+                // the special pairs whose anchor is on another chromosome were found while scanning their up mate (refID[1])
+                while (srcPos[j][6] != pSrcSpecial->crossArray.size && pSrcSpecial->crossArray.data[srcPos[j][6]].refID[1] == (int16_t) i)
                 {
-                    ++fileIndex;
-
-                    strcpy(namePos, SR_READ_PAIR_FILE_NAME_TEMPLATE[fileIndex]);
-                    strncpy(replacePos, refBuff, 3);
-
-                    stream.output = fopen(nameBuff, "wb");
-                    if (stream.output == NULL)
-                        SR_ErrQuit("ERROR: Cannot open file: %d\n", nameBuff);
-
-                    fileID = i * SR_NUM_RP_FILE + fileIndex; 
-                    khIter = kh_put(file, pFileHash, fileID, &ret);
-                    kh_value(pFileHash, khIter) = stream;
-
-                    // leave a place for the total number of read pairs
-                    fwrite(&placeHolder, sizeof(uint64_t), 1, stream.output);
+                    SR_SpecialPairArrayAppend(&(pDstSpecial->crossArray), pDstSpecial, pSrcSpecial->crossArray.data + srcPos[j][6], pSrcSpecial);
+                    ++(srcPos[j][6]);
                 }
             }
-
-            ++fileIndex;
         }
     }
 
-    return ((void*) pFileHash);
+    free(srcPos);
 }
 
-// close all the read pair files
-void SR_ReadPairFilesClose(void* pFileHash)
+// open the container of the read pairs. only the read pair
+// types needed by the SV events to detect are written
+SR_ReadPairOutFile* SR_ReadPairFileOpen(uint32_t detectSet, const char* workingDir)
 {
-    khash_t(file)* pHash = (khash_t(file)*) pFileHash;
+    uint32_t typeSet = 0;
+    unsigned int pairType = SR_LONG_PAIR_BLOCK;
 
-    for (khiter_t khIter = kh_begin(pHash); khIter != kh_end(pHash); ++khIter)
+    for (unsigned int j = SV_DELETION; j <= SV_SPECIAL; ++j)
     {
-        if (kh_exist(pHash, khIter))
+        if ((detectSet & (1 << j)) != 0)
         {
-            fseeko(kh_value(pHash, khIter).output, 0, SEEK_SET);
-            fwrite(&(kh_value(pHash, khIter).numPairs), sizeof(uint64_t), 1, kh_value(pHash, khIter).output);
-            fclose(kh_value(pHash, khIter).output);
+            typeSet |= (1 << pairType);
+
+            // for tandem duplication we have two read types to take care
+            if (j == SV_TANDEM_DUP)
+                typeSet |= (1 << (pairType + 1));
         }
+
+        pairType += (j == SV_TANDEM_DUP ? 2 : 1);
     }
 
-    kh_destroy(file, pHash);
+    char* fileName = SR_CreateFileName(workingDir, SR_READ_PAIR_FILE_NAME);
+    SR_ReadPairOutFile* pOutFile = SR_ReadPairOutFileOpen(fileName, typeSet);
+
+    free(fileName);
+
+    return pOutFile;
 }
 
-// write the read pair table into the read pair files
-void SR_ReadPairTableWrite(const SR_ReadPairTable* pReadPairTable, void* pHash)
+// write the read pair table into the read pair container
+void SR_ReadPairTableWrite(const SR_ReadPairTable* pReadPairTable, SR_ReadPairOutFile* pOutFile)
 {
-    khash_t(file)* pFileHash = (khash_t(file)*) pHash;
     unsigned int numChr = pReadPairTable->numChr;
 
-    int fileID = 0;
-    khiter_t khIter = 0;
-
-    int currPos[] = {0, 0, 0, 0, 0, 0};
-
-    for (unsigned int i = 0; i != numChr; ++i)
+    const SR_LocalPairArray* pLocalArrays[] =
     {
-        int numPairs = pReadPairTable->pLongPairArray == NULL ? 0 : pReadPairTable->pLongPairArray->chrCount[i];
-        if (numPairs > 0)
-        {
-            fileID = i * SR_NUM_RP_FILE + SR_LONG_PAIR_FILE;
-            khIter = kh_get(file, pFileHash, fileID);
+        pReadPairTable->pLongPairArray,
 
-            if (khIter != kh_end(pFileHash))
-            {
-                kh_value(pFileHash, khIter).numPairs += numPairs;
-                fwrite(pReadPairTable->pLongPairArray->data + currPos[SR_LONG_PAIR_FILE], sizeof(SR_LocalPair), numPairs, kh_value(pFileHash, khIter).output);
-            }
+        pReadPairTable->pShortPairArray,
 
-            currPos[SR_LONG_PAIR_FILE] += numPairs;
-        }
+        pReadPairTable->pReversedPairArray,
 
-        numPairs = pReadPairTable->pShortPairArray == NULL ? 0 : pReadPairTable->pShortPairArray->chrCount[i];
-        if (numPairs > 0)
-        {
-            fileID = i * SR_NUM_RP_FILE + SR_SHORT_PAIR_FILE;
-            khIter = kh_get(file, pFileHash, fileID);
+        pReadPairTable->pInvertedPairArray
+    };
 
-            if (khIter != kh_end(pFileHash))
-            {
-                kh_value(pFileHash, khIter).numPairs += numPairs;
-                fwrite(pReadPairTable->pShortPairArray->data + currPos[SR_SHORT_PAIR_FILE], sizeof(SR_LocalPair), numPairs, kh_value(pFileHash, khIter).output);
-            }
-
-            currPos[SR_SHORT_PAIR_FILE] += numPairs;
-        }
+    uint64_t currPos[SR_NUM_RP_BLOCK_TYPE] = {0, 0, 0, 0, 0, 0};
 
-        numPairs = pReadPairTable->pReversedPairArray == NULL ? 0 : pReadPairTable->pReversedPairArray->chrCount[i];
-        if (numPairs > 0)
+    for (unsigned int i = 0; i != numChr; ++i)
+    {
+        for (unsigned int j = SR_LONG_PAIR_BLOCK; j <= SR_INVERTED_PAIR_BLOCK; ++j)
         {
-            fileID = i * SR_NUM_RP_FILE + SR_REVERSED_PAIR_FILE;
-            khIter = kh_get(file, pFileHash, fileID);
-
-            if (khIter != kh_end(pFileHash))
+            uint64_t numPairs = pLocalArrays[j] == NULL ? 0 : pLocalArrays[j]->chrCount[i];
+            if (numPairs > 0)
             {
-                kh_value(pFileHash, khIter).numPairs += numPairs;
-                fwrite(pReadPairTable->pReversedPairArray->data + currPos[SR_REVERSED_PAIR_FILE], sizeof(SR_LocalPair), numPairs, kh_value(pFileHash, khIter).output);
+                SR_ReadPairOutFileAppend(pOutFile, i, j, pLocalArrays[j]->data + currPos[j], numPairs);
+                currPos[j] += numPairs;
             }
-
-            currPos[SR_REVERSED_PAIR_FILE] += numPairs;
         }
 
-        numPairs = pReadPairTable->pInvertedPairArray == NULL ? 0 : pReadPairTable->pInvertedPairArray->chrCount[i];
+        uint64_t numPairs = pReadPairTable->pCrossPairArray == NULL ? 0 : pReadPairTable->pCrossPairArray->chrCount[i];
         if (numPairs > 0)
         {
-            fileID = i * SR_NUM_RP_FILE + SR_INVERTED_PAIR_FILE;
-            khIter = kh_get(file, pFileHash, fileID);
-
-            if (khIter != kh_end(pFileHash))
-            {
-                kh_value(pFileHash, khIter).numPairs += numPairs;
-                fwrite(pReadPairTable->pInvertedPairArray->data + currPos[SR_INVERTED_PAIR_FILE], sizeof(SR_LocalPair), numPairs, kh_value(pFileHash, khIter).output);
-            }
-
-            currPos[SR_INVERTED_PAIR_FILE] += numPairs;
-        }
-
-        numPairs = pReadPairTable->pCrossPairArray == NULL ? 0 : pReadPairTable->pCrossPairArray->chrCount[i];
-        if (numPairs > 0)
-        {
-            fileID = i * SR_NUM_RP_FILE + SR_CROSS_PAIR_FILE;
-            khIter = kh_get(file, pFileHash, fileID);
-
-            if (khIter != kh_end(pFileHash))
-            {
-                kh_value(pFileHash, khIter).numPairs += numPairs;
-                fwrite(pReadPairTable->pCrossPairArray->data + currPos[SR_CROSS_PAIR_FILE], sizeof(SR_CrossPair), numPairs, kh_value(pFileHash, khIter).output);
-            }
-
-            currPos[SR_CROSS_PAIR_FILE] += numPairs;
+            SR_ReadPairOutFileAppend(pOutFile, i, SR_CROSS_PAIR_BLOCK, pReadPairTable->pCrossPairArray->data + currPos[SR_CROSS_PAIR_BLOCK], numPairs);
+            currPos[SR_CROSS_PAIR_BLOCK] += numPairs;
         }
 
         numPairs = pReadPairTable->pSpecialPairTable == NULL ? 0 : pReadPairTable->pSpecialPairTable->array.chrCount[i];
         if (numPairs > 0)
         {
-            fileID = i * SR_NUM_RP_FILE + SR_SPEICAL_PAIR_FILE;
-            khIter = kh_get(file, pFileHash, fileID);
-
-            if (khIter != kh_end(pFileHash))
-            {
-                kh_value(pFileHash, khIter).numPairs += numPairs;
-                fwrite(pReadPairTable->pSpecialPairTable->array.data + currPos[SR_SPEICAL_PAIR_FILE], sizeof(SR_SpecialPair), numPairs, kh_value(pFileHash, khIter).output);
-            }
-
-            currPos[SR_SPEICAL_PAIR_FILE] += numPairs;
+            SR_ReadPairOutFileAppend(pOutFile, i, SR_SPECIAL_PAIR_BLOCK, pReadPairTable->pSpecialPairTable->array.data + currPos[SR_SPECIAL_PAIR_BLOCK], numPairs);
+            currPos[SR_SPECIAL_PAIR_BLOCK] += numPairs;
         }
     }
 
     // take care of those special pairs whose anchor refID is not the same as its mate's refID.
     const SR_SpecialPairArray* pSpecialPairArray = &(pReadPairTable->pSpecialPairTable->crossArray);
     for (unsigned int i = 0; i != pSpecialPairArray->size; ++i)
-    {
-        fileID = pSpecialPairArray->data[i].refID[0] * SR_NUM_RP_FILE + SR_SPEICAL_PAIR_FILE;
-        khIter = kh_get(file, pFileHash, fileID);
-
-        if (khIter != kh_end(pFileHash))
-        {
-            kh_value(pFileHash, khIter).numPairs += 1;
-            fwrite(pSpecialPairArray->data + i, sizeof(SR_SpecialPair), 1, kh_value(pFileHash, khIter).output);
-        }
-    }
+        SR_ReadPairOutFileAppend(pOutFile, pSpecialPairArray->data[i].refID[0], SR_SPECIAL_PAIR_BLOCK, pSpecialPairArray->data + i, 1);
 }
 
 void SR_ReadPairTableWriteDetectSet(const SR_ReadPairTable* pReadPairTable, FILE* libOutput)
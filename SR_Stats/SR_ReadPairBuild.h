@@ -20,6 +20,7 @@
 #define  SR_READPAIRBUILD_H
 
 #include "SR_LibInfo.h"
+#include "SR_ReadPairFile.h"
 
 
 //===============================
@@ -39,6 +40,20 @@ typedef struct
 
     unsigned char minMQ;     // minimum mapping quality for a read pair
 
+    unsigned int numThreads; // number of threads scanning the chromosomes of a bam file through its index (0 or 1 for a single stream)
+
+    uint64_t memLimit;       // memory budget in bytes for the memory pools of the bam in streams ("--mem-limit", 0 for no limit).
+                             // it is not a limit of the whole process (see "SR_MemPlanAlloc")
+
+    SR_Bool singlePass;      // read each bam file once and classify the summaries of the possibly abnormal pairs kept by the first pass.
+                             // the proper pairs shorter than the bin length are not kept, even those outside the final cutoffs
+
+    uint32_t maxHistFragLen; // fragment lengths below it are counted in dense arrays of the histograms, the rest in a hash table (0 for the default)
+
+    double sampleTol;        // relative change of the fragment length cutoffs below which the sampling of the first pass through the bam index stops (0 for a full scan)
+
+    SR_Bool useHistCache;    // reuse the fragment length histograms cached next to each bam file by an earlier run (and save them if there are none)
+
     FILE* fileListInput;     // input stream of a file list containing all the bam file names
 
     char* workingDir;        // working directory for the detector
@@ -253,41 +268,57 @@ void SR_ReadPairTableClear(SR_ReadPairTable* pReadPairTable);
 void SR_ReadPairTableUpdate(SR_ReadPairTable* pReadPairTable, const bam1_t* pUpAlgn, const bam1_t* pDownAlgn, const SR_ZAtag* pZAtag,
                             const SR_PairStats* pPairStats, const SR_LibInfoTable* pLibTable, const SR_FragLenHistArray* pHistArray, uint8_t minMQ);
 
-//================================================================
+//=================================================================
 // function:
-//      open a seriers read pair files for output. A read pair
-//      file will be open for each read pair type on each 
-//      chromosome
+//      merge the read pair tables built by the scanning threads
 //
 // args:
-//      1. pLibTable: a pointer to the library information table
-//      2. detectSet: a bit set indicating which SV event shoud
-//                    be detected
-//      3. workingDir: the working directory for the detector
+//      1. pDstTable: a pointer to the read pair table receiving
+//                    the read pairs
+//      2. ppSrcTables: read pair tables of the threads
+//      3. numSrc: number of the source tables
 //
-// return:
-//      a pointer ot a hash table of read pair files
-//================================================================
-void* SR_ReadPairFilesOpen(const SR_LibInfoTable* pLibTable, uint32_t detectSet, const char* workingDir);
+// discussion:
+//      each chromosome must be scanned by only one thread and
+//      each thread must scan its chromosomes in increasing order.
+//      the read pairs are appended chromosome by chromosome so
+//      the result does not depend on which thread scanned which
+//      chromosome. special reference IDs are renumbered in the
+//      destination table. the source tables are not cleared
+//=================================================================
+void SR_ReadPairTableMerge(SR_ReadPairTable* pDstTable, SR_ReadPairTable* const* ppSrcTables, unsigned int numSrc);
 
-//==================================================================
+//================================================================
 // function:
-//      close all the read pair files
+//      open the container of the read pairs in the working
+//      directory
 //
 // args:
-//      1. pFileHash: a pointer to a hash table of read pair files
-//==================================================================
-void SR_ReadPairFilesClose(void* pFileHash);
+//      1. detectSet: a bit set indicating which SV event shoud
+//                    be detected
+//      2. workingDir: the working directory for the detector
+//
+// return:
+//      a pointer to the read pair container opened for output.
+//      only the read pair types of the SV events to detect are
+//      written into it
+//================================================================
+SR_ReadPairOutFile* SR_ReadPairFileOpen(uint32_t detectSet, const char* workingDir);
 
 //=================================================================
 // function:
-//      write the read pair table into the read pair files
+//      write the read pair table into the read pair container
 //
 // args:
 //      1. pReadPairTable: a pointer to a read pair table
-//      2. pFileHash: a pointer to a hash table of read pair files
+//      2. pOutFile: a pointer to the read pair container
+//
+// discussion:
+//      the pairs of each chromosome and type are appended to
+//      the container. "SR_ReadPairOutFileClose" should be
+//      called after the last bam file to write the index
 //=================================================================
-void SR_ReadPairTableWrite(const SR_ReadPairTable* pReadPairTable, void* pFileHash);
+void SR_ReadPairTableWrite(const SR_ReadPairTable* pReadPairTable, SR_ReadPairOutFile* pOutFile);
 
 void SR_ReadPairTableWriteDetectSet(const SR_ReadPairTable* pReadPairTable, FILE* libOutput);
 
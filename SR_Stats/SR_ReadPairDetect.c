@@ -21,29 +21,13 @@
 #include "khash.h"
 #include "SR_Error.h"
 #include "SR_Utilities.h"
+#include "SR_ReadPairFile.h"
 #include "SR_ReadPairDetect.h"
 
 static const char* SR_LibTableFileName = "lib_table.dat";
 
 // static const char* SR_HistFileName = "hist.dat";
 
-/*  
-static const char* SR_READ_PAIR_FILE_NAME_TEMPLATE[] = 
-{
-    "refXXX_long_pairs.dat",
-
-    "refXXX_short_pairs.dat",
-
-    "refXXX_reversed_pairs.dat",
-
-    "refXXX_inverted_pairs.dat",
-
-    "refXXX_cross_pairs.dat",
-
-    "refXXX_special_pairs.dat",
-};
-*/
-
 KHASH_MAP_INIT_STR(name, uint32_t);
 
 static void SR_DelEventMerge(SR_DelArray* pDelArray, SR_Cluster* pDelCluster)
@@ -134,46 +118,34 @@ void SR_ReadPairDetect(const SR_ReadPairDetectPars* pDetectPars)
 }
 
 
-void SR_LocalPairArrayRead(SR_LocalPairArray* pLocalPairArray, FILE* input)
+void SR_LocalPairArrayRead(SR_LocalPairArray* pLocalPairArray, SR_ReadPairInFile* pInFile, int32_t refID, int pairType)
 {
-    int64_t size = 0;
-    fread(&(size), sizeof(int64_t), 1, input);
+    uint64_t size = SR_ReadPairInFileCount(pInFile, refID, pairType);
 
     if (size > pLocalPairArray->capacity)
         SR_ARRAY_RESIZE_NO_COPY(pLocalPairArray, size, SR_LocalPair);
-    else if (size <= 0)
-        return;
 
-    pLocalPairArray->size = size;
-    fread(pLocalPairArray->data, sizeof(SR_LocalPair), size, input);
+    pLocalPairArray->size = SR_ReadPairInFileRead(pLocalPairArray->data, pInFile, refID, pairType);
 }
 
-void SR_CrossPairArrayRead(SR_CrossPairArray* pCrossPairArray, FILE* input)
+void SR_CrossPairArrayRead(SR_CrossPairArray* pCrossPairArray, SR_ReadPairInFile* pInFile, int32_t refID)
 {
-    int64_t size = 0;
-    fread(&(size), sizeof(int64_t), 1, input);
+    uint64_t size = SR_ReadPairInFileCount(pInFile, refID, SR_CROSS_PAIR_BLOCK);
 
     if (size > pCrossPairArray->capacity)
         SR_ARRAY_RESIZE_NO_COPY(pCrossPairArray, size, SR_CrossPair);
-    else if (size <= 0)
-        return;
 
-    pCrossPairArray->size = size;
-    fread(pCrossPairArray->data, sizeof(SR_LocalPair), size, input);
+    pCrossPairArray->size = SR_ReadPairInFileRead(pCrossPairArray->data, pInFile, refID, SR_CROSS_PAIR_BLOCK);
 }
 
-void SR_SpecialPairArrayRead(SR_SpecialPairArray* pSpecialPairArray, FILE* input)
+void SR_SpecialPairArrayRead(SR_SpecialPairArray* pSpecialPairArray, SR_ReadPairInFile* pInFile, int32_t refID)
 {
-    int64_t size = 0;
-    fread(&(size), sizeof(int64_t), 1, input);
+    uint64_t size = SR_ReadPairInFileCount(pInFile, refID, SR_SPECIAL_PAIR_BLOCK);
 
     if (size > pSpecialPairArray->capacity)
         SR_ARRAY_RESIZE_NO_COPY(pSpecialPairArray, size, SR_SpecialPair);
-    else if (size <= 0)
-        return;
 
-    pSpecialPairArray->size = size;
-    fread(pSpecialPairArray->data, sizeof(SR_LocalPair), size, input);
+    pSpecialPairArray->size = SR_ReadPairInFileRead(pSpecialPairArray->data, pInFile, refID, SR_SPECIAL_PAIR_BLOCK);
 }
 
 void SR_SpecialPairTableReadID(SR_SpecialPairTable* pSpeicalPairTable, FILE* libInput)
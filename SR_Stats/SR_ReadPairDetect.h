@@ -87,11 +87,17 @@ void SV_AssistArrayFree(SV_AssistArray* pAssistArray);
 
 void SR_ReadPairDetect(const SR_ReadPairDetectPars* pDetectPars);
 
-void SR_LocalPairArrayRead(SR_LocalPairArray* pLongPairArray, FILE* input);
+//==============================================================
+// function:
+//      read the pairs of a chromosome from the read pair
+//      container (SR_LONG_PAIR_BLOCK to SR_INVERTED_PAIR_BLOCK
+//      for the local pairs)
+//==============================================================
+void SR_LocalPairArrayRead(SR_LocalPairArray* pLongPairArray, SR_ReadPairInFile* pInFile, int32_t refID, int pairType);
 
-void SR_CrossPairArrayRead(SR_CrossPairArray* pCrossPairArray, FILE* input);
+void SR_CrossPairArrayRead(SR_CrossPairArray* pCrossPairArray, SR_ReadPairInFile* pInFile, int32_t refID);
 
-void SR_SpecialPairArrayRead(SR_SpecialPairArray* pSpecialPairArray, FILE* input);
+void SR_SpecialPairArrayRead(SR_SpecialPairArray* pSpecialPairArray, SR_ReadPairInFile* pInFile, int32_t refID);
 
 void SR_SpecialPairTableReadID(SR_SpecialPairTable* pSpeicalPairTable, FILE* libInput);
 
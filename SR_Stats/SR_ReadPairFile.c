@@ -0,0 +1,384 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_ReadPairFile.c
+ *
+ *    Description:  container file of the read pairs of all the chromosomes
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 08:00:27 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SR_Error.h"
+#include "SR_Utilities.h"
+#include "SR_ReadPairBuild.h"
+#include "SR_ReadPairFile.h"
+
+// the first bytes of a container (also the last ones). bump the version when the layout changes
+static const char SR_ReadPairFileMagic[8] = {'S', 'R', 'R', 'P', 'C', 'T', '0', '1'};
+
+// size of a pair of each type
+static const uint32_t SR_ReadPairSizes[SR_NUM_RP_BLOCK_TYPE] =
+{
+    sizeof(SR_LocalPair),
+
+    sizeof(SR_LocalPair),
+
+    sizeof(SR_LocalPair),
+
+    sizeof(SR_LocalPair),
+
+    sizeof(SR_CrossPair),
+
+    sizeof(SR_SpecialPair)
+};
+
+// a container starts with the magic and the pair sizes. the blocks follow, each
+// with a header tagging its pairs. the index of the blocks and a trailer pointing
+// to it are written at the end
+typedef struct SR_ReadPairFileHeader
+{
+    char magic[8];
+
+    uint32_t pairSizes[SR_NUM_RP_BLOCK_TYPE];
+
+}SR_ReadPairFileHeader;
+
+typedef struct SR_ReadPairBlockHeader
+{
+    int32_t refID;
+
+    int32_t pairType;
+
+    uint64_t numPairs;
+
+}SR_ReadPairBlockHeader;
+
+typedef struct SR_ReadPairFileTrailer
+{
+    int64_t indexPos;
+
+    uint64_t numBlocks;
+
+    char magic[8];
+
+}SR_ReadPairFileTrailer;
+
+
+//===================
+// Static functions
+//===================
+
+static void SR_ReadPairOutFileWrite(SR_ReadPairOutFile* pOutFile, int32_t refID, int pairType, const void* pPairs, uint64_t numPairs)
+{
+    SR_ReadPairBlockHeader header = {refID, pairType, numPairs};
+    uint64_t numBytes = numPairs * SR_ReadPairSizes[pairType];
+
+    if (fwrite(&header, sizeof(SR_ReadPairBlockHeader), 1, pOutFile->output) != 1
+        || fwrite(pPairs, 1, numBytes, pOutFile->output) != numBytes)
+    {
+        SR_ErrSys("ERROR: Cannot write the read pairs into the container.\n");
+    }
+
+    SR_ReadPairBlockIndex index = {refID, pairType, pOutFile->filePos + sizeof(SR_ReadPairBlockHeader), numPairs};
+    SR_ARRAY_PUSH(&(pOutFile->blocks), &index, SR_ReadPairBlockIndex);
+
+    pOutFile->filePos += sizeof(SR_ReadPairBlockHeader) + numBytes;
+}
+
+static void SR_ReadPairOutFileFlush(SR_ReadPairOutFile* pOutFile, int32_t refID, int pairType)
+{
+    SR_ReadPairStage* pStage = pOutFile->pStages + refID * SR_NUM_RP_BLOCK_TYPE + pairType;
+    if (pStage->size == 0)
+        return;
+
+    SR_ReadPairOutFileWrite(pOutFile, refID, pairType, pStage->data, pStage->size / SR_ReadPairSizes[pairType]);
+
+    pOutFile->numStaged -= pStage->size;
+    pStage->size = 0;
+}
+
+// write the pairs of all the stages. the buffers are released as well since
+// most chromosomes do not come back with as many pairs
+static void SR_ReadPairOutFileFlushAll(SR_ReadPairOutFile* pOutFile)
+{
+    for (uint32_t i = 0; i != pOutFile->numChr; ++i)
+    {
+        for (int j = 0; j != SR_NUM_RP_BLOCK_TYPE; ++j)
+        {
+            SR_ReadPairStage* pStage = pOutFile->pStages + i * SR_NUM_RP_BLOCK_TYPE + j;
+
+            SR_ReadPairOutFileFlush(pOutFile, i, j);
+
+            free(pStage->data);
+            pStage->data = NULL;
+            pStage->capacity = 0;
+        }
+    }
+}
+
+// the chromosomes are usually added one at a time, the stages grow geometrically
+static void SR_ReadPairOutFileAddChr(SR_ReadPairOutFile* pOutFile, uint32_t numChr)
+{
+    if (numChr > pOutFile->capacity)
+    {
+        uint32_t newCapacity = (pOutFile->capacity != 0 ? pOutFile->capacity : 16);
+        while (newCapacity < numChr)
+            newCapacity *= 2;
+
+        SR_ReadPairStage* pStages = (SR_ReadPairStage*) realloc(pOutFile->pStages, (size_t) newCapacity * SR_NUM_RP_BLOCK_TYPE * sizeof(SR_ReadPairStage));
+        if (pStages == NULL)
+            SR_ErrQuit("ERROR: Not enough memory for the stages of the read pair container.\n");
+
+        memset(pStages + (size_t) pOutFile->capacity * SR_NUM_RP_BLOCK_TYPE, 0, (size_t) (newCapacity - pOutFile->capacity) * SR_NUM_RP_BLOCK_TYPE * sizeof(SR_ReadPairStage));
+
+        pOutFile->pStages = pStages;
+        pOutFile->capacity = newCapacity;
+    }
+
+    pOutFile->numChr = numChr;
+}
+
+static int CompareBlockIndex(const void* pIndex1, const void* pIndex2)
+{
+    const SR_ReadPairBlockIndex* pI1 = pIndex1;
+    const SR_ReadPairBlockIndex* pI2 = pIndex2;
+
+    if (pI1->refID != pI2->refID)
+        return (pI1->refID < pI2->refID ? -1 : 1);
+
+    if (pI1->pairType != pI2->pairType)
+        return (pI1->pairType < pI2->pairType ? -1 : 1);
+
+    if (pI1->offset != pI2->offset)
+        return (pI1->offset < pI2->offset ? -1 : 1);
+
+    return 0;
+}
+
+// index of the first block of a chromosome and type (or where it would be)
+static uint64_t SR_ReadPairInFileFind(const SR_ReadPairInFile* pInFile, int32_t refID, int pairType)
+{
+    uint64_t low = 0;
+    uint64_t high = pInFile->blocks.size;
+
+    while (low < high)
+    {
+        uint64_t mid = low + (high - low) / 2;
+        const SR_ReadPairBlockIndex* pIndex = pInFile->blocks.data + mid;
+
+        if (pIndex->refID < refID || (pIndex->refID == refID && pIndex->pairType < pairType))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+SR_ReadPairOutFile* SR_ReadPairOutFileOpen(const char* fileName, uint32_t typeSet)
+{
+    SR_ReadPairOutFile* pOutFile = (SR_ReadPairOutFile*) calloc(1, sizeof(SR_ReadPairOutFile));
+    if (pOutFile == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for a read pair container object.\n");
+
+    pOutFile->output = fopen(fileName, "wb");
+    if (pOutFile->output == NULL)
+        SR_ErrSys("ERROR: Cannot open the read pair container: %s\n", fileName);
+
+    setvbuf(pOutFile->output, NULL, _IOFBF, SR_RP_BLOCK_SIZE);
+
+    SR_ReadPairFileHeader header;
+    memcpy(header.magic, SR_ReadPairFileMagic, sizeof(SR_ReadPairFileMagic));
+    memcpy(header.pairSizes, SR_ReadPairSizes, sizeof(SR_ReadPairSizes));
+
+    if (fwrite(&header, sizeof(SR_ReadPairFileHeader), 1, pOutFile->output) != 1)
+        SR_ErrSys("ERROR: Cannot write the read pair container: %s\n", fileName);
+
+    pOutFile->filePos = sizeof(SR_ReadPairFileHeader);
+    pOutFile->typeSet = typeSet;
+
+    SR_ARRAY_INIT(&(pOutFile->blocks), 256, SR_ReadPairBlockIndex);
+
+    return pOutFile;
+}
+
+void SR_ReadPairOutFileClose(SR_ReadPairOutFile* pOutFile)
+{
+    if (pOutFile == NULL)
+        return;
+
+    SR_ReadPairOutFileFlushAll(pOutFile);
+
+    // the blocks of a chromosome and type are kept in the order they were written
+    qsort(pOutFile->blocks.data, pOutFile->blocks.size, sizeof(SR_ReadPairBlockIndex), CompareBlockIndex);
+
+    SR_ReadPairFileTrailer trailer;
+    trailer.indexPos = pOutFile->filePos;
+    trailer.numBlocks = pOutFile->blocks.size;
+    memcpy(trailer.magic, SR_ReadPairFileMagic, sizeof(SR_ReadPairFileMagic));
+
+    if (fwrite(pOutFile->blocks.data, sizeof(SR_ReadPairBlockIndex), pOutFile->blocks.size, pOutFile->output) != pOutFile->blocks.size
+        || fwrite(&trailer, sizeof(SR_ReadPairFileTrailer), 1, pOutFile->output) != 1
+        || fclose(pOutFile->output) != 0)
+    {
+        SR_ErrSys("ERROR: Cannot write the index of the read pair container.\n");
+    }
+
+    free(pOutFile->pStages);
+    free(pOutFile->blocks.data);
+    free(pOutFile);
+}
+
+SR_ReadPairInFile* SR_ReadPairInFileOpen(const char* fileName)
+{
+    FILE* input = fopen(fileName, "rb");
+    if (input == NULL)
+        return NULL;
+
+    SR_ReadPairFileHeader header;
+    if (fread(&header, sizeof(SR_ReadPairFileHeader), 1, input) != 1
+        || memcmp(header.magic, SR_ReadPairFileMagic, sizeof(SR_ReadPairFileMagic)) != 0)
+    {
+        SR_ErrQuit("ERROR: \"%s\" is not a read pair container.\n", fileName);
+    }
+
+    if (memcmp(header.pairSizes, SR_ReadPairSizes, sizeof(SR_ReadPairSizes)) != 0)
+        SR_ErrQuit("ERROR: The read pair container \"%s\" was written by an incompatible build.\n", fileName);
+
+    SR_ReadPairFileTrailer trailer;
+    if (fseeko(input, -((off_t) sizeof(SR_ReadPairFileTrailer)), SEEK_END) != 0
+        || fread(&trailer, sizeof(SR_ReadPairFileTrailer), 1, input) != 1
+        || memcmp(trailer.magic, SR_ReadPairFileMagic, sizeof(SR_ReadPairFileMagic)) != 0)
+    {
+        SR_ErrQuit("ERROR: The read pair container \"%s\" is truncated.\n", fileName);
+    }
+
+    SR_ReadPairInFile* pInFile = (SR_ReadPairInFile*) calloc(1, sizeof(SR_ReadPairInFile));
+    if (pInFile == NULL)
+        SR_ErrQuit("ERROR: Not enough memory for a read pair container object.\n");
+
+    pInFile->input = input;
+    SR_ARRAY_INIT(&(pInFile->blocks), trailer.numBlocks + 1, SR_ReadPairBlockIndex);
+
+    if (fseeko(input, trailer.indexPos, SEEK_SET) != 0
+        || fread(pInFile->blocks.data, sizeof(SR_ReadPairBlockIndex), trailer.numBlocks, input) != trailer.numBlocks)
+    {
+        SR_ErrQuit("ERROR: Cannot read the index of the read pair container \"%s\".\n", fileName);
+    }
+
+    pInFile->blocks.size = trailer.numBlocks;
+
+    return pInFile;
+}
+
+void SR_ReadPairInFileClose(SR_ReadPairInFile* pInFile)
+{
+    if (pInFile != NULL)
+    {
+        fclose(pInFile->input);
+        free(pInFile->blocks.data);
+
+        free(pInFile);
+    }
+}
+
+
+//======================
+// Interface functions
+//======================
+
+void SR_ReadPairOutFileAppend(SR_ReadPairOutFile* pOutFile, int32_t refID, int pairType, const void* pPairs, uint64_t numPairs)
+{
+    if (numPairs == 0 || refID < 0 || (pOutFile->typeSet & (1 << pairType)) == 0)
+        return;
+
+    if ((uint32_t) refID >= pOutFile->numChr)
+        SR_ReadPairOutFileAddChr(pOutFile, refID + 1);
+
+    SR_ReadPairStage* pStage = pOutFile->pStages + refID * SR_NUM_RP_BLOCK_TYPE + pairType;
+    uint64_t numBytes = numPairs * SR_ReadPairSizes[pairType];
+
+    // a large append is a block on its own. the staged pairs go first to keep the order
+    if (numBytes >= SR_RP_BLOCK_SIZE)
+    {
+        SR_ReadPairOutFileFlush(pOutFile, refID, pairType);
+        SR_ReadPairOutFileWrite(pOutFile, refID, pairType, pPairs, numPairs);
+
+        return;
+    }
+
+    if (pStage->size + numBytes > pStage->capacity)
+    {
+        uint64_t newCapacity = 2 * (pStage->size + numBytes);
+        char* newData = (char*) realloc(pStage->data, newCapacity);
+        if (newData == NULL)
+            SR_ErrQuit("ERROR: Not enough memory for the stages of the read pair container.\n");
+
+        pStage->data = newData;
+        pStage->capacity = newCapacity;
+    }
+
+    memcpy(pStage->data + pStage->size, pPairs, numBytes);
+    pStage->size += numBytes;
+    pOutFile->numStaged += numBytes;
+
+    if (pStage->size >= SR_RP_BLOCK_SIZE)
+        SR_ReadPairOutFileFlush(pOutFile, refID, pairType);
+    else if (pOutFile->numStaged >= SR_RP_MAX_STAGED)
+        SR_ReadPairOutFileFlushAll(pOutFile);
+}
+
+uint64_t SR_ReadPairInFileCount(const SR_ReadPairInFile* pInFile, int32_t refID, int pairType)
+{
+    uint64_t numPairs = 0;
+    for (uint64_t i = SR_ReadPairInFileFind(pInFile, refID, pairType); i < pInFile->blocks.size; ++i)
+    {
+        const SR_ReadPairBlockIndex* pIndex = pInFile->blocks.data + i;
+        if (pIndex->refID != refID || pIndex->pairType != pairType)
+            break;
+
+        numPairs += pIndex->numPairs;
+    }
+
+    return numPairs;
+}
+
+uint64_t SR_ReadPairInFileRead(void* pPairs, SR_ReadPairInFile* pInFile, int32_t refID, int pairType)
+{
+    uint32_t pairSize = SR_ReadPairSizes[pairType];
+    char* pDst = (char*) pPairs;
+
+    uint64_t numPairs = 0;
+    for (uint64_t i = SR_ReadPairInFileFind(pInFile, refID, pairType); i < pInFile->blocks.size; ++i)
+    {
+        const SR_ReadPairBlockIndex* pIndex = pInFile->blocks.data + i;
+        if (pIndex->refID != refID || pIndex->pairType != pairType)
+            break;
+
+        if (fseeko(pInFile->input, pIndex->offset, SEEK_SET) != 0
+            || fread(pDst + numPairs * pairSize, pairSize, pIndex->numPairs, pInFile->input) != pIndex->numPairs)
+        {
+            SR_ErrQuit("ERROR: The read pair container is truncated.\n");
+        }
+
+        numPairs += pIndex->numPairs;
+    }
+
+    return numPairs;
+}
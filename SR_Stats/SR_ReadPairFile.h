@@ -0,0 +1,230 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  SR_ReadPairFile.h
+ *
+ *    Description:  container file of the read pairs of all the chromosomes
+ *
+ *        Version:  1.0
+ *        Created:  10/19/2026 08:00:27 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  agent (agent@local), 
+ *        Company:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SR_READPAIRFILE_H
+#define  SR_READPAIRFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+//===============================
+// Type and constant definition
+//===============================
+
+// name of the container in the working directory
+#define SR_READ_PAIR_FILE_NAME "read_pairs.dat"
+
+// number of read pair types in the container
+#define SR_NUM_RP_BLOCK_TYPE 6
+
+// read pair types. each block of the container holds the pairs of one type on one chromosome
+enum
+{
+    SR_LONG_PAIR_BLOCK = 0,
+
+    SR_SHORT_PAIR_BLOCK = 1,
+
+    SR_REVERSED_PAIR_BLOCK = 2,
+
+    SR_INVERTED_PAIR_BLOCK = 3,
+
+    SR_CROSS_PAIR_BLOCK = 4,
+
+    SR_SPECIAL_PAIR_BLOCK = 5
+};
+
+// the pairs of a chromosome and type are staged in memory until they fill a block this large
+#define SR_RP_BLOCK_SIZE (1 << 20)
+
+// the staged pairs of all the chromosomes are written out once they take this many bytes
+#define SR_RP_MAX_STAGED (64 << 20)
+
+// entry of the index at the end of the container
+typedef struct SR_ReadPairBlockIndex
+{
+    int32_t refID;               // reference ID of the pairs in the block
+
+    int32_t pairType;            // read pair type of the block
+
+    int64_t offset;              // offset of the first pair of the block in the container
+
+    uint64_t numPairs;           // number of pairs in the block
+
+}SR_ReadPairBlockIndex;
+
+typedef struct SR_ReadPairBlockArray
+{
+    SR_ReadPairBlockIndex* data;
+
+    uint64_t size;
+
+    uint64_t capacity;
+
+}SR_ReadPairBlockArray;
+
+// pairs of a chromosome and type waiting to be written as a block
+typedef struct SR_ReadPairStage
+{
+    char* data;
+
+    uint64_t size;               // number of bytes staged
+
+    uint64_t capacity;
+
+}SR_ReadPairStage;
+
+// the container opened for output
+typedef struct SR_ReadPairOutFile
+{
+    FILE* output;                // output stream of the container
+
+    int64_t filePos;             // offset of the next block
+
+    uint32_t typeSet;            // bit set of the read pair types written into the container
+
+    uint32_t numChr;             // number of chromosomes with stages
+
+    uint32_t capacity;           // number of chromosomes the stages are allocated for
+
+    SR_ReadPairStage* pStages;   // stages of each chromosome and type (capacity * SR_NUM_RP_BLOCK_TYPE)
+
+    uint64_t numStaged;          // number of bytes staged on all the chromosomes
+
+    SR_ReadPairBlockArray blocks; // index of the blocks written so far
+
+}SR_ReadPairOutFile;
+
+// the container opened for input
+typedef struct SR_ReadPairInFile
+{
+    FILE* input;                 // input stream of the container
+
+    SR_ReadPairBlockArray blocks; // index of the blocks sorted by reference ID, type and offset
+
+}SR_ReadPairInFile;
+
+
+//===============================
+// Constructors and Destructors
+//===============================
+
+//==============================================================
+// function:
+//      create the container of the read pairs
+//
+// args:
+//      1. fileName: name of the container
+//      2. typeSet : bit set of the read pair types to write,
+//                   the pairs of other types are dropped
+//
+// return:
+//      a pointer to the container opened for output
+//==============================================================
+SR_ReadPairOutFile* SR_ReadPairOutFileOpen(const char* fileName, uint32_t typeSet);
+
+//==============================================================
+// function:
+//      write the staged pairs and the index, and close the
+//      container
+//
+// args:
+//      1. pOutFile: a pointer to the container opened for
+//                   output
+//==============================================================
+void SR_ReadPairOutFileClose(SR_ReadPairOutFile* pOutFile);
+
+//==============================================================
+// function:
+//      open the container of the read pairs
+//
+// args:
+//      1. fileName: name of the container
+//
+// return:
+//      a pointer to the container opened for input; NULL if
+//      the file cannot be opened. a file that is not a complete
+//      container of this build is a fatal error
+//==============================================================
+SR_ReadPairInFile* SR_ReadPairInFileOpen(const char* fileName);
+
+void SR_ReadPairInFileClose(SR_ReadPairInFile* pInFile);
+
+
+//======================
+// Interface functions
+//======================
+
+//==============================================================
+// function:
+//      append the pairs of a chromosome and type to the
+//      container
+//
+// args:
+//      1. pOutFile: a pointer to the container opened for
+//                   output
+//      2. refID   : reference ID of the pairs
+//      3. pairType: read pair type of the pairs
+//      4. pPairs  : the pairs (SR_LocalPair, SR_CrossPair or
+//                   SR_SpecialPair, following the type)
+//      5. numPairs: number of pairs
+//
+// discussion:
+//      the pairs of a chromosome and type are read back in the
+//      order they are appended. small appends are staged and
+//      written together, large ones go to the file directly
+//==============================================================
+void SR_ReadPairOutFileAppend(SR_ReadPairOutFile* pOutFile, int32_t refID, int pairType, const void* pPairs, uint64_t numPairs);
+
+//==============================================================
+// function:
+//      get the number of pairs of a chromosome and type in the
+//      container
+//
+// args:
+//      1. pInFile : a pointer to the container opened for input
+//      2. refID   : reference ID of the pairs
+//      3. pairType: read pair type of the pairs
+//
+// return:
+//      the number of pairs
+//==============================================================
+uint64_t SR_ReadPairInFileCount(const SR_ReadPairInFile* pInFile, int32_t refID, int pairType);
+
+//==============================================================
+// function:
+//      read all the pairs of a chromosome and type from the
+//      container
+//
+// args:
+//      1. pPairs  : buffer of the pairs, it should hold the
+//                   number of pairs given by
+//                   "SR_ReadPairInFileCount"
+//      2. pInFile : a pointer to the container opened for input
+//      3. refID   : reference ID of the pairs
+//      4. pairType: read pair type of the pairs
+//
+// return:
+//      the number of pairs read
+//
+// discussion:
+//      the blocks are found through the index and read in the
+//      order of their offsets, one read per block
+//==============================================================
+uint64_t SR_ReadPairInFileRead(void* pPairs, SR_ReadPairInFile* pInFile, int32_t refID, int pairType);
+
+#endif  /*SR_READPAIRFILE_H*/